@@ -38,15 +38,52 @@
 // ============================================================================
 #define EXT2FS_VERSION "4.0"
 #define DISK_IMAGE "disk.img"           // 虚拟磁盘文件名
-#define BLOCK_SIZE 512                  // 数据块大小
-#define INODE_SIZE 64                   // inode结构大小
+#define INODE_SIZE 128                  // 磁盘inode大小
+#define INODE_VERSION 3                 // 磁盘inode格式版本
 #define MAX_FILENAME 28                 // 最大文件名长度
 #define MAX_USERNAME 20                 // 最大用户名长度
 #define MAX_PASSWORD 20                 // 最大密码长度
-#define MAX_INODES 128                  // 最大inode数量
-#define MAX_BLOCKS 1024                 // 最大数据块数量
 #define MAX_USERS 16                    // 最大用户数量
 #define MAX_DIRECT_BLOCKS 8             // 最大直接数据块数
+#define INDIRECT_BLOCK 8                // 一级间接块在data_blocks中的位置
+#define DOUBLE_INDIRECT_BLOCK 9         // 二级间接块在data_blocks中的位置
+#define TRIPLE_INDIRECT_BLOCK 10        // 三级间接块在data_blocks中的位置
+#define INODE_BLOCK_POINTERS 11         // inode中的块指针总数
+
+// inode标志 (flags字段)
+#define INODE_FLAG_EXTENTS 0x01         // data_blocks中保存extent树而不是块指针
+#define INODE_FLAG_INLINE 0x02          // 文件数据直接保存在data_blocks中，不占用数据块
+#define INODE_FLAG_FRAGMENT 0x04        // 文件数据打包在共享的碎片块中，data_blocks记录块编号和槽位
+#define INODE_INLINE_SIZE (INODE_BLOCK_POINTERS * 4) // 内联数据的最大字节数 (data_blocks的大小)
+
+// extent树
+#define EXTENT_MAGIC 0xF30A             // extent树节点魔数
+#define EXTENT_MAX_DEPTH 5              // extent树最大高度
+
+// 格式化参数 (挂载选项blocks=、inodes=、block_size=，只在新建镜像时生效)
+#define DEFAULT_BLOCK_SIZE 512          // 默认数据块大小
+#define DEFAULT_BLOCKS 1024             // 默认数据块数量
+#define DEFAULT_INODES 128              // 默认inode数量
+#define MIN_BLOCK_SIZE 512              // 最小数据块大小
+#define MAX_BLOCK_SIZE 65536            // 最大数据块大小 (块大小须为2的幂)
+#define RESIZE_MAX_GROWTH 1024          // 新建镜像为在线扩容预留的倍数 (块组描述符表按此倍数的组数预留)
+
+// 磁盘布局版本 (超级块layout字段)
+#define EXT2FS_LAYOUT_PACKED 0          // 各区域按字节紧密排列
+#define EXT2FS_LAYOUT_ALIGNED 1         // 各区域起点按块大小与4 KiB中较大者对齐 (新建镜像使用)
+#define EXT2FS_LAYOUT_ALIGN 4096        // 对齐布局的最小对齐粒度 (主机页大小)
+
+// 格式版本和功能标志 (超级块format_version和feature_*字段)
+// 不认识的不兼容功能拒绝挂载，不认识的只读兼容功能也拒绝挂载 (不支持只读挂载)，兼容功能可以忽略
+#define EXT2FS_FORMAT_VERSION 1         // 当前格式版本 (0为没有功能标志字段的旧版超级块)
+#define EXT2FS_FEATURE_INCOMPAT_EXTENTS 0x0001     // inode可以用extent树映射数据块
+#define EXT2FS_FEATURE_INCOMPAT_INLINE_DATA 0x0002 // 小文件数据可以内联保存在inode中
+#define EXT2FS_FEATURE_INCOMPAT_FRAGMENTS 0x0004   // 小文件可以打包存放在共享的碎片块中
+#define EXT2FS_FEATURE_COMPAT_SUPP 0    // 本程序认识的兼容功能
+#define EXT2FS_FEATURE_INCOMPAT_SUPP (EXT2FS_FEATURE_INCOMPAT_EXTENTS | \
+                                      EXT2FS_FEATURE_INCOMPAT_INLINE_DATA | \
+                                      EXT2FS_FEATURE_INCOMPAT_FRAGMENTS)
+#define EXT2FS_FEATURE_RO_COMPAT_SUPP 0 // 本程序认识的只读兼容功能
 
 // 特殊inode编号
 #define ROOT_INODE 0                    // 根目录inode编号
@@ -68,34 +105,82 @@ typedef struct {
     uint32_t free_inodes;               // 空闲inode数
     uint32_t block_size;                // 数据块大小
     uint32_t inode_size;                // inode大小
-    uint32_t inode_bitmap_offset;       // inode位图偏移
-    uint32_t block_bitmap_offset;       // 数据块位图偏移
-    uint32_t inode_table_offset;        // inode表偏移
-    uint32_t data_blocks_offset;        // 数据块区域偏移
+    uint32_t blocks_per_group;          // 每个块组的数据块数 (8的倍数)
+    uint32_t inodes_per_group;          // 每个块组的inode数 (8的倍数)
+    uint32_t group_count;               // 块组数量
+    uint32_t group_desc_offset;         // 块组描述符表偏移
+    uint32_t layout;                    // 磁盘布局版本 (EXT2FS_LAYOUT_*)
     time_t created;                     // 文件系统创建时间
     time_t last_mount;                  // 最后挂载时间
     uint32_t mount_count;               // 挂载次数
+    uint32_t reserved_groups;           // 块组描述符表预留的项数 (在线扩容的组数上限，0表示不预留)
+    uint32_t format_version;            // 格式版本 (EXT2FS_FORMAT_VERSION)，版本0的镜像中本字段及以下字段为0
+    uint32_t feature_compat;            // 兼容功能 (EXT2FS_FEATURE_COMPAT_*)
+    uint32_t feature_incompat;          // 不兼容功能 (EXT2FS_FEATURE_INCOMPAT_*)
+    uint32_t feature_ro_compat;         // 只读兼容功能 (EXT2FS_FEATURE_RO_COMPAT_*)
 } SuperBlock;
 
+/**
+ * 块组描述符 - 每个块组在磁盘上依次存放数据块位图、inode位图、inode表和数据块
+ */
+typedef struct {
+    uint64_t block_bitmap_offset;       // 本组数据块位图偏移
+    uint64_t inode_bitmap_offset;       // 本组inode位图偏移
+    uint64_t inode_table_offset;        // 本组inode表偏移
+    uint64_t data_blocks_offset;        // 本组数据块区域偏移
+    uint32_t free_blocks;               // 本组空闲数据块数
+    uint32_t free_inodes;               // 本组空闲inode数
+} GroupDesc;
+
 /**
  * 索引节点 - 文件/目录元数据
+ * inode表在磁盘上直接保存此结构: 全部为定宽字段，按自然对齐排列、没有填充，
+ * 大小固定为INODE_SIZE，不随平台的time_t或结构体对齐规则变化
  */
 typedef struct {
     char name[MAX_FILENAME];            // 文件名
-    uint32_t owner_id;                  // 所有者ID
-    char permissions[4];                // 权限字符串 (rwx)
-    uint32_t size;                      // 文件大小
-    uint32_t data_blocks[MAX_DIRECT_BLOCKS]; // 直接数据块索引
+    uint16_t mode;                      // 文件类型和权限位 (S_IFDIR/S_IFREG | 07777)
+    uint8_t version;                    // inode格式版本 (INODE_VERSION)
+    uint8_t flags;                      // 标志 (INODE_FLAG_*)
+    uint32_t uid;                       // 所有者用户ID
+    uint32_t gid;                       // 所有者组ID
+    uint64_t size;                      // 文件大小
     uint32_t block_count;               // 已分配块数
-    time_t created;                     // 创建时间
-    time_t modified;                    // 修改时间
-    time_t accessed;                    // 访问时间
-    uint8_t is_directory;               // 是否为目录
+    uint32_t data_blocks[INODE_BLOCK_POINTERS]; // 直接块索引，其后为一级、二级、三级间接块 (或extent树、内联数据、碎片位置)
     uint32_t parent_inode;              // 父目录inode
     uint32_t link_count;                // 硬链接计数
-    uint32_t reserved[2];               // 保留字段
+    int64_t created;                    // 创建时间 (秒)
+    int64_t modified;                   // 修改时间 (秒)
+    int64_t accessed;                   // 访问时间 (秒)
 } Inode;
 
+/**
+ * extent树节点头 - 位于inode的data_blocks开头或树节点块开头，其后紧跟各项
+ */
+typedef struct {
+    uint16_t magic;                     // EXTENT_MAGIC
+    uint16_t count;                     // 有效项数
+    uint16_t max;                       // 最多可容纳的项数
+    uint16_t depth;                     // 节点高度 (0为叶子节点)
+} ExtentHeader;
+
+/**
+ * extent - 一段逻辑上和磁盘上都连续的数据块 (不跨越块组)
+ * 在索引节点中start为下级节点所在的块，length不使用
+ */
+typedef struct {
+    uint32_t logical;                   // 起始逻辑块索引
+    uint32_t length;                    // 块数
+    uint32_t start;                     // 起始数据块编号
+} Extent;
+
+// 磁盘格式依赖inode的大小，字段变化时在编译期报错
+typedef char inode_size_check[sizeof(Inode) == INODE_SIZE ? 1 : -1];
+typedef char inode_inline_check[sizeof(((Inode *)0)->data_blocks) == INODE_INLINE_SIZE ? 1 : -1];
+
+// 位图占用的字节数
+#define BITMAP_BYTES(bits) (((size_t)(bits) + 7) / 8)
+
 /**
  * 用户信息
  */
@@ -119,19 +204,37 @@ typedef struct {
     char name[];                        // 文件名 (变长)
 } DirEntry;
 
+/**
+ * 挂载选项 (由main.c通过fuse_opt解析 -o 参数填充)
+ */
+typedef struct {
+    char *backend;                      // 磁盘后端名称 (file/mmap/ram/stripe/mirror)
+    int io_uring;                       // 是否启用io_uring异步I/O引擎
+    int odirect;                        // 是否以O_DIRECT打开镜像
+    char *stripe;                       // 条带成员列表 (以':'分隔，设置后使用stripe后端)
+    int stripe_size;                    // 条带大小 (字节)
+    char *mirror;                       // 镜像副本列表 (以':'分隔，设置后使用mirror后端)
+    int elevator;                       // 是否启用写入队列 (排序合并后提交)
+    unsigned int blocks;                // 格式化: 数据块数量 (0表示默认值)
+    unsigned int inodes;                // 格式化: inode数量 (0表示默认值)
+    unsigned int block_size;            // 格式化: 数据块大小 (0表示默认值)
+} MountOptions;
+
 /**
  * 文件系统实例
  */
 typedef struct {
     SuperBlock superblock;              // 超级块
-    char *inode_bitmap;                 // inode位图
-    char *block_bitmap;                 // 数据块位图
-    Inode *inode_table;                 // inode表
+    GroupDesc *groups;                  // 块组描述符表
+    char *inode_bitmap;                 // inode位图 (各组位图按组号依次拼接)
+    char *block_bitmap;                 // 数据块位图 (各组位图按组号依次拼接)
+    Inode *inode_table;                 // inode表 (各组inode表按组号依次拼接)
     User users[MAX_USERS];              // 用户表
     uint32_t user_count;                // 用户数量
     FILE *disk_file;                    // 磁盘文件句柄
     bool is_mounted;                    // 是否已挂载
     bool is_dirty;                      // 是否有未保存的更改
+    MountOptions options;               // 挂载选项
 } FileSystem;
 
 // ============================================================================
@@ -156,6 +259,16 @@ typedef enum {
 // ============================================================================
 extern FileSystem g_fs;                // 全局文件系统实例
 
+// 文件系统几何参数 (格式化时确定，挂载后从超级块读取，在线扩容时只增不减)
+#define FS_BLOCK_SIZE ((int)g_fs.superblock.block_size)
+#define FS_TOTAL_BLOCKS ((int)g_fs.superblock.total_blocks)
+#define FS_TOTAL_INODES ((int)g_fs.superblock.total_inodes)
+#define FS_BLOCKS_PER_GROUP ((int)g_fs.superblock.blocks_per_group)
+#define FS_INODES_PER_GROUP ((int)g_fs.superblock.inodes_per_group)
+#define FS_GROUP_COUNT ((int)g_fs.superblock.group_count)
+#define FS_GROUP_CAPACITY ((int)(g_fs.superblock.reserved_groups > g_fs.superblock.group_count ? \
+                                 g_fs.superblock.reserved_groups : g_fs.superblock.group_count))
+
 // ============================================================================
 // 模块接口声明
 // ============================================================================
@@ -167,14 +280,14 @@ int superblock_save(void);
 void superblock_print_info(void);
 
 // inode管理 (src/fs/inode.h)
-int inode_alloc(void);
+int inode_alloc(int parent_inode, bool is_directory);
 void inode_free(int inode_id);
 int inode_read(int inode_id, Inode *inode);
 int inode_write(int inode_id, const Inode *inode);
 bool inode_is_used(int inode_id);
 
 // 数据块管理 (src/fs/block.h)
-int block_alloc(void);
+int block_alloc(int goal);
 void block_free(int block_id);
 int block_read(int block_id, void *buffer);
 int block_write(int block_id, const void *buffer);
@@ -191,8 +304,8 @@ int dir_list_entries(int dir_inode, void (*callback)(const char *name, int inode
 // 文件操作 (src/fs/file.h)
 int file_create(const char *name, int parent_inode);
 int file_delete(int inode_id);
-int file_read(int inode_id, void *buffer, size_t size, off_t offset);
-int file_write(int inode_id, const void *buffer, size_t size, off_t offset);
+ssize_t file_read(int inode_id, void *buffer, size_t size, off_t offset);
+ssize_t file_write(int inode_id, const void *buffer, size_t size, off_t offset);
 int file_truncate(int inode_id, off_t size);
 int file_rename(int inode_id, const char *new_name);
 
@@ -216,8 +329,6 @@ extern struct fuse_operations fuse_operations;
 // ============================================================================
 // 工具函数
 // ============================================================================
-mode_t perm_to_mode(const char *perms, bool is_dir);
-void mode_to_perm(mode_t mode, char *perms);
 const char *get_username(int uid);
 int resolve_path(const char *path);
 ext2fs_error_t errno_to_ext2fs_error(int errno_val);
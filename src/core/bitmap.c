@@ -8,6 +8,449 @@
 
 #include "bitmap.h"
 #include "disk.h"
+#include "bufpool.h"
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BITMAP_SCAN_X86 1
+#endif
+
+// ============================================================================
+// 按字扫描
+// ============================================================================
+#define BITMAP_WORD_BITS 64             // 扫描时每次处理的位数
+#define BITMAP_FULL_WORD UINT64_MAX     // 全部已使用的字
+
+/**
+ * 扫描实现 - 按CPU支持的指令集在bitmap_init中选择
+ */
+typedef struct {
+    const char *name;                   // 实现名称
+    // 返回从index开始的64个字中哪些不全为1 (第i位对应第index+i个字)，用于重建摘要的最低层
+    uint64_t (*nonfull_words)(const char *bitmap, size_t index);
+    // 统计words个字中为1的位数
+    size_t (*count_used)(const char *bitmap, size_t words);
+} bitmap_scan_t;
+
+/**
+ * 读取位图中的第index个字 (位i在字中的第i%64位，与按字节的编号一致)
+ */
+static inline uint64_t bitmap_load_word(const char *bitmap, size_t index) {
+    uint64_t word;
+    memcpy(&word, bitmap + index * sizeof(word), sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    return word;
+}
+
+/**
+ * 读取位图末尾不足一个字的位，超出max_bits的位视为0
+ */
+static uint64_t bitmap_load_tail(const char *bitmap, int max_bits) {
+    int bits = max_bits % BITMAP_WORD_BITS;
+    const unsigned char *tail = (const unsigned char *)bitmap + (size_t)(max_bits / BITMAP_WORD_BITS) * 8;
+    uint64_t word = 0;
+
+    for (int i = 0; i < (bits + 7) / 8; i++) {
+        word |= (uint64_t)tail[i] << (8 * i);
+    }
+    return bits ? word & ((1ULL << bits) - 1) : 0;
+}
+
+/**
+ * 返回从头开始第一个不全为1的字的编号，都为1返回words
+ */
+static size_t bitmap_skip_full(const char *bitmap, size_t words) {
+    size_t i = 0;
+    while (i < words && bitmap_load_word(bitmap, i) == BITMAP_FULL_WORD) {
+        i++;
+    }
+    return i;
+}
+
+static uint64_t bitmap_nonfull_words_generic(const char *bitmap, size_t index) {
+    uint64_t mask = 0;
+    for (int i = 0; i < 64; i++) {
+        if (bitmap_load_word(bitmap, index + i) != BITMAP_FULL_WORD) {
+            mask |= 1ULL << i;
+        }
+    }
+    return mask;
+}
+
+static size_t bitmap_count_used_generic(const char *bitmap, size_t words) {
+    size_t count = 0;
+    for (size_t i = 0; i < words; i++) {
+        count += __builtin_popcountll(bitmap_load_word(bitmap, i));
+    }
+    return count;
+}
+
+static const bitmap_scan_t bitmap_scan_generic = {
+    "generic", bitmap_nonfull_words_generic, bitmap_count_used_generic
+};
+
+#ifdef BITMAP_SCAN_X86
+/**
+ * SSE2: 每次比较16字节 (两个字)，由字节比较掩码的高低8位判断两个字是否全满
+ */
+__attribute__((target("sse2")))
+static uint64_t bitmap_nonfull_words_sse2(const char *bitmap, size_t index) {
+    const __m128i ones = _mm_set1_epi8(-1);
+    const char *base = bitmap + index * 8;
+    uint64_t full = 0;
+    for (int i = 0; i < 64; i += 2) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(base + i * 8));
+        unsigned m = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, ones));
+        full |= (uint64_t)((m & 0xFF) == 0xFF) << i;
+        full |= (uint64_t)((m >> 8) == 0xFF) << (i + 1);
+    }
+    return ~full;
+}
+
+/**
+ * AVX2: 每次按64位比较4个字，比较结果的符号位直接给出4个字的全满标志
+ */
+__attribute__((target("avx2")))
+static uint64_t bitmap_nonfull_words_avx2(const char *bitmap, size_t index) {
+    const __m256i ones = _mm256_set1_epi8(-1);
+    const char *base = bitmap + index * 8;
+    uint64_t full = 0;
+    for (int i = 0; i < 64; i += 4) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(base + i * 8));
+        __m256d eq = _mm256_castsi256_pd(_mm256_cmpeq_epi64(v, ones));
+        full |= (uint64_t)_mm256_movemask_pd(eq) << i;
+    }
+    return ~full;
+}
+
+/**
+ * 使用popcnt指令统计 (不支持时__builtin_popcountll按查表计算)
+ */
+__attribute__((target("popcnt")))
+static size_t bitmap_count_used_popcnt(const char *bitmap, size_t words) {
+    size_t count = 0;
+    for (size_t i = 0; i < words; i++) {
+        count += __builtin_popcountll(bitmap_load_word(bitmap, i));
+    }
+    return count;
+}
+
+static const bitmap_scan_t bitmap_scan_sse2 = {
+    "sse2", bitmap_nonfull_words_sse2, bitmap_count_used_generic
+};
+static const bitmap_scan_t bitmap_scan_sse2_popcnt = {
+    "sse2+popcnt", bitmap_nonfull_words_sse2, bitmap_count_used_popcnt
+};
+static const bitmap_scan_t bitmap_scan_avx2 = {
+    "avx2+popcnt", bitmap_nonfull_words_avx2, bitmap_count_used_popcnt
+};
+#endif
+
+static const bitmap_scan_t *bitmap_scan = &bitmap_scan_generic;
+
+/**
+ * 按CPU支持的指令集选择扫描实现
+ */
+static void bitmap_select_scan(void) {
+#ifdef BITMAP_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        bitmap_scan = &bitmap_scan_avx2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        bitmap_scan = __builtin_cpu_supports("popcnt") ? &bitmap_scan_sse2_popcnt : &bitmap_scan_sse2;
+    }
+#endif
+}
+
+// ============================================================================
+// 空闲位摘要
+// ============================================================================
+#define BITMAP_SUMMARY_MAX_LEVELS 4     // 摘要最多的层数
+#define BITMAP_SUMMARY_TOP_WORDS 8      // 最上层不超过一个缓存行时不再加层
+
+/**
+ * 空闲位摘要 - 第0层每位对应位图的一个字 (该字还有空闲位时为1)，
+ * 上一层每位对应下一层的一个字 (该字不为0时为1)
+ * 修改只在位图的字在全满与非全满之间切换时发生，由lock串行化；查找不加锁，结果在位图中核实
+ */
+typedef struct {
+    pthread_mutex_t lock;               // 串行化摘要的修改
+    const char *bitmap;                 // 被摘要的位图 (按预留容量)
+    size_t words;                       // 位图的字数
+    size_t size;                        // 摘要占用的字节数
+    int level_count;                    // 层数
+    uint64_t *levels[BITMAP_SUMMARY_MAX_LEVELS]; // 各层位数组
+} bitmap_summary_t;
+
+static bitmap_summary_t bitmap_summaries[2] = {
+    { .lock = PTHREAD_MUTEX_INITIALIZER },  // 数据块位图
+    { .lock = PTHREAD_MUTEX_INITIALIZER },  // inode位图
+};
+
+/**
+ * 查找位图所属的摘要 (bitmap可以指向位图中间，如某个块组的起点)
+ * @param first_bit 输出bitmap指向的位在整个位图中的编号
+ * @return 摘要，不属于已建立摘要的位图返回NULL
+ */
+static bitmap_summary_t *bitmap_summary_of(const char *bitmap, size_t *first_bit) {
+    for (int i = 0; i < 2; i++) {
+        bitmap_summary_t *s = &bitmap_summaries[i];
+        if (s->levels[0] && bitmap >= s->bitmap && bitmap < s->bitmap + s->words * 8) {
+            *first_bit = (size_t)(bitmap - s->bitmap) * 8;
+            return s;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * 测试摘要某层的一位
+ */
+static bool bitmap_summary_test(const bitmap_summary_t *s, int level, size_t index) {
+    return (__atomic_load_n(&s->levels[level][index / 64], __ATOMIC_RELAXED) >> (index % 64)) & 1;
+}
+
+/**
+ * 设置摘要第0层的一位并向上传播 (调用者持有锁)
+ */
+static void bitmap_summary_assign(bitmap_summary_t *s, size_t word, bool has_free) {
+    size_t index = word;
+    for (int level = 0; level < s->level_count; level++) {
+        uint64_t *slot = &s->levels[level][index / 64];
+        uint64_t old = *slot;
+        uint64_t mask = 1ULL << (index % 64);
+        uint64_t value = has_free ? old | mask : old & ~mask;
+        if (value == old) {
+            break;
+        }
+        __atomic_store_n(slot, value, __ATOMIC_RELAXED);
+
+        // 只有字在0与非0之间切换时上一层才需要修改
+        if ((old != 0) == (value != 0)) {
+            break;
+        }
+        has_free = value != 0;
+        index /= 64;
+    }
+}
+
+/**
+ * 按位图的当前内容重新计算一个字的摘要
+ */
+static void bitmap_summary_update(bitmap_summary_t *s, size_t word) {
+    pthread_mutex_lock(&s->lock);
+    bool full;
+    do {
+        full = bitmap_load_word(s->bitmap, word) == BITMAP_FULL_WORD;
+        bitmap_summary_assign(s, word, !full);
+        // 与bitmap_summary_note对称: 写摘要后重读位图，期间被其他组改变的字不会漏记
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    } while ((bitmap_load_word(s->bitmap, word) == BITMAP_FULL_WORD) != full);
+    pthread_mutex_unlock(&s->lock);
+}
+
+/**
+ * 位图的某一位被修改后检查摘要，所在的字在全满与非全满之间切换时更新
+ */
+static void bitmap_summary_note(const char *bitmap, int bit) {
+    size_t first_bit;
+    bitmap_summary_t *s = bitmap_summary_of(bitmap, &first_bit);
+    if (!s) {
+        return;
+    }
+
+    size_t word = (first_bit + bit) / BITMAP_WORD_BITS;
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    bool full = bitmap_load_word(s->bitmap, word) == BITMAP_FULL_WORD;
+    if (bitmap_summary_test(s, 0, word) == full) {
+        bitmap_summary_update(s, word);
+    }
+}
+
+/**
+ * 在摘要某层的[low, high)中查找第一个为1的位，整字为0时由上一层跳过
+ * @return 位编号，没有返回-1
+ */
+static long bitmap_summary_find(const bitmap_summary_t *s, int level, size_t low, size_t high) {
+    size_t index = low;
+    while (index < high) {
+        uint64_t word = __atomic_load_n(&s->levels[level][index / 64], __ATOMIC_RELAXED);
+        word &= ~0ULL << (index % 64);
+        if (word) {
+            size_t found = index / 64 * 64 + __builtin_ctzll(word);
+            return found < high ? (long)found : -1;
+        }
+
+        long next = (long)(index / 64 + 1);
+        if (level + 1 < s->level_count) {
+            next = bitmap_summary_find(s, level + 1, next, (high + 63) / 64);
+            if (next == -1) {
+                return -1;
+            }
+        }
+        index = (size_t)next * 64;
+    }
+    return -1;
+}
+
+/**
+ * 按摘要在位图的[first_bit, end_bit)中查找第一个空闲位
+ * @return 位编号，没有返回-1
+ */
+static long bitmap_summary_find_free(const bitmap_summary_t *s, size_t first_bit, size_t end_bit) {
+    size_t word = first_bit / BITMAP_WORD_BITS;
+    size_t end_word = (end_bit + BITMAP_WORD_BITS - 1) / BITMAP_WORD_BITS;
+
+    while (word < end_word) {
+        long found = bitmap_summary_find(s, 0, word, end_word);
+        if (found == -1) {
+            return -1;
+        }
+
+        // 摘要只是提示: 核实该字确有空闲位 (起始字中低于first_bit的位不算)
+        uint64_t free_bits = ~bitmap_load_word(s->bitmap, found);
+        if ((size_t)found == first_bit / BITMAP_WORD_BITS) {
+            free_bits &= ~0ULL << (first_bit % BITMAP_WORD_BITS);
+        }
+        if (free_bits) {
+            size_t bit = (size_t)found * BITMAP_WORD_BITS + __builtin_ctzll(free_bits);
+            return bit < end_bit ? (long)bit : -1;
+        }
+        word = (size_t)found + 1;
+    }
+    return -1;
+}
+
+/**
+ * 按位图的当前内容重建[first_bit, end_bit)所在各字的摘要
+ */
+static void bitmap_summary_rebuild(bitmap_summary_t *s, size_t first_bit, size_t end_bit) {
+    size_t low = first_bit / BITMAP_WORD_BITS;
+    size_t high = (end_bit + BITMAP_WORD_BITS - 1) / BITMAP_WORD_BITS;
+
+    pthread_mutex_lock(&s->lock);
+    for (int level = 0; level < s->level_count && low < high; level++) {
+        for (size_t i = low; i < high; i++) {
+            // 最低层中整段落在范围内的64个字由扫描实现一次得出整个摘要字
+            if (level == 0 && i % 64 == 0 && i + 64 <= high) {
+                __atomic_store_n(&s->levels[0][i / 64], bitmap_scan->nonfull_words(s->bitmap, i),
+                                 __ATOMIC_RELAXED);
+                i += 63;
+                continue;
+            }
+            bool set = level == 0 ? bitmap_load_word(s->bitmap, i) != BITMAP_FULL_WORD
+                                  : s->levels[level - 1][i] != 0;
+            uint64_t mask = 1ULL << (i % 64);
+            uint64_t *slot = &s->levels[level][i / 64];
+            __atomic_store_n(slot, set ? *slot | mask : *slot & ~mask, __ATOMIC_RELAXED);
+        }
+        low /= 64;
+        high = (high + 63) / 64;
+    }
+    pthread_mutex_unlock(&s->lock);
+}
+
+/**
+ * 为位图建立空闲位摘要 (按预留容量分配，只有访问到的页占用内存；内容全为0，须再重建)
+ */
+static int bitmap_summary_init(bitmap_summary_t *s, const char *bitmap, size_t capacity_bits) {
+    size_t words[BITMAP_SUMMARY_MAX_LEVELS];
+    size_t bits = (capacity_bits + BITMAP_WORD_BITS - 1) / BITMAP_WORD_BITS;
+    size_t total = 0;
+    int level_count = 0;
+    do {
+        words[level_count] = (bits + 63) / 64;
+        total += words[level_count];
+        bits = words[level_count++];
+    } while (bits > BITMAP_SUMMARY_TOP_WORDS && level_count < BITMAP_SUMMARY_MAX_LEVELS);
+
+    uint64_t *levels = bufpool_reserve(total * sizeof(uint64_t));
+    if (!levels) {
+        return -1;
+    }
+
+    s->bitmap = bitmap;
+    s->words = (capacity_bits + BITMAP_WORD_BITS - 1) / BITMAP_WORD_BITS;
+    s->size = total * sizeof(uint64_t);
+    s->level_count = level_count;
+    for (int level = 0; level < level_count; level++) {
+        s->levels[level] = levels;
+        levels += words[level];
+    }
+    return 0;
+}
+
+/**
+ * 释放空闲位摘要
+ */
+static void bitmap_summary_cleanup(bitmap_summary_t *s) {
+    bufpool_release(s->levels[0], s->size);
+    memset(s->levels, 0, sizeof(s->levels));
+    s->bitmap = NULL;
+    s->words = 0;
+    s->level_count = 0;
+}
+
+/**
+ * 按当前的块组重建两个位图的摘要
+ */
+static void bitmap_summary_rebuild_all(void) {
+    bitmap_summary_rebuild(&bitmap_summaries[0], 0, (size_t)FS_GROUP_COUNT * FS_BLOCKS_PER_GROUP);
+    bitmap_summary_rebuild(&bitmap_summaries[1], 0, (size_t)FS_GROUP_COUNT * FS_INODES_PER_GROUP);
+}
+
+// ============================================================================
+// 内部辅助函数
+// ============================================================================
+
+/**
+ * 标记最后一个块组中超出总块数的位 (这些块不存在，永远不会被分配)
+ */
+static void bitmap_mark_padding(void) {
+    int bits = FS_GROUP_COUNT * FS_BLOCKS_PER_GROUP;
+    for (int i = FS_TOTAL_BLOCKS; i < bits; i++) {
+        bitmap_set_bit(g_fs.block_bitmap, i);
+    }
+}
+
+/**
+ * 生成读写各组位图的请求 (每组两个: 数据块位图、inode位图)
+ */
+static disk_io_t *bitmap_group_ios(void) {
+    disk_io_t *ios = malloc(2 * FS_GROUP_COUNT * sizeof(disk_io_t));
+    if (!ios) {
+        return NULL;
+    }
+
+    size_t block_bytes = BITMAP_BYTES(FS_BLOCKS_PER_GROUP);
+    size_t inode_bytes = BITMAP_BYTES(FS_INODES_PER_GROUP);
+    for (int g = 0; g < FS_GROUP_COUNT; g++) {
+        ios[2 * g].offset = g_fs.groups[g].block_bitmap_offset;
+        ios[2 * g].buffer = g_fs.block_bitmap + g * block_bytes;
+        ios[2 * g].size = block_bytes;
+        ios[2 * g + 1].offset = g_fs.groups[g].inode_bitmap_offset;
+        ios[2 * g + 1].buffer = g_fs.inode_bitmap + g * inode_bytes;
+        ios[2 * g + 1].size = inode_bytes;
+    }
+    return ios;
+}
+
+/**
+ * inode位图预留的字节数
+ */
+static size_t bitmap_inode_capacity(void) {
+    return BITMAP_BYTES((size_t)FS_GROUP_CAPACITY * FS_INODES_PER_GROUP);
+}
+
+/**
+ * 数据块位图预留的字节数
+ */
+static size_t bitmap_block_capacity(void) {
+    return BITMAP_BYTES((size_t)FS_GROUP_CAPACITY * FS_BLOCKS_PER_GROUP);
+}
 
 // ============================================================================
 // 位图管理函数实现
@@ -17,26 +460,42 @@
  * 初始化位图
  */
 int bitmap_init(void) {
-    // 分配inode位图内存
-    g_fs.inode_bitmap = calloc(MAX_INODES / 8, 1);
+    // 分配inode位图内存 (页对齐，O_DIRECT下可直接读写)
+    // 按预留的组数预留地址空间，在线扩容时新组的位图接在后面，已有位图不移动
+    g_fs.inode_bitmap = bufpool_reserve(bitmap_inode_capacity());
     if (!g_fs.inode_bitmap) {
         printf("错误: 无法分配inode位图内存\n");
         return -1;
     }
     
     // 分配数据块位图内存
-    g_fs.block_bitmap = calloc(MAX_BLOCKS / 8, 1);
+    // 按组数乘每组块数分配，各组位图在内存中首尾相接
+    g_fs.block_bitmap = bufpool_reserve(bitmap_block_capacity());
     if (!g_fs.block_bitmap) {
         printf("错误: 无法分配数据块位图内存\n");
-        free(g_fs.inode_bitmap);
+        bufpool_release(g_fs.inode_bitmap, bitmap_inode_capacity());
+        g_fs.inode_bitmap = NULL;
+        return -1;
+    }
+
+    // 空闲位摘要 (同样按预留容量)
+    if (bitmap_summary_init(&bitmap_summaries[0], g_fs.block_bitmap,
+                            (size_t)FS_GROUP_CAPACITY * FS_BLOCKS_PER_GROUP) != 0 ||
+        bitmap_summary_init(&bitmap_summaries[1], g_fs.inode_bitmap,
+                            (size_t)FS_GROUP_CAPACITY * FS_INODES_PER_GROUP) != 0) {
+        printf("错误: 无法分配位图摘要内存\n");
+        bitmap_cleanup();
         return -1;
     }
     
     // 标记根目录使用的资源
     bitmap_set_bit(g_fs.inode_bitmap, ROOT_INODE);  // 根目录inode
     bitmap_set_bit(g_fs.block_bitmap, 0);           // 用户信息块
+    bitmap_mark_padding();
+    bitmap_select_scan();
+    bitmap_summary_rebuild_all();
     
-    printf("位图初始化完成\n");
+    printf("位图初始化完成 (扫描: %s)\n", bitmap_scan->name);
     return 0;
 }
 
@@ -44,24 +503,21 @@ int bitmap_init(void) {
  * 加载位图从磁盘
  */
 int bitmap_load(void) {
-    SuperBlock *sb = &g_fs.superblock;
-    
     // 分配内存
     if (bitmap_init() != 0) {
         return -1;
     }
     
-    // 读取inode位图
-    if (disk_read(sb->inode_bitmap_offset, g_fs.inode_bitmap, MAX_INODES / 8) != 0) {
-        printf("错误: 无法读取inode位图\n");
-        return -1;
-    }
-    
-    // 读取数据块位图
-    if (disk_read(sb->block_bitmap_offset, g_fs.block_bitmap, MAX_BLOCKS / 8) != 0) {
-        printf("错误: 无法读取数据块位图\n");
+    // 一次读取所有组的数据块位图和inode位图
+    disk_io_t *ios = bitmap_group_ios();
+    if (!ios || disk_readv(ios, 2 * FS_GROUP_COUNT) != 0) {
+        printf("错误: 无法读取位图\n");
+        free(ios);
         return -1;
     }
+    free(ios);
+    bitmap_mark_padding();
+    bitmap_summary_rebuild_all();
     
     printf("位图加载完成\n");
     return 0;
@@ -71,23 +527,30 @@ int bitmap_load(void) {
  * 保存位图到磁盘
  */
 int bitmap_save(void) {
-    SuperBlock *sb = &g_fs.superblock;
-    
-    // 写入inode位图
-    if (disk_write(sb->inode_bitmap_offset, g_fs.inode_bitmap, MAX_INODES / 8) != 0) {
-        printf("错误: 无法写入inode位图\n");
-        return -1;
-    }
-    
-    // 写入数据块位图
-    if (disk_write(sb->block_bitmap_offset, g_fs.block_bitmap, MAX_BLOCKS / 8) != 0) {
-        printf("错误: 无法写入数据块位图\n");
+    // 一次写入所有组的数据块位图和inode位图
+    disk_io_t *ios = bitmap_group_ios();
+    if (!ios || disk_writev(ios, 2 * FS_GROUP_COUNT) != 0) {
+        printf("错误: 无法写入位图\n");
+        free(ios);
         return -1;
     }
+    free(ios);
     
     return 0;
 }
 
+/**
+ * 释放位图内存
+ */
+void bitmap_cleanup(void) {
+    bitmap_summary_cleanup(&bitmap_summaries[0]);
+    bitmap_summary_cleanup(&bitmap_summaries[1]);
+    bufpool_release(g_fs.inode_bitmap, bitmap_inode_capacity());
+    g_fs.inode_bitmap = NULL;
+    bufpool_release(g_fs.block_bitmap, bitmap_block_capacity());
+    g_fs.block_bitmap = NULL;
+}
+
 /**
  * 设置位图中的某一位
  */
@@ -100,6 +563,7 @@ int bitmap_set_bit(char *bitmap, int bit) {
     int bit_index = bit % 8;
     
     bitmap[byte_index] |= (1 << bit_index);
+    bitmap_summary_note(bitmap, bit);
     return 0;
 }
 
@@ -115,6 +579,7 @@ int bitmap_clear_bit(char *bitmap, int bit) {
     int bit_index = bit % 8;
     
     bitmap[byte_index] &= ~(1 << bit_index);
+    bitmap_summary_note(bitmap, bit);
     return 0;
 }
 
@@ -136,25 +601,55 @@ bool bitmap_test_bit(const char *bitmap, int bit) {
  * 在位图中查找第一个空闲位
  */
 int bitmap_find_free_bit(const char *bitmap, int max_bits) {
-    for (int i = 0; i < max_bits; i++) {
-        if (!bitmap_test_bit(bitmap, i)) {
-            return i;
-        }
+    if (max_bits <= 0) {
+        return -1;
+    }
+
+    // 数据块位图和inode位图经摘要查找，只访问每层的一两个字
+    size_t first_bit;
+    const bitmap_summary_t *s = bitmap_summary_of(bitmap, &first_bit);
+    if (s) {
+        long bit = bitmap_summary_find_free(s, first_bit, first_bit + max_bits);
+        return bit == -1 ? -1 : (int)(bit - first_bit);
     }
-    return -1;  // 没有找到空闲位
+
+    // 其他位图 (摘要建立之前): 逐字跳过全部已使用的字，在第一个有空位的字中取最低的0位
+    size_t words = (size_t)max_bits / BITMAP_WORD_BITS;
+    size_t index = bitmap_skip_full(bitmap, words);
+    if (index < words) {
+        return (int)(index * BITMAP_WORD_BITS) + __builtin_ctzll(~bitmap_load_word(bitmap, index));
+    }
+
+    // 末尾不足一个字的位
+    int bits = max_bits % BITMAP_WORD_BITS;
+    uint64_t free_bits = ~bitmap_load_tail(bitmap, max_bits) & ((1ULL << bits) - 1);
+    if (bits == 0 || free_bits == 0) {
+        return -1;  // 没有找到空闲位
+    }
+    return (int)(words * BITMAP_WORD_BITS) + __builtin_ctzll(free_bits);
+}
+
+/**
+ * 在线扩容: 把新组的位图纳入摘要
+ */
+void bitmap_grow(int old_groups, int new_groups) {
+    bitmap_summary_rebuild(&bitmap_summaries[0], (size_t)old_groups * FS_BLOCKS_PER_GROUP,
+                           (size_t)new_groups * FS_BLOCKS_PER_GROUP);
+    bitmap_summary_rebuild(&bitmap_summaries[1], (size_t)old_groups * FS_INODES_PER_GROUP,
+                           (size_t)new_groups * FS_INODES_PER_GROUP);
 }
 
 /**
  * 统计位图中已使用的位数
  */
 int bitmap_count_used_bits(const char *bitmap, int max_bits) {
-    int count = 0;
-    for (int i = 0; i < max_bits; i++) {
-        if (bitmap_test_bit(bitmap, i)) {
-            count++;
-        }
+    if (max_bits <= 0) {
+        return 0;
     }
-    return count;
+
+    size_t count = bitmap_scan->count_used(bitmap, (size_t)max_bits / BITMAP_WORD_BITS);
+    count += __builtin_popcountll(bitmap_load_tail(bitmap, max_bits));
+    return (int)count;
 }
 
 /**
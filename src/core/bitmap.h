@@ -34,7 +34,12 @@ int bitmap_load(void);
 int bitmap_save(void);
 
 /**
- * 设置位图中的某一位
+ * 释放位图内存
+ */
+void bitmap_cleanup(void);
+
+/**
+ * 设置位图中的某一位 (数据块和inode位图的空闲位摘要随之更新)
  * @param bitmap 位图指针
  * @param bit 位编号
  * @return 成功返回0，失败返回负数
@@ -42,7 +47,7 @@ int bitmap_save(void);
 int bitmap_set_bit(char *bitmap, int bit);
 
 /**
- * 清除位图中的某一位
+ * 清除位图中的某一位 (数据块和inode位图的空闲位摘要随之更新)
  * @param bitmap 位图指针
  * @param bit 位编号
  * @return 成功返回0，失败返回负数
@@ -59,6 +64,8 @@ bool bitmap_test_bit(const char *bitmap, int bit);
 
 /**
  * 在位图中查找第一个空闲位
+ * 数据块和inode位图 (及其中的某个块组) 经多层空闲位摘要查找，每层只访问一两个字；
+ * 其他位图按64位字扫描
  * @param bitmap 位图指针
  * @param max_bits 最大位数
  * @return 找到返回位编号，未找到返回-1
@@ -66,7 +73,14 @@ bool bitmap_test_bit(const char *bitmap, int bit);
 int bitmap_find_free_bit(const char *bitmap, int max_bits);
 
 /**
- * 统计位图中已使用的位数
+ * 在线扩容: 把新增块组的数据块位图和inode位图纳入空闲位摘要 (在发布新的组数之前调用)
+ * @param old_groups 原来的组数
+ * @param new_groups 新的组数
+ */
+void bitmap_grow(int old_groups, int new_groups);
+
+/**
+ * 统计位图中已使用的位数 (按64位字popcount)
  * @param bitmap 位图指针
  * @param max_bits 最大位数
  * @return 已使用的位数
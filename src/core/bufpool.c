@@ -0,0 +1,115 @@
+/*
+ * ============================================================================
+ * 文件名: src/core/bufpool.c
+ * 描述: 对齐缓冲区池实现
+ * 功能: 为O_DIRECT等绕过页缓存的I/O提供按页对齐的缓冲区
+ * ============================================================================
+ */
+
+#include "bufpool.h"
+#include <pthread.h>
+#include <sys/mman.h>
+
+// ============================================================================
+// 静态变量
+// ============================================================================
+static struct {
+    void *free_list[BUFPOOL_MAX_FREE];  // 空闲缓冲区栈
+    int free_count;                     // 空闲缓冲区数量
+    pthread_mutex_t lock;               // 保护空闲栈
+} bufpool_state = { .free_count = 0, .lock = PTHREAD_MUTEX_INITIALIZER };
+
+// ============================================================================
+// 缓冲区池函数实现
+// ============================================================================
+
+/**
+ * 从池中获取一个对齐缓冲区
+ */
+void *bufpool_get(size_t size) {
+    void *buffer = NULL;
+
+    if (size <= BUFPOOL_BUFFER_SIZE) {
+        pthread_mutex_lock(&bufpool_state.lock);
+        if (bufpool_state.free_count > 0) {
+            buffer = bufpool_state.free_list[--bufpool_state.free_count];
+        }
+        pthread_mutex_unlock(&bufpool_state.lock);
+
+        if (buffer) {
+            return buffer;
+        }
+        size = BUFPOOL_BUFFER_SIZE;
+    }
+
+    if (posix_memalign(&buffer, BUFPOOL_ALIGN, size) != 0) {
+        printf("错误: 无法分配对齐缓冲区 (大小: %zu)\n", size);
+        return NULL;
+    }
+
+    return buffer;
+}
+
+/**
+ * 归还缓冲区到池中
+ */
+void bufpool_put(void *buffer, size_t size) {
+    if (!buffer) {
+        return;
+    }
+
+    if (size <= BUFPOOL_BUFFER_SIZE) {
+        pthread_mutex_lock(&bufpool_state.lock);
+        if (bufpool_state.free_count < BUFPOOL_MAX_FREE) {
+            bufpool_state.free_list[bufpool_state.free_count++] = buffer;
+            buffer = NULL;
+        }
+        pthread_mutex_unlock(&bufpool_state.lock);
+    }
+
+    free(buffer);
+}
+
+/**
+ * 分配一块清零的对齐内存
+ */
+void *bufpool_alloc(size_t size) {
+    void *buffer = NULL;
+
+    if (posix_memalign(&buffer, BUFPOOL_ALIGN, size) != 0) {
+        return NULL;
+    }
+
+    memset(buffer, 0, size);
+    return buffer;
+}
+
+/**
+ * 预留一块可原地增长的清零内存
+ */
+void *bufpool_reserve(size_t capacity) {
+    // 匿名映射按页对齐，且只有被访问的页才占用物理内存
+    void *buffer = mmap(NULL, capacity, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return buffer == MAP_FAILED ? NULL : buffer;
+}
+
+/**
+ * 释放预留的内存
+ */
+void bufpool_release(void *buffer, size_t capacity) {
+    if (buffer) {
+        munmap(buffer, capacity);
+    }
+}
+
+/**
+ * 释放池中缓存的所有空闲缓冲区
+ */
+void bufpool_cleanup(void) {
+    pthread_mutex_lock(&bufpool_state.lock);
+    while (bufpool_state.free_count > 0) {
+        free(bufpool_state.free_list[--bufpool_state.free_count]);
+    }
+    pthread_mutex_unlock(&bufpool_state.lock);
+}
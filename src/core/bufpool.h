@@ -0,0 +1,67 @@
+/*
+ * ============================================================================
+ * 文件名: src/core/bufpool.h
+ * 描述: 对齐缓冲区池头文件
+ * 功能: 为O_DIRECT等绕过页缓存的I/O提供按页对齐的缓冲区
+ * ============================================================================
+ */
+
+#ifndef BUFPOOL_H
+#define BUFPOOL_H
+
+#include "../../include/ext2fs.h"
+
+// ============================================================================
+// 缓冲区池常量
+// ============================================================================
+#define BUFPOOL_ALIGN 4096              // 缓冲区对齐粒度
+#define BUFPOOL_BUFFER_SIZE (64 * 1024) // 池中每个缓冲区的大小
+#define BUFPOOL_MAX_FREE 16             // 池中最多缓存的空闲缓冲区数
+
+// ============================================================================
+// 缓冲区池函数
+// ============================================================================
+
+/**
+ * 从池中获取一个对齐缓冲区
+ * 超过BUFPOOL_BUFFER_SIZE的请求单独分配，归还时直接释放
+ * @param size 需要的大小
+ * @return 成功返回对齐的缓冲区，失败返回NULL
+ */
+void *bufpool_get(size_t size);
+
+/**
+ * 归还缓冲区到池中
+ * @param buffer 由bufpool_get返回的缓冲区
+ * @param size 获取时传入的大小
+ */
+void bufpool_put(void *buffer, size_t size);
+
+/**
+ * 分配一块清零的对齐内存 (用于常驻的元数据区域，以free释放)
+ * @param size 大小
+ * @return 成功返回对齐的内存，失败返回NULL
+ */
+void *bufpool_alloc(size_t size);
+
+/**
+ * 预留一块清零的对齐内存，容量按可能增长到的最大值给出 (用于在线扩容时原地变长的元数据区域)
+ * 只有实际访问过的页占用物理内存，已有内容的地址在增长时保持不变
+ * @param capacity 最大容量
+ * @return 成功返回页对齐的内存，失败返回NULL
+ */
+void *bufpool_reserve(size_t capacity);
+
+/**
+ * 释放由bufpool_reserve预留的内存
+ * @param buffer 内存地址 (可为NULL)
+ * @param capacity 预留时传入的容量
+ */
+void bufpool_release(void *buffer, size_t capacity);
+
+/**
+ * 释放池中缓存的所有空闲缓冲区
+ */
+void bufpool_cleanup(void);
+
+#endif /* BUFPOOL_H */
@@ -2,83 +2,312 @@
  * ============================================================================
  * 文件名: src/core/disk.c
  * 描述: 磁盘I/O模块实现
- * 功能: 虚拟磁盘文件的读写操作
+ * 功能: 虚拟磁盘的读写操作，具体存储由挂载时选择的后端提供
  * ============================================================================
  */
 
 #include "disk.h"
+#include "disk_backend.h"
+#include "bufpool.h"
+#include "iostat.h"
+#include "elevator.h"
 
 // ============================================================================
 // 静态变量
 // ============================================================================
+
+// 可选的后端 (第一个为默认后端)
+static const disk_backend_ops_t *disk_backends[] = {
+    &disk_file_backend,
+    &disk_mmap_backend,
+    &disk_ram_backend,
+    &disk_stripe_backend,
+    &disk_mirror_backend,
+};
+
 static struct {
-    FILE *file;                         // 磁盘文件句柄
+    const disk_backend_ops_t *ops;      // 当前使用的后端
+    disk_config_t config;               // 传给后端的配置
+    bool use_elevator;                  // 是否经写入队列排序合并后提交
+    bool is_open;                       // 是否已打开
+    bool is_new;                        // 是否为本次新建的磁盘
     char path[256];                     // 磁盘文件路径
     off_t size;                         // 磁盘大小
+    off_t image_size;                   // 新建镜像的大小 (由文件系统几何参数决定)
     uint64_t read_count;                // 读取次数统计
     uint64_t write_count;               // 写入次数统计
     uint64_t bytes_read;                // 读取字节数统计
     uint64_t bytes_written;             // 写入字节数统计
-} disk_state = {0};
+    uint64_t discard_count;             // 丢弃次数统计
+    uint64_t bytes_discarded;           // 丢弃字节数统计
+    uint64_t write_gen;                 // 写入代数: 每次写入或丢弃到达后端时加1
+    uint64_t durable_gen;               // 已确认持久化的写入代数
+    uint64_t barrier_count;             // 写屏障次数统计 (实际刷新设备)
+    uint64_t barrier_skipped;           // 无新写入而跳过的写屏障次数
+} disk_state = { .ops = &disk_file_backend };
+
+// ============================================================================
+// 内部辅助函数
+// ============================================================================
+
+/**
+ * 检查请求范围是否在磁盘内
+ */
+static int disk_check_range(off_t offset, size_t size, const char *what) {
+    if (!disk_state.is_open) {
+        printf("错误: 磁盘未初始化\n");
+        return -1;
+    }
+
+    // 磁盘可能正在被在线扩容，只读取一次大小
+    off_t disk_size = disk_get_size();
+    if (offset < 0 || offset >= disk_size || (off_t)size > disk_size - offset) {
+        printf("错误: %s范围超出磁盘 (偏移: %ld, 长度: %zu, 磁盘大小: %ld)\n",
+               what, offset, size, disk_size);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * 记录一次到达后端的写入或丢弃
+ */
+static void disk_mark_written(void) {
+    __atomic_fetch_add(&disk_state.write_gen, 1, __ATOMIC_RELEASE);
+    g_fs.is_dirty = true;
+}
+
+/**
+ * 记录代数gen之前的写入已持久化 (并发屏障只会把durable_gen向前推进)
+ */
+static void disk_mark_durable(uint64_t gen) {
+    uint64_t durable = __atomic_load_n(&disk_state.durable_gen, __ATOMIC_ACQUIRE);
+    while (durable < gen &&
+           !__atomic_compare_exchange_n(&disk_state.durable_gen, &durable, gen, false,
+                                        __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)) {
+    }
+}
+
+/**
+ * 后端分散读取 (后端没有向量接口时逐个读取)
+ */
+static int disk_backend_readv(const disk_io_t *ios, int count) {
+    if (disk_state.ops->readv) {
+        return disk_state.ops->readv(ios, count);
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (disk_state.ops->read(ios[i].offset, ios[i].buffer, ios[i].size) < 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * 后端聚集写入 (后端没有向量接口时逐个写入)
+ */
+static int disk_backend_writev(const disk_io_t *ios, int count) {
+    if (disk_state.ops->writev) {
+        return disk_state.ops->writev(ios, count);
+    }
+
+    for (int i = 0; i < count; i++) {
+        ssize_t n = disk_state.ops->write(ios[i].offset, ios[i].buffer, ios[i].size);
+        if (n < 0 || (size_t)n != ios[i].size) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * 提交写入队列合并后的请求 (作为elevator_flush的回调)
+ */
+static int disk_submit_writes(const disk_io_t *ios, int count) {
+    uint64_t bytes = 0;
+    for (int i = 0; i < count; i++) {
+        bytes += ios[i].size;
+    }
+
+    uint64_t start = iostat_disk_begin();
+    int result = disk_backend_writev(ios, count);
+    iostat_disk_end(IOSTAT_WRITE, start, bytes);
+    if (result != 0) {
+        printf("错误: 写入队列提交失败 (%d个请求)\n", count);
+        return -1;
+    }
+
+    __atomic_fetch_add(&disk_state.write_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&disk_state.bytes_written, bytes, __ATOMIC_RELAXED);
+    disk_mark_written();
+    return 0;
+}
+
+/**
+ * 提交写入队列中的所有请求
+ */
+static int disk_flush_writes(void) {
+    if (!elevator_enabled()) {
+        return 0;
+    }
+
+    return elevator_flush(disk_submit_writes);
+}
+
+/**
+ * 把一次写入加入写入队列，队列满时提交
+ */
+static int disk_queue_write(off_t offset, const void *buffer, size_t size) {
+    int result = elevator_queue(offset, buffer, size);
+    if (result < 0) {
+        printf("错误: 写入排队失败 (偏移: %ld, 大小: %zu)\n", offset, size);
+        return -1;
+    }
+
+    g_fs.is_dirty = true;
+    return result > 0 ? disk_flush_writes() : 0;
+}
+
+/**
+ * 打开/创建成功后重置状态
+ */
+static void disk_reset_state(const char *image_path, off_t size, bool is_new) {
+    strncpy(disk_state.path, image_path, sizeof(disk_state.path) - 1);
+    disk_state.size = size;
+    disk_state.is_open = true;
+    disk_state.is_new = is_new;
+    disk_state.read_count = 0;
+    disk_state.write_count = 0;
+    disk_state.bytes_read = 0;
+    disk_state.bytes_written = 0;
+    disk_state.discard_count = 0;
+    disk_state.bytes_discarded = 0;
+    disk_state.write_gen = 0;
+    disk_state.durable_gen = 0;
+    disk_state.barrier_count = 0;
+    disk_state.barrier_skipped = 0;
+}
 
 // ============================================================================
 // 磁盘I/O函数实现
 // ============================================================================
 
+/**
+ * 选择磁盘后端 (须在disk_init之前调用)
+ */
+int disk_set_backend(const char *name) {
+    if (disk_state.is_open) {
+        printf("错误: 磁盘已打开，无法切换后端\n");
+        return -1;
+    }
+
+    for (size_t i = 0; i < sizeof(disk_backends) / sizeof(disk_backends[0]); i++) {
+        if (name && strcmp(name, disk_backends[i]->name) == 0) {
+            disk_state.ops = disk_backends[i];
+            return 0;
+        }
+    }
+
+    printf("错误: 未知的磁盘后端 %s\n", name ? name : "(null)");
+    return -1;
+}
+
+/**
+ * 获取当前磁盘后端名称
+ */
+const char *disk_get_backend(void) {
+    return disk_state.ops->name;
+}
+
+/**
+ * 启用io_uring异步I/O引擎
+ */
+void disk_set_io_uring(bool enable) {
+    disk_state.config.use_uring = enable;
+}
+
+/**
+ * 以O_DIRECT方式打开镜像
+ */
+void disk_set_direct_io(bool enable) {
+    disk_state.config.direct = enable;
+}
+
+/**
+ * 设置条带后端的条带大小
+ */
+void disk_set_stripe_size(size_t size) {
+    disk_state.config.stripe_size = size;
+}
+
+/**
+ * 设置新建镜像的大小
+ */
+void disk_set_image_size(off_t size) {
+    disk_state.image_size = size;
+}
+
+/**
+ * 启用写入队列
+ */
+void disk_set_elevator(bool enable) {
+    disk_state.use_elevator = enable;
+}
+
 /**
  * 初始化磁盘I/O系统
  */
 int disk_init(const char *image_path) {
-    // 检查文件是否存在
-    FILE *test_file = fopen(image_path, "rb");
-    if (test_file) {
-        fclose(test_file);
+    bool exists = disk_state.ops->exists ? disk_state.ops->exists(image_path)
+                                         : access(image_path, F_OK) == 0;
+
+    // 不能打开现有镜像的后端 (内存盘) 每次都新建
+    int result;
+    if (disk_state.ops->open && exists) {
         printf("发现现有磁盘镜像，正在加载...\n");
-        return disk_open(image_path);
+        result = disk_open(image_path);
     } else {
         printf("磁盘镜像不存在，正在创建...\n");
-        return disk_create(image_path);
+        result = disk_create(image_path);
+    }
+
+    if (result == 0 && disk_state.use_elevator) {
+        // 映射到内存的后端写入只是内存拷贝，排队没有收益
+        if (disk_state.ops == &disk_mmap_backend || disk_state.ops == &disk_ram_backend) {
+            printf("提示: %s后端不使用写入队列\n", disk_state.ops->name);
+        } else if (elevator_init() != 0) {
+            disk_cleanup();
+            return -1;
+        }
     }
+
+    return result;
 }
 
 /**
  * 创建新的磁盘镜像文件
  */
 int disk_create(const char *image_path) {
-    // 创建新文件
-    disk_state.file = fopen(image_path, "wb+");
-    if (!disk_state.file) {
-        printf("错误: 无法创建磁盘镜像文件 %s\n", image_path);
-        return -1;
-    }
-    
-    // 预分配磁盘空间
-    off_t disk_size = MAX_BLOCKS * BLOCK_SIZE;
-    if (fseek(disk_state.file, disk_size - 1, SEEK_SET) != 0) {
-        printf("错误: 无法设置磁盘大小\n");
-        fclose(disk_state.file);
+    if (disk_state.image_size <= 0) {
+        printf("错误: 未设置新建镜像的大小\n");
         return -1;
     }
-    
-    // 写入最后一个字节以确保文件大小
-    if (fputc(0, disk_state.file) == EOF) {
-        printf("错误: 无法写入磁盘文件\n");
-        fclose(disk_state.file);
+
+    // 按O_DIRECT粒度对齐镜像大小
+    off_t disk_size = DISK_ALIGN_UP(disk_state.image_size);
+
+    if (disk_state.ops->create(image_path, disk_size, &disk_state.config) != 0) {
         return -1;
     }
-    
-    // 回到文件开头
-    rewind(disk_state.file);
-    
-    // 保存状态
-    strncpy(disk_state.path, image_path, sizeof(disk_state.path) - 1);
-    disk_state.size = disk_size;
-    disk_state.read_count = 0;
-    disk_state.write_count = 0;
-    disk_state.bytes_read = 0;
-    disk_state.bytes_written = 0;
-    
-    printf("磁盘镜像创建完成: %s (大小: %ld 字节)\n", image_path, disk_size);
+
+    disk_reset_state(image_path, disk_size, true);
+
+    printf("磁盘镜像创建完成: %s (大小: %ld 字节, 后端: %s)\n",
+           image_path, disk_size, disk_state.ops->name);
     return 0;
 }
 
@@ -86,31 +315,20 @@ int disk_create(const char *image_path) {
  * 打开现有的磁盘镜像文件
  */
 int disk_open(const char *image_path) {
-    // 打开文件
-    disk_state.file = fopen(image_path, "rb+");
-    if (!disk_state.file) {
-        printf("错误: 无法打开磁盘镜像文件 %s\n", image_path);
+    if (!disk_state.ops->open) {
+        printf("错误: %s后端不能打开现有镜像\n", disk_state.ops->name);
         return -1;
     }
-    
-    // 获取文件大小
-    if (fseek(disk_state.file, 0, SEEK_END) != 0) {
-        printf("错误: 无法获取磁盘文件大小\n");
-        fclose(disk_state.file);
+
+    off_t disk_size = 0;
+    if (disk_state.ops->open(image_path, &disk_size, &disk_state.config) != 0) {
         return -1;
     }
-    
-    disk_state.size = ftell(disk_state.file);
-    rewind(disk_state.file);
-    
-    // 保存状态
-    strncpy(disk_state.path, image_path, sizeof(disk_state.path) - 1);
-    disk_state.read_count = 0;
-    disk_state.write_count = 0;
-    disk_state.bytes_read = 0;
-    disk_state.bytes_written = 0;
-    
-    printf("磁盘镜像加载完成: %s (大小: %ld 字节)\n", image_path, disk_state.size);
+
+    disk_reset_state(image_path, disk_size, false);
+
+    printf("磁盘镜像加载完成: %s (大小: %ld 字节, 后端: %s)\n",
+           image_path, disk_state.size, disk_state.ops->name);
     return 0;
 }
 
@@ -118,29 +336,29 @@ int disk_open(const char *image_path) {
  * 从磁盘读取数据
  */
 int disk_read(off_t offset, void *buffer, size_t size) {
-    if (!disk_state.file) {
-        printf("错误: 磁盘未初始化\n");
+    if (disk_check_range(offset, size, "读取") != 0) {
         return -1;
     }
-    
-    if (offset < 0 || offset >= disk_state.size) {
-        printf("错误: 读取偏移量超出范围 (偏移: %ld, 大小: %ld)\n", offset, disk_state.size);
-        return -1;
+
+    uint64_t start = iostat_disk_begin();
+    ssize_t bytes_read;
+    if (elevator_enabled()) {
+        // 尚未提交的写入覆盖在读取结果之上
+        disk_io_t io = { .offset = offset, .buffer = buffer, .size = size };
+        bytes_read = elevator_readv(&io, 1, disk_backend_readv) == 0 ? (ssize_t)size : -1;
+    } else {
+        bytes_read = disk_state.ops->read(offset, buffer, size);
     }
-    
-    // 定位到指定位置
-    if (fseek(disk_state.file, offset, SEEK_SET) != 0) {
-        printf("错误: 无法定位到偏移量 %ld\n", offset);
+    iostat_disk_end(IOSTAT_READ, start, size);
+    if (bytes_read < 0) {
+        printf("错误: 读取失败 (偏移: %ld, 大小: %zu)\n", offset, size);
         return -1;
     }
-    
-    // 读取数据
-    size_t bytes_read = fread(buffer, 1, size, disk_state.file);
-    
+
     // 更新统计信息
-    disk_state.read_count++;
-    disk_state.bytes_read += bytes_read;
-    
+    __atomic_fetch_add(&disk_state.read_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&disk_state.bytes_read, bytes_read, __ATOMIC_RELAXED);
+
     return bytes_read;
 }
 
@@ -148,57 +366,225 @@ int disk_read(off_t offset, void *buffer, size_t size) {
  * 向磁盘写入数据
  */
 int disk_write(off_t offset, const void *buffer, size_t size) {
-    if (!disk_state.file) {
-        printf("错误: 磁盘未初始化\n");
+    if (disk_check_range(offset, size, "写入") != 0) {
         return -1;
     }
-    
-    if (offset < 0 || offset >= disk_state.size) {
-        printf("错误: 写入偏移量超出范围 (偏移: %ld, 大小: %ld)\n", offset, disk_state.size);
+
+    if (elevator_enabled()) {
+        return disk_queue_write(offset, buffer, size);
+    }
+
+    uint64_t start = iostat_disk_begin();
+    ssize_t bytes_written = disk_state.ops->write(offset, buffer, size);
+    iostat_disk_end(IOSTAT_WRITE, start, size);
+
+    // 检查写入是否完整
+    if (bytes_written < 0 || (size_t)bytes_written != size) {
+        printf("错误: 写入失败 (偏移: %ld, 大小: %zu)\n", offset, size);
         return -1;
     }
-    
-    // 定位到指定位置
-    if (fseek(disk_state.file, offset, SEEK_SET) != 0) {
-        printf("错误: 无法定位到偏移量 %ld\n", offset);
+
+    // 更新统计信息
+    __atomic_fetch_add(&disk_state.write_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&disk_state.bytes_written, bytes_written, __ATOMIC_RELAXED);
+
+    // 推进写入代数并标记文件系统为脏
+    disk_mark_written();
+
+    return 0;  // 成功返回0
+}
+
+/**
+ * 检查批量请求是否都在磁盘范围内，并统计总字节数
+ */
+static int disk_check_batch(const disk_io_t *ios, int count, uint64_t *bytes) {
+    *bytes = 0;
+    for (int i = 0; i < count; i++) {
+        if (disk_check_range(ios[i].offset, ios[i].size, "批量请求") != 0) {
+            return -1;
+        }
+        *bytes += ios[i].size;
+    }
+
+    return 0;
+}
+
+/**
+ * 分散读取多个磁盘区域
+ */
+int disk_readv(const disk_io_t *ios, int count) {
+    if (count <= 0) {
+        return 0;
+    }
+
+    uint64_t bytes;
+    if (disk_check_batch(ios, count, &bytes) != 0) {
         return -1;
     }
-    
-    // 写入数据
-    size_t bytes_written = fwrite(buffer, 1, size, disk_state.file);
 
-    // 检查写入是否完整
-    if (bytes_written != size) {
-        printf("错误: 写入不完整 (期望: %zu, 实际: %zu)\n", size, bytes_written);
+    uint64_t start = iostat_disk_begin();
+    int result = elevator_enabled() ? elevator_readv(ios, count, disk_backend_readv)
+                                    : disk_backend_readv(ios, count);
+    iostat_disk_end(IOSTAT_READ, start, bytes);
+    if (result != 0) {
         return -1;
     }
 
-    // 强制刷新到磁盘
-    fflush(disk_state.file);
+    // 一次向量请求计为一次I/O
+    __atomic_fetch_add(&disk_state.read_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&disk_state.bytes_read, bytes, __ATOMIC_RELAXED);
+    return 0;
+}
+
+/**
+ * 聚集写入多个磁盘区域
+ */
+int disk_writev(const disk_io_t *ios, int count) {
+    if (count <= 0) {
+        return 0;
+    }
+
+    uint64_t bytes;
+    if (disk_check_batch(ios, count, &bytes) != 0) {
+        return -1;
+    }
 
-    // 更新统计信息
-    disk_state.write_count++;
-    disk_state.bytes_written += bytes_written;
+    if (elevator_enabled()) {
+        for (int i = 0; i < count; i++) {
+            if (disk_queue_write(ios[i].offset, ios[i].buffer, ios[i].size) != 0) {
+                return -1;
+            }
+        }
+        return 0;
+    }
 
-    // 标记文件系统为脏
-    g_fs.is_dirty = true;
+    uint64_t start = iostat_disk_begin();
+    int result = disk_backend_writev(ios, count);
+    iostat_disk_end(IOSTAT_WRITE, start, bytes);
+    if (result != 0) {
+        return -1;
+    }
 
-    return 0;  // 成功返回0
+    __atomic_fetch_add(&disk_state.write_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&disk_state.bytes_written, bytes, __ATOMIC_RELAXED);
+    disk_mark_written();
+    return 0;
+}
+
+/**
+ * 丢弃磁盘区域
+ */
+int disk_discard(off_t offset, size_t size) {
+    if (disk_check_range(offset, size, "丢弃") != 0) {
+        return -1;
+    }
+
+    if (!disk_state.ops->discard) {
+        return -1;  // 由调用者回退到写入全0
+    }
+
+    // 先提交排队的写入，避免它们落在丢弃之后
+    if (disk_flush_writes() != 0) {
+        return -1;
+    }
+
+    uint64_t start = iostat_disk_begin();
+    int result = disk_state.ops->discard(offset, size);
+    iostat_disk_end(IOSTAT_DISCARD, start, size);
+    if (result != 0) {
+        return -1;
+    }
+
+    __atomic_fetch_add(&disk_state.discard_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&disk_state.bytes_discarded, size, __ATOMIC_RELAXED);
+    disk_mark_written();
+    return 0;
 }
 
 /**
  * 同步磁盘数据 (强制写入)
  */
 int disk_sync(void) {
-    if (!disk_state.file) {
+    if (!disk_state.is_open) {
         return -1;
     }
-    
-    if (fflush(disk_state.file) != 0) {
+
+    // 排序合并后提交写入队列
+    if (disk_flush_writes() != 0) {
+        return -1;
+    }
+
+    uint64_t gen = __atomic_load_n(&disk_state.write_gen, __ATOMIC_ACQUIRE);
+    uint64_t start = iostat_disk_begin();
+    int result = disk_state.ops->sync();
+    iostat_disk_end(IOSTAT_SYNC, start, 0);
+    if (result != 0) {
         printf("错误: 无法同步磁盘数据\n");
         return -1;
     }
-    
+
+    disk_mark_durable(gen);
+    return 0;
+}
+
+/**
+ * 写屏障
+ */
+int disk_barrier(void) {
+    if (!disk_state.is_open) {
+        return -1;
+    }
+
+    // 排队的写入也属于屏障之前的写入
+    if (disk_flush_writes() != 0) {
+        return -1;
+    }
+
+    // 刷新开始前读取代数: 刷新期间到达的写入不一定被覆盖，留给下一次屏障
+    uint64_t gen = __atomic_load_n(&disk_state.write_gen, __ATOMIC_ACQUIRE);
+    if (gen == __atomic_load_n(&disk_state.durable_gen, __ATOMIC_ACQUIRE)) {
+        __atomic_fetch_add(&disk_state.barrier_skipped, 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+
+    uint64_t start = iostat_disk_begin();
+    int result = disk_state.ops->barrier ? disk_state.ops->barrier() : disk_state.ops->sync();
+    iostat_disk_end(IOSTAT_SYNC, start, 0);
+    if (result != 0) {
+        printf("错误: 写屏障失败\n");
+        return -1;
+    }
+
+    __atomic_fetch_add(&disk_state.barrier_count, 1, __ATOMIC_RELAXED);
+    disk_mark_durable(gen);
+    return 0;
+}
+
+/**
+ * 在线扩大磁盘
+ */
+int disk_resize(off_t size) {
+    if (!disk_state.is_open) {
+        return -1;
+    }
+
+    size = DISK_ALIGN_UP(size);
+    if (size <= disk_state.size) {
+        return 0;
+    }
+
+    if (!disk_state.ops->resize) {
+        printf("错误: %s后端不支持在线扩容\n", disk_state.ops->name);
+        return -1;
+    }
+
+    if (disk_state.ops->resize(size) != 0) {
+        return -1;
+    }
+
+    // 后端完成扩容后才放开范围检查，新增区域此前不会被访问
+    __atomic_store_n(&disk_state.size, size, __ATOMIC_RELEASE);
+    printf("磁盘已扩大到 %ld 字节\n", size);
     return 0;
 }
 
@@ -206,28 +592,41 @@ int disk_sync(void) {
  * 获取磁盘大小
  */
 off_t disk_get_size(void) {
-    return disk_state.size;
+    return __atomic_load_n(&disk_state.size, __ATOMIC_ACQUIRE);
 }
 
 /**
  * 检查磁盘是否已打开
  */
 bool disk_is_open(void) {
-    return disk_state.file != NULL;
+    return disk_state.is_open;
+}
+
+/**
+ * 检查磁盘是否为本次新建 (需要格式化)
+ */
+bool disk_is_new(void) {
+    return disk_state.is_open && disk_state.is_new;
 }
 
 /**
  * 清理磁盘I/O系统
  */
 void disk_cleanup(void) {
-    if (disk_state.file) {
-        // 同步数据
-        disk_sync();
-        
-        // 关闭文件
-        fclose(disk_state.file);
-        disk_state.file = NULL;
-        
+    if (disk_state.is_open) {
+        // 提交剩余写入 (卸载时文件系统已提交过，通常无需再刷新设备)
+        disk_barrier();
+
+        // 释放写入队列并关闭后端
+        if (elevator_enabled()) {
+            elevator_cleanup();
+        }
+        disk_state.ops->close();
+        disk_state.is_open = false;
+
+        // 释放对齐缓冲区池
+        bufpool_cleanup();
+
         printf("磁盘I/O系统已清理\n");
     }
 }
@@ -238,13 +637,23 @@ void disk_cleanup(void) {
 void disk_print_stats(void) {
     printf("\n=== 磁盘I/O统计 ===\n");
     printf("磁盘文件: %s\n", disk_state.path);
-    printf("磁盘大小: %ld 字节 (%.1f KB)\n", 
+    printf("磁盘后端: %s\n", disk_state.ops->name);
+    printf("O_DIRECT: %s\n", disk_state.config.direct ? "是" : "否");
+    printf("磁盘大小: %ld 字节 (%.1f KB)\n",
            disk_state.size, (double)disk_state.size / 1024);
     printf("读取次数: %lu\n", disk_state.read_count);
     printf("写入次数: %lu\n", disk_state.write_count);
-    printf("读取字节: %lu (%.1f KB)\n", 
+    printf("读取字节: %lu (%.1f KB)\n",
            disk_state.bytes_read, (double)disk_state.bytes_read / 1024);
-    printf("写入字节: %lu (%.1f KB)\n", 
+    printf("写入字节: %lu (%.1f KB)\n",
            disk_state.bytes_written, (double)disk_state.bytes_written / 1024);
+    printf("丢弃次数: %lu\n", disk_state.discard_count);
+    printf("丢弃字节: %lu (%.1f KB)\n",
+           disk_state.bytes_discarded, (double)disk_state.bytes_discarded / 1024);
+    printf("写屏障: %lu次 (无新写入跳过%lu次)\n",
+           disk_state.barrier_count, disk_state.barrier_skipped);
+    elevator_print_stats();
     printf("==================\n\n");
+
+    iostat_print();
 }
@@ -11,13 +11,82 @@
 
 #include "../../include/ext2fs.h"
 
+// ============================================================================
+// 磁盘I/O常量
+// ============================================================================
+#define DISK_DIRECT_ALIGN 4096          // O_DIRECT要求的偏移/长度/地址对齐粒度
+
+#define DISK_STRIPE_SIZE 65536          // 条带后端的默认条带大小
+#define DISK_RESERVE_SIZE ((off_t)1 << 40) // mmap和ram后端为在线扩容预留的地址空间 (只占虚拟地址)
+
+// 向上对齐到O_DIRECT粒度
+#define DISK_ALIGN_UP(x) (((x) + DISK_DIRECT_ALIGN - 1) & ~(off_t)(DISK_DIRECT_ALIGN - 1))
+
+/**
+ * 分散/聚集I/O请求 (disk_readv/disk_writev使用)
+ */
+typedef struct {
+    off_t offset;                       // 磁盘偏移量
+    void *buffer;                       // 数据缓冲区
+    size_t size;                        // 请求大小
+} disk_io_t;
+
 // ============================================================================
 // 磁盘I/O函数
 // ============================================================================
 
+/**
+ * 选择磁盘后端 (须在disk_init之前调用)
+ * @param name 后端名称 ("file"、"mmap"、"ram"、"stripe" 或 "mirror")
+ * @return 成功返回0，未知名称或磁盘已打开返回负数
+ */
+int disk_set_backend(const char *name);
+
+/**
+ * 获取当前磁盘后端
+ * @return 后端名称
+ */
+const char *disk_get_backend(void);
+
+/**
+ * 启用io_uring异步I/O引擎 (须在disk_init之前调用)
+ * 内核不支持时disk_init会自动回退到同步路径
+ * @param enable 是否启用
+ */
+void disk_set_io_uring(bool enable);
+
+/**
+ * 以O_DIRECT方式打开镜像，绕过主机页缓存 (须在disk_init之前调用)
+ * 不对齐的请求由磁盘层经对齐缓冲区池中转，写入时对首尾页做读-改-写
+ * @param enable 是否启用
+ */
+void disk_set_direct_io(bool enable);
+
+/**
+ * 设置条带后端的条带大小 (须在disk_init之前调用)
+ * 新建条带时使用，打开现有条带时必须与创建时一致
+ * @param size 条带大小 (字节，块大小的整数倍，0表示默认值)
+ */
+void disk_set_stripe_size(size_t size);
+
+/**
+ * 设置新建镜像的大小 (须在disk_init之前调用)
+ * 只在镜像不存在而需要新建时使用，打开现有镜像时沿用其实际大小
+ * @param size 镜像大小 (字节，创建时按O_DIRECT粒度向上对齐)
+ */
+void disk_set_image_size(off_t size);
+
+/**
+ * 启用写入队列 (须在disk_init之前调用)
+ * 写入先排队，在disk_sync、丢弃或排队数据过多时按偏移排序、合并相邻和重叠的区域后提交；
+ * 读取会看到尚未提交的写入。映射到内存的后端 (mmap、ram) 忽略此设置
+ * @param enable 是否启用
+ */
+void disk_set_elevator(bool enable);
+
 /**
  * 初始化磁盘I/O系统
- * @param image_path 磁盘镜像文件路径
+ * @param image_path 磁盘镜像文件路径 (条带和镜像后端为以':'分隔的成员列表)
  * @return 成功返回0，失败返回负数
  */
 int disk_init(const char *image_path);
@@ -50,16 +119,63 @@ int disk_read(off_t offset, void *buffer, size_t size);
  * @param offset 偏移量
  * @param buffer 缓冲区
  * @param size 写入大小
- * @return 成功返回实际写入字节数，失败返回负数
+ * @return 成功返回0，失败返回-1
  */
 int disk_write(off_t offset, const void *buffer, size_t size);
 
+/**
+ * 分散读取多个磁盘区域 (区域之间不要求连续)
+ * 文件后端把偏移首尾相接的相邻请求合并为一次preadv；
+ * io_uring引擎可用时一次提交全部请求并批量回收
+ * @param ios 请求数组 (按磁盘偏移排列时合并效果最好)
+ * @param count 请求数量
+ * @return 全部成功返回0，任一失败返回负数
+ */
+int disk_readv(const disk_io_t *ios, int count);
+
+/**
+ * 聚集写入多个磁盘区域 (区域之间不要求连续)
+ * 文件后端把偏移首尾相接的相邻请求合并为一次pwritev
+ * @param ios 请求数组
+ * @param count 请求数量
+ * @return 全部成功返回0，任一失败返回负数
+ */
+int disk_writev(const disk_io_t *ios, int count);
+
+/**
+ * 丢弃磁盘区域，之后读取该区域返回全0
+ * 文件和mmap后端在镜像上打洞 (FALLOC_FL_PUNCH_HOLE)，释放主机存储空间；
+ * 主机文件系统不支持打洞时返回失败，调用者应改为写入全0
+ * @param offset 偏移量
+ * @param size 区域大小
+ * @return 成功返回0，不支持或失败返回负数
+ */
+int disk_discard(off_t offset, size_t size);
+
 /**
  * 同步磁盘数据 (强制写入)
+ * 写入路径不再逐次刷新，持久化统一在此处通过fsync完成
  * @return 成功返回0，失败返回负数
  */
 int disk_sync(void);
 
+/**
+ * 写屏障: 本次调用之前完成的写入 (包括写入队列中排队的) 全部持久化后才返回，
+ * 因此屏障之后的写入不会先于屏障之前的写入落盘。
+ * 只刷新数据 (fdatasync)，且自上次屏障或同步以来没有新写入时不访问设备，
+ * 调用者可以在每个需要排序的位置放心调用
+ * @return 成功返回0，失败返回负数
+ */
+int disk_barrier(void);
+
+/**
+ * 在线扩大磁盘 (挂载期间使用，原有数据和偏移不变，新增区域读取为全0)
+ * 大小按O_DIRECT粒度向上对齐，不大于当前大小时什么也不做
+ * @param size 新的磁盘大小
+ * @return 成功返回0，后端不支持或失败返回负数
+ */
+int disk_resize(off_t size);
+
 /**
  * 获取磁盘大小
  * @return 磁盘大小 (字节)
@@ -72,6 +188,13 @@ off_t disk_get_size(void);
  */
 bool disk_is_open(void);
 
+/**
+ * 检查磁盘镜像是否为本次新建 (需要格式化)
+ * 内存盘每次挂载都是新建的
+ * @return 新建返回true，打开现有镜像返回false
+ */
+bool disk_is_new(void);
+
 /**
  * 清理磁盘I/O系统
  */
@@ -0,0 +1,124 @@
+/*
+ * ============================================================================
+ * 文件名: src/core/disk_backend.h
+ * 描述: 磁盘后端操作表定义
+ * 功能: disk.c通过操作表访问具体的块设备后端 (文件、mmap、内存盘)
+ * ============================================================================
+ */
+
+#ifndef DISK_BACKEND_H
+#define DISK_BACKEND_H
+
+#include "../../include/ext2fs.h"
+#include "disk.h"
+
+// ============================================================================
+// 后端配置
+// ============================================================================
+
+/**
+ * 挂载时传给后端的配置 (由disk_set_*在disk_init之前设置)
+ */
+typedef struct {
+    bool use_uring;                     // 是否尝试启用io_uring引擎
+    bool direct;                        // 是否以O_DIRECT打开镜像
+    size_t stripe_size;                 // 条带大小 (0表示默认值或沿用创建时的值)
+} disk_config_t;
+
+// ============================================================================
+// 后端操作表
+// ============================================================================
+
+/**
+ * 块设备后端操作表
+ * disk.c负责参数检查、统计和脏标记，后端只负责在给定范围内搬运数据。
+ * 可选操作为NULL时由disk.c提供通用实现。
+ */
+typedef struct {
+    const char *name;                   // 后端名称 (挂载选项backend=的取值)
+
+    /**
+     * 检查镜像是否已存在 (可选，NULL时检查路径是否存在)
+     * @return 存在返回true，需要新建返回false
+     */
+    bool (*exists)(const char *path);
+
+    /**
+     * 创建新镜像
+     * @return 成功返回0，失败返回负数
+     */
+    int (*create)(const char *path, off_t size, const disk_config_t *config);
+
+    /**
+     * 打开现有镜像 (可选，NULL表示后端总是新建，如内存盘)
+     * @param size 输出镜像大小
+     * @return 成功返回0，失败返回负数
+     */
+    int (*open)(const char *path, off_t *size, const disk_config_t *config);
+
+    /**
+     * 读取 [offset, offset+size)，范围已由disk.c检查
+     * @return 成功返回size，失败返回负数
+     */
+    ssize_t (*read)(off_t offset, void *buffer, size_t size);
+
+    /**
+     * 写入 [offset, offset+size)，范围已由disk.c检查
+     * @return 成功返回size，失败返回负数
+     */
+    ssize_t (*write)(off_t offset, const void *buffer, size_t size);
+
+    /**
+     * 分散读取多个区域 (可选，NULL时逐个调用read)
+     * @return 全部成功返回0，失败返回负数
+     */
+    int (*readv)(const disk_io_t *ios, int count);
+
+    /**
+     * 聚集写入多个区域 (可选，NULL时逐个调用write)
+     * @return 全部成功返回0，失败返回负数
+     */
+    int (*writev)(const disk_io_t *ios, int count);
+
+    /**
+     * 丢弃区域 (可选)，之后读取该区域必须返回全0，范围已由disk.c检查
+     * @return 成功返回0，后端或主机文件系统不支持时返回负数
+     */
+    int (*discard)(off_t offset, size_t size);
+
+    /**
+     * 持久化已写入的数据
+     * @return 成功返回0，失败返回负数
+     */
+    int (*sync)(void);
+
+    /**
+     * 写屏障 (可选，NULL时调用sync): 之前完成的写入全部落盘后才返回，
+     * 只需保证数据持久，不要求刷新镜像文件的时间戳等元数据 (fdatasync)
+     * @return 成功返回0，失败返回负数
+     */
+    int (*barrier)(void);
+
+    /**
+     * 把镜像扩大到size字节 (可选，NULL表示不支持在线扩容)，新增区域读取为全0。
+     * 扩容期间其他线程可能仍在读写原有范围，原有数据和映射地址都不能移动
+     * @return 成功返回0，失败返回负数
+     */
+    int (*resize)(off_t size);
+
+    /**
+     * 关闭后端并释放资源
+     */
+    void (*close)(void);
+} disk_backend_ops_t;
+
+// ============================================================================
+// 内置后端
+// ============================================================================
+extern const disk_backend_ops_t disk_file_backend;   // src/core/disk_file.c
+extern const disk_backend_ops_t disk_mmap_backend;   // src/core/disk_mmap.c
+extern const disk_backend_ops_t disk_ram_backend;    // src/core/disk_ram.c
+extern const disk_backend_ops_t disk_stripe_backend; // src/core/disk_stripe.c
+extern const disk_backend_ops_t disk_mirror_backend; // src/core/disk_mirror.c
+
+#endif /* DISK_BACKEND_H */
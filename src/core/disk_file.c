@@ -0,0 +1,480 @@
+/*
+ * ============================================================================
+ * 文件名: src/core/disk_file.c
+ * 描述: 文件后端实现
+ * 功能: 通过文件描述符和pread/pwrite访问磁盘镜像，支持O_DIRECT和io_uring
+ * ============================================================================
+ */
+
+#include "disk_backend.h"
+#include "uring.h"
+#include "bufpool.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/uio.h>
+
+// 一次preadv/pwritev最多合并的请求数
+#define FILE_DEV_IOV_MAX 64
+
+// ============================================================================
+// 静态变量
+// ============================================================================
+static struct {
+    int fd;                             // 磁盘文件描述符 (-1表示未打开)
+    bool direct;                        // 是否以O_DIRECT打开
+    bool no_punch;                      // 主机文件系统不支持打洞
+    pthread_mutex_t direct_lock;        // O_DIRECT下串行化写入 (读-改-写不能交错)
+} file_dev_state = { .fd = -1, .direct_lock = PTHREAD_MUTEX_INITIALIZER };
+
+// ============================================================================
+// 内部辅助函数
+// ============================================================================
+
+/**
+ * 按位置完整读取 (处理EINTR和短读，文件末尾之后按0填充)
+ */
+static ssize_t file_dev_pread_full(void *buffer, size_t size, off_t offset) {
+    char *buf = (char *)buffer;
+    size_t done = 0;
+
+    while (done < size) {
+        ssize_t n = pread(file_dev_state.fd, buf + done, size - done, offset + done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0) {
+            // 稀疏镜像的尾部尚未写入，视为全0
+            memset(buf + done, 0, size - done);
+            break;
+        }
+        done += n;
+
+        // O_DIRECT下的短读只发生在文件末尾，且不能从不对齐的位置续读
+        if (file_dev_state.direct && done < size) {
+            memset(buf + done, 0, size - done);
+            break;
+        }
+    }
+
+    return size;
+}
+
+/**
+ * 按位置完整写入 (处理EINTR和短写)
+ */
+static ssize_t file_dev_pwrite_full(const void *buffer, size_t size, off_t offset) {
+    const char *buf = (const char *)buffer;
+    size_t done = 0;
+
+    while (done < size) {
+        ssize_t n = pwrite(file_dev_state.fd, buf + done, size - done, offset + done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        done += n;
+    }
+
+    return done;
+}
+
+/**
+ * 检查请求是否满足O_DIRECT的对齐要求 (偏移、长度和缓冲区地址)
+ */
+static bool file_dev_is_aligned(off_t offset, const void *buffer, size_t size) {
+    return ((offset | (off_t)size | (off_t)(uintptr_t)buffer) & (DISK_DIRECT_ALIGN - 1)) == 0;
+}
+
+/**
+ * 检查批量请求能否原样交给io_uring (O_DIRECT下要求全部对齐)
+ */
+static bool file_dev_batch_aligned(const disk_io_t *ios, int count) {
+    if (!file_dev_state.direct) {
+        return true;
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (!file_dev_is_aligned(ios[i].offset, ios[i].buffer, ios[i].size)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * 对一段连续磁盘区域执行一次preadv/pwritev，短读写的剩余部分逐段补齐
+ */
+static ssize_t file_dev_vector_full(const struct iovec *iov, int iovcnt, off_t offset,
+                                    size_t total, bool write) {
+    ssize_t n;
+    do {
+        n = write ? pwritev(file_dev_state.fd, iov, iovcnt, offset)
+                  : preadv(file_dev_state.fd, iov, iovcnt, offset);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        return -1;
+    }
+
+    // 短读写: 跳过已完成的部分，剩余部分逐段走完整读写路径
+    size_t skip = n;
+    off_t pos = offset;
+    for (int i = 0; i < iovcnt && (size_t)n < total; i++) {
+        size_t len = iov[i].iov_len;
+        if (skip >= len) {
+            skip -= len;
+            pos += len;
+            continue;
+        }
+
+        char *base = (char *)iov[i].iov_base + skip;
+        ssize_t r = write ? file_dev_pwrite_full(base, len - skip, pos + skip)
+                          : file_dev_pread_full(base, len - skip, pos + skip);
+        if (r < 0) {
+            return -1;
+        }
+        skip = 0;
+        pos += len;
+    }
+
+    return total;
+}
+
+/**
+ * 把偏移首尾相接的相邻请求合并为一次preadv/pwritev
+ */
+static int file_dev_vector(const disk_io_t *ios, int count, bool write) {
+    struct iovec iov[FILE_DEV_IOV_MAX];
+    int i = 0;
+
+    while (i < count) {
+        off_t start = ios[i].offset;
+        size_t total = 0;
+        int n = 0;
+
+        do {
+            iov[n].iov_base = ios[i + n].buffer;
+            iov[n].iov_len = ios[i + n].size;
+            total += ios[i + n].size;
+            n++;
+        } while (i + n < count && n < FILE_DEV_IOV_MAX &&
+                 ios[i + n].offset == start + (off_t)total);
+
+        if (file_dev_vector_full(iov, n, start, total, write) < 0) {
+            printf("错误: 向量%s失败 (偏移: %ld, 长度: %zu)\n",
+                   write ? "写入" : "读取", start, total);
+            return -1;
+        }
+        i += n;
+    }
+
+    return 0;
+}
+
+/**
+ * 通过io_uring执行批量请求，短读写的剩余部分走同步路径补齐
+ */
+static int file_dev_uring_batch(const disk_io_t *ios, int count, bool write) {
+    ssize_t *results = malloc(count * sizeof(ssize_t));
+    if (!results) {
+        return -1;
+    }
+
+    if (uring_submit_batch(ios, count, write, results) != 0) {
+        free(results);
+        return -1;
+    }
+
+    int status = 0;
+    for (int i = 0; i < count && status == 0; i++) {
+        ssize_t res = results[i];
+        if (res < 0) {
+            printf("错误: io_uring请求失败 (偏移: %ld, %s)\n", ios[i].offset, strerror(-res));
+            status = -1;
+        } else if ((size_t)res < ios[i].size) {
+            char *buf = (char *)ios[i].buffer + res;
+            size_t rest = ios[i].size - res;
+            off_t offset = ios[i].offset + res;
+            ssize_t n = write ? file_dev_pwrite_full(buf, rest, offset)
+                              : file_dev_pread_full(buf, rest, offset);
+            if (n < 0) {
+                status = -1;
+            }
+        }
+    }
+
+    free(results);
+    return status;
+}
+
+/**
+ * 打开镜像后的公共初始化
+ */
+static int file_dev_setup(const disk_config_t *config) {
+    file_dev_state.direct = config->direct;
+    file_dev_state.no_punch = false;
+
+    if (config->use_uring) {
+        uring_init(file_dev_state.fd, URING_QUEUE_DEPTH);  // 失败时回退到同步路径
+    }
+
+    return 0;
+}
+
+// ============================================================================
+// 后端操作实现
+// ============================================================================
+
+/**
+ * 创建新镜像
+ */
+static int file_dev_create(const char *path, off_t size, const disk_config_t *config) {
+    int flags = O_RDWR | O_CREAT | O_TRUNC | (config->direct ? O_DIRECT : 0);
+    file_dev_state.fd = open(path, flags, 0644);
+    if (file_dev_state.fd < 0) {
+        printf("错误: 无法创建磁盘镜像文件 %s\n", path);
+        return -1;
+    }
+
+    // 设置磁盘大小 (ftruncate只扩展文件长度，不预分配，镜像保持稀疏)
+    if (ftruncate(file_dev_state.fd, size) != 0) {
+        printf("错误: 无法设置磁盘大小\n");
+        close(file_dev_state.fd);
+        file_dev_state.fd = -1;
+        return -1;
+    }
+
+    return file_dev_setup(config);
+}
+
+/**
+ * 打开现有镜像
+ */
+static int file_dev_open(const char *path, off_t *size, const disk_config_t *config) {
+    file_dev_state.fd = open(path, O_RDWR | (config->direct ? O_DIRECT : 0));
+    if (file_dev_state.fd < 0) {
+        printf("错误: 无法打开磁盘镜像文件 %s\n", path);
+        return -1;
+    }
+
+    // 获取文件大小
+    struct stat st;
+    if (fstat(file_dev_state.fd, &st) != 0) {
+        printf("错误: 无法获取磁盘文件大小\n");
+        close(file_dev_state.fd);
+        file_dev_state.fd = -1;
+        return -1;
+    }
+
+    *size = st.st_size;
+    return file_dev_setup(config);
+}
+
+/**
+ * 读取，O_DIRECT下不对齐的请求扩展到对齐范围并经对齐缓冲区中转
+ */
+static ssize_t file_dev_read(off_t offset, void *buffer, size_t size) {
+    if (!file_dev_state.direct || file_dev_is_aligned(offset, buffer, size)) {
+        return file_dev_pread_full(buffer, size, offset);
+    }
+
+    off_t start = offset & ~(off_t)(DISK_DIRECT_ALIGN - 1);
+    size_t length = DISK_ALIGN_UP(offset + (off_t)size) - start;
+    char *bounce = bufpool_get(length);
+    if (!bounce) {
+        return -1;
+    }
+
+    ssize_t result = file_dev_pread_full(bounce, length, start);
+    if (result >= 0) {
+        memcpy(buffer, bounce + (offset - start), size);
+        result = size;
+    }
+
+    bufpool_put(bounce, length);
+    return result;
+}
+
+/**
+ * 写入，O_DIRECT下不对齐的请求对首尾页做读-改-写
+ */
+static ssize_t file_dev_write(off_t offset, const void *buffer, size_t size) {
+    if (!file_dev_state.direct) {
+        return file_dev_pwrite_full(buffer, size, offset);
+    }
+
+    pthread_mutex_lock(&file_dev_state.direct_lock);
+
+    if (file_dev_is_aligned(offset, buffer, size)) {
+        ssize_t result = file_dev_pwrite_full(buffer, size, offset);
+        pthread_mutex_unlock(&file_dev_state.direct_lock);
+        return result;
+    }
+
+    off_t start = offset & ~(off_t)(DISK_DIRECT_ALIGN - 1);
+    off_t end = DISK_ALIGN_UP(offset + (off_t)size);
+    size_t length = end - start;
+    char *bounce = bufpool_get(length);
+    if (!bounce) {
+        pthread_mutex_unlock(&file_dev_state.direct_lock);
+        return -1;
+    }
+
+    // 只需读回被部分覆盖的首页和尾页
+    ssize_t result = 0;
+    if (offset != start) {
+        result = file_dev_pread_full(bounce, DISK_DIRECT_ALIGN, start);
+    }
+    off_t tail = end - DISK_DIRECT_ALIGN;
+    if (result >= 0 && offset + (off_t)size != end && (tail != start || offset == start)) {
+        result = file_dev_pread_full(bounce + (tail - start), DISK_DIRECT_ALIGN, tail);
+    }
+
+    if (result >= 0) {
+        memcpy(bounce + (offset - start), buffer, size);
+        result = file_dev_pwrite_full(bounce, length, start);
+        if (result >= 0) {
+            result = size;
+        }
+    }
+
+    bufpool_put(bounce, length);
+    pthread_mutex_unlock(&file_dev_state.direct_lock);
+    return result;
+}
+
+/**
+ * 分散读取: io_uring可用时一次提交，否则合并连续区域后preadv
+ */
+static int file_dev_readv(const disk_io_t *ios, int count) {
+    bool aligned = file_dev_batch_aligned(ios, count);
+    if (uring_is_available() && aligned) {
+        return file_dev_uring_batch(ios, count, false);
+    }
+    if (aligned) {
+        return file_dev_vector(ios, count, false);
+    }
+
+    // O_DIRECT下存在不对齐的请求，逐个经对齐缓冲区中转
+    for (int i = 0; i < count; i++) {
+        if (file_dev_read(ios[i].offset, ios[i].buffer, ios[i].size) < 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * 聚集写入: io_uring可用时一次提交，否则合并连续区域后pwritev
+ */
+static int file_dev_writev(const disk_io_t *ios, int count) {
+    if (file_dev_batch_aligned(ios, count)) {
+        // O_DIRECT下与不对齐写入的读-改-写互斥
+        if (file_dev_state.direct) {
+            pthread_mutex_lock(&file_dev_state.direct_lock);
+        }
+        int result = uring_is_available() ? file_dev_uring_batch(ios, count, true)
+                                          : file_dev_vector(ios, count, true);
+        if (file_dev_state.direct) {
+            pthread_mutex_unlock(&file_dev_state.direct_lock);
+        }
+        return result;
+    }
+
+    // O_DIRECT下存在不对齐的请求，逐个读-改-写
+    for (int i = 0; i < count; i++) {
+        if (file_dev_write(ios[i].offset, ios[i].buffer, ios[i].size) < 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * 丢弃: 在镜像上打洞，释放主机存储空间
+ */
+static int file_dev_discard(off_t offset, size_t size) {
+    if (file_dev_state.no_punch) {
+        return -1;
+    }
+
+    // O_DIRECT下与读-改-写互斥，避免打洞后被旧数据写回
+    if (file_dev_state.direct) {
+        pthread_mutex_lock(&file_dev_state.direct_lock);
+    }
+    int result = fallocate(file_dev_state.fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                           offset, size);
+    if (file_dev_state.direct) {
+        pthread_mutex_unlock(&file_dev_state.direct_lock);
+    }
+
+    if (result != 0 && (errno == EOPNOTSUPP || errno == ENOSYS)) {
+        file_dev_state.no_punch = true;  // 之后不再尝试
+    }
+    return result;
+}
+
+/**
+ * 持久化: 写入路径不逐次刷新，统一在此fsync
+ */
+static int file_dev_sync(void) {
+    return fsync(file_dev_state.fd);
+}
+
+/**
+ * 写屏障: 镜像大小只在扩容时变化 (扩容时已fsync)，fdatasync即可保证数据持久
+ */
+static int file_dev_barrier(void) {
+    return fdatasync(file_dev_state.fd);
+}
+
+/**
+ * 扩容: 延长镜像文件 (新增部分保持稀疏)，并持久化新的文件长度
+ */
+static int file_dev_resize(off_t size) {
+    if (ftruncate(file_dev_state.fd, size) != 0 || fsync(file_dev_state.fd) != 0) {
+        printf("错误: 无法把磁盘镜像扩大到 %ld 字节\n", size);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * 关闭后端
+ */
+static void file_dev_close(void) {
+    uring_cleanup();
+
+    if (file_dev_state.fd >= 0) {
+        close(file_dev_state.fd);
+        file_dev_state.fd = -1;
+    }
+}
+
+// ============================================================================
+// 后端操作表
+// ============================================================================
+const disk_backend_ops_t disk_file_backend = {
+    .name        = "file",
+    .exists      = NULL,
+    .create      = file_dev_create,
+    .open        = file_dev_open,
+    .read        = file_dev_read,
+    .write       = file_dev_write,
+    .readv       = file_dev_readv,
+    .writev      = file_dev_writev,
+    .discard     = file_dev_discard,
+    .sync        = file_dev_sync,
+    .barrier     = file_dev_barrier,
+    .resize      = file_dev_resize,
+    .close       = file_dev_close,
+};
@@ -0,0 +1,592 @@
+/*
+ * ============================================================================
+ * 文件名: src/core/disk_mirror.c
+ * 描述: 镜像后端实现
+ * 功能: 写入同时落到多个副本 (RAID-1)，读取分散到负载最轻的副本；
+ *       副本丢失时降级运行，挂载时自动重建缺失、过期或未正常关闭的副本
+ * ============================================================================
+ */
+
+#include "disk_backend.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+
+// ============================================================================
+// 镜像常量
+// ============================================================================
+#define MIRROR_MAGIC        0x45324d52  // 副本头魔数 "RM2E"
+#define MIRROR_VERSION      2           // 副本头版本 (版本1没有clean字段，按未正常关闭处理)
+#define MIRROR_HEADER_SIZE  4096        // 副本头占用的空间 (数据区保持4 KiB对齐)
+#define MIRROR_MAX_MEMBERS  8           // 最大副本数
+#define MIRROR_COPY_SIZE    65536       // 重建副本时每次拷贝的大小
+
+/**
+ * 副本头 (位于每个副本文件开头)
+ * events在每次挂载和每次副本失效时递增，较小的副本内容已过期；
+ * clean在打开时清零、正常关闭时置1，为0说明各副本的写入可能只完成了一部分
+ */
+typedef struct {
+    uint32_t magic;                     // 魔数
+    uint32_t version;                   // 副本头版本
+    uint64_t fs_id;                     // 创建时生成的文件系统标识
+    uint32_t member_index;              // 本副本序号
+    uint32_t member_count;              // 副本总数
+    uint64_t disk_size;                 // 逻辑磁盘大小 (字节)
+    uint64_t events;                    // 事件计数
+    uint32_t clean;                     // 是否正常关闭 (1: 各副本内容一致)
+    uint32_t reserved;                  // 保留
+} mirror_header_t;
+
+// ============================================================================
+// 静态变量
+// ============================================================================
+static struct {
+    int fds[MIRROR_MAX_MEMBERS];        // 副本文件描述符 (-1表示缺失)
+    bool healthy[MIRROR_MAX_MEMBERS];   // 副本是否可用
+    int inflight[MIRROR_MAX_MEMBERS];   // 各副本上正在进行的读取数
+    off_t last_offset[MIRROR_MAX_MEMBERS]; // 各副本上一次读取结束的位置
+    int count;                          // 副本数
+    mirror_header_t header;             // 当前副本头 (member_index除外)
+} mirror_dev_state = { .count = 0 };
+
+// ============================================================================
+// 内部辅助函数
+// ============================================================================
+
+/**
+ * 把以':'分隔的副本列表拆分为路径数组
+ * @return 副本数，格式错误返回负数
+ */
+static int mirror_dev_split(const char *list, char paths[][256]) {
+    int count = 0;
+    const char *p = list;
+
+    while (*p) {
+        const char *end = strchr(p, ':');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        if (len == 0 || len >= 256 || count >= MIRROR_MAX_MEMBERS) {
+            printf("错误: 镜像副本列表格式错误 (最多%d个副本): %s\n", MIRROR_MAX_MEMBERS, list);
+            return -1;
+        }
+
+        memcpy(paths[count], p, len);
+        paths[count][len] = '\0';
+        count++;
+        p += len + (end ? 1 : 0);
+    }
+
+    if (count < 2) {
+        printf("错误: 镜像至少需要2个副本: %s\n", list);
+        return -1;
+    }
+
+    return count;
+}
+
+/**
+ * 按位置完整读写 (处理EINTR和短读写，读到文件末尾之后按0填充)
+ */
+static int mirror_dev_io_full(int fd, void *buffer, size_t size, off_t offset, bool write) {
+    char *buf = (char *)buffer;
+    size_t done = 0;
+
+    while (done < size) {
+        ssize_t n = write ? pwrite(fd, buf + done, size - done, offset + done)
+                          : pread(fd, buf + done, size - done, offset + done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0 && !write) {
+            memset(buf + done, 0, size - done);
+            break;
+        }
+        done += n;
+    }
+
+    return 0;
+}
+
+/**
+ * 写入某个副本的副本头
+ */
+static int mirror_dev_write_header(int member) {
+    mirror_header_t header = mirror_dev_state.header;
+    header.member_index = member;
+    return mirror_dev_io_full(mirror_dev_state.fds[member], &header, sizeof(header), 0, true);
+}
+
+/**
+ * 写入某个副本的副本头并落盘
+ */
+static int mirror_dev_commit_header(int member) {
+    if (mirror_dev_write_header(member) != 0 || fsync(mirror_dev_state.fds[member]) != 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+static void mirror_dev_fail(int member);
+
+/**
+ * 把副本头提交到所有可用副本，失败的副本降级
+ */
+static void mirror_dev_commit_headers(void) {
+    for (int i = 0; i < mirror_dev_state.count; i++) {
+        if (__atomic_load_n(&mirror_dev_state.healthy[i], __ATOMIC_RELAXED) &&
+            mirror_dev_commit_header(i) != 0) {
+            mirror_dev_fail(i);
+        }
+    }
+}
+
+/**
+ * 统计可用副本数
+ */
+static int mirror_dev_healthy_count(void) {
+    int healthy = 0;
+    for (int i = 0; i < mirror_dev_state.count; i++) {
+        if (__atomic_load_n(&mirror_dev_state.healthy[i], __ATOMIC_RELAXED)) {
+            healthy++;
+        }
+    }
+
+    return healthy;
+}
+
+/**
+ * 副本I/O失败: 标记为不可用，并在其余副本上递增事件计数，
+ * 使该副本重新接入时被识别为过期
+ */
+static void mirror_dev_fail(int member) {
+    bool expected = true;
+    if (!__atomic_compare_exchange_n(&mirror_dev_state.healthy[member], &expected, false, false,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        return;  // 已被其他线程标记
+    }
+
+    printf("警告: 镜像副本%d I/O失败，进入降级模式 (剩余%d个可用副本)\n",
+           member, mirror_dev_healthy_count());
+
+    // 副本头必须落盘，否则崩溃后失效的副本可能因事件计数相同而被当作最新
+    __atomic_fetch_add(&mirror_dev_state.header.events, 1, __ATOMIC_RELAXED);
+    mirror_dev_commit_headers();
+}
+
+/**
+ * 选择读取副本: 正在进行的读取最少者优先，相同时选上次读取位置离offset最近的
+ */
+static int mirror_dev_pick(off_t offset) {
+    int best = -1;
+    int best_inflight = 0;
+    off_t best_distance = 0;
+
+    for (int i = 0; i < mirror_dev_state.count; i++) {
+        if (!__atomic_load_n(&mirror_dev_state.healthy[i], __ATOMIC_RELAXED)) {
+            continue;
+        }
+
+        int inflight = __atomic_load_n(&mirror_dev_state.inflight[i], __ATOMIC_RELAXED);
+        off_t distance = __atomic_load_n(&mirror_dev_state.last_offset[i], __ATOMIC_RELAXED) - offset;
+        if (distance < 0) {
+            distance = -distance;
+        }
+
+        if (best < 0 || inflight < best_inflight ||
+            (inflight == best_inflight && distance < best_distance)) {
+            best = i;
+            best_inflight = inflight;
+            best_distance = distance;
+        }
+    }
+
+    return best;
+}
+
+/**
+ * 从一个副本拷贝全部数据到另一个副本 (重建)
+ */
+static int mirror_dev_copy(int from, int to) {
+    char *buffer = malloc(MIRROR_COPY_SIZE);
+    if (!buffer) {
+        return -1;
+    }
+
+    off_t end = MIRROR_HEADER_SIZE + (off_t)mirror_dev_state.header.disk_size;
+    int result = 0;
+    for (off_t pos = MIRROR_HEADER_SIZE; pos < end && result == 0; pos += MIRROR_COPY_SIZE) {
+        size_t chunk = end - pos < MIRROR_COPY_SIZE ? (size_t)(end - pos) : MIRROR_COPY_SIZE;
+        result = mirror_dev_io_full(mirror_dev_state.fds[from], buffer, chunk, pos, false);
+        if (result == 0) {
+            result = mirror_dev_io_full(mirror_dev_state.fds[to], buffer, chunk, pos, true);
+        }
+    }
+
+    free(buffer);
+    return result;
+}
+
+/**
+ * 关闭所有副本
+ */
+static void mirror_dev_close_members(void) {
+    for (int i = 0; i < mirror_dev_state.count; i++) {
+        if (mirror_dev_state.fds[i] >= 0) {
+            close(mirror_dev_state.fds[i]);
+            mirror_dev_state.fds[i] = -1;
+        }
+        mirror_dev_state.healthy[i] = false;
+    }
+    mirror_dev_state.count = 0;
+}
+
+/**
+ * 重置副本状态
+ */
+static void mirror_dev_reset(int count) {
+    mirror_dev_state.count = count;
+    for (int i = 0; i < count; i++) {
+        mirror_dev_state.fds[i] = -1;
+        mirror_dev_state.healthy[i] = false;
+        mirror_dev_state.inflight[i] = 0;
+        mirror_dev_state.last_offset[i] = 0;
+    }
+}
+
+// ============================================================================
+// 后端操作实现
+// ============================================================================
+
+/**
+ * 任一副本存在即按现有镜像打开，缺失的副本在打开时重建
+ */
+static bool mirror_dev_exists(const char *path) {
+    char paths[MIRROR_MAX_MEMBERS][256];
+    int count = mirror_dev_split(path, paths);
+
+    for (int i = 0; i < count; i++) {
+        if (access(paths[i], F_OK) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * 创建新镜像: 创建所有副本并写入副本头
+ */
+static int mirror_dev_create(const char *path, off_t size, const disk_config_t *config) {
+    char paths[MIRROR_MAX_MEMBERS][256];
+    int count = mirror_dev_split(path, paths);
+    if (count < 0) {
+        return -1;
+    }
+
+    if (config->direct) {
+        printf("错误: 镜像后端不支持O_DIRECT\n");
+        return -1;
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    mirror_dev_state.header = (mirror_header_t) {
+        .magic = MIRROR_MAGIC,
+        .version = MIRROR_VERSION,
+        .fs_id = ((uint64_t)ts.tv_sec << 32) ^ (uint64_t)ts.tv_nsec ^ ((uint64_t)getpid() << 16),
+        .member_count = count,
+        .disk_size = size,
+        .events = 1,
+    };
+
+    mirror_dev_reset(count);
+    for (int i = 0; i < count; i++) {
+        mirror_dev_state.fds[i] = open(paths[i], O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (mirror_dev_state.fds[i] < 0 ||
+            ftruncate(mirror_dev_state.fds[i], MIRROR_HEADER_SIZE + size) != 0 ||
+            mirror_dev_write_header(i) != 0) {
+            printf("错误: 无法创建镜像副本 %s\n", paths[i]);
+            mirror_dev_close_members();
+            return -1;
+        }
+        mirror_dev_state.healthy[i] = true;
+    }
+
+    printf("镜像创建完成: %d个副本\n", count);
+    return 0;
+}
+
+/**
+ * 打开现有镜像: 校验副本，重建缺失或过期的副本，不可重建时降级运行
+ */
+static int mirror_dev_open(const char *path, off_t *size, const disk_config_t *config) {
+    char paths[MIRROR_MAX_MEMBERS][256];
+    int count = mirror_dev_split(path, paths);
+    if (count < 0) {
+        return -1;
+    }
+
+    if (config->direct) {
+        printf("错误: 镜像后端不支持O_DIRECT\n");
+        return -1;
+    }
+
+    // 读取所有能打开的副本头，以事件计数最大的为准
+    mirror_header_t headers[MIRROR_MAX_MEMBERS];
+    bool valid[MIRROR_MAX_MEMBERS] = {false};
+    int newest = -1;
+
+    mirror_dev_reset(count);
+    for (int i = 0; i < count; i++) {
+        mirror_dev_state.fds[i] = open(paths[i], O_RDWR);
+        if (mirror_dev_state.fds[i] < 0) {
+            printf("警告: 无法打开镜像副本 %s\n", paths[i]);
+            continue;
+        }
+
+        if (pread(mirror_dev_state.fds[i], &headers[i], sizeof(headers[i]), 0) != sizeof(headers[i]) ||
+            headers[i].magic != MIRROR_MAGIC ||
+            (headers[i].version != 1 && headers[i].version != MIRROR_VERSION)) {
+            printf("警告: %s 不是镜像副本，将重建\n", paths[i]);
+            continue;
+        }
+
+        if (headers[i].version == 1) {
+            headers[i].clean = 0;
+        }
+
+        valid[i] = true;
+        if (newest < 0 || headers[i].events > headers[newest].events) {
+            newest = i;
+        }
+    }
+
+    if (newest < 0) {
+        printf("错误: 没有可用的镜像副本\n");
+        mirror_dev_close_members();
+        return -1;
+    }
+
+    mirror_dev_state.header = headers[newest];
+    for (int i = 0; i < count; i++) {
+        if (!valid[i]) {
+            continue;
+        }
+
+        // 不属于同一文件系统的副本不能覆盖 (大小不同的过期副本是扩容前留下的，重建时按新大小)
+        if (headers[i].fs_id != headers[newest].fs_id || headers[i].member_count != (uint32_t)count ||
+            headers[i].member_index != (uint32_t)i ||
+            (headers[i].events == headers[newest].events &&
+             headers[i].disk_size != headers[newest].disk_size)) {
+            printf("错误: 镜像副本 %s 不匹配 (文件系统: %016lx, 序号: %u/%u, 期望: %016lx, %d/%d)\n",
+                   paths[i], headers[i].fs_id, headers[i].member_index, headers[i].member_count,
+                   headers[newest].fs_id, i, count);
+            mirror_dev_close_members();
+            return -1;
+        }
+
+        mirror_dev_state.healthy[i] = headers[i].events == headers[newest].events;
+    }
+
+    // 上次未正常关闭: 事件计数相同的副本也可能只写入了一部分，以newest为准重新同步其余副本
+    bool dirty = false;
+    for (int i = 0; i < count; i++) {
+        if (mirror_dev_state.healthy[i] && !headers[i].clean) {
+            dirty = true;
+        }
+    }
+    if (dirty) {
+        printf("警告: 镜像上次未正常关闭，以副本 %s 为准重新同步\n", paths[newest]);
+        for (int i = 0; i < count; i++) {
+            if (i != newest) {
+                mirror_dev_state.healthy[i] = false;
+            }
+        }
+    }
+
+    // 重建缺失或过期的副本
+    for (int i = 0; i < count; i++) {
+        if (mirror_dev_state.healthy[i]) {
+            continue;
+        }
+
+        if (mirror_dev_state.fds[i] < 0) {
+            mirror_dev_state.fds[i] = open(paths[i], O_RDWR | O_CREAT, 0644);
+        }
+        printf("正在重建镜像副本 %s ...\n", paths[i]);
+        if (mirror_dev_state.fds[i] < 0 ||
+            ftruncate(mirror_dev_state.fds[i], MIRROR_HEADER_SIZE + mirror_dev_state.header.disk_size) != 0 ||
+            mirror_dev_copy(newest, i) != 0 || fsync(mirror_dev_state.fds[i]) != 0) {
+            printf("警告: 无法重建镜像副本 %s，以降级模式运行\n", paths[i]);
+            continue;
+        }
+        mirror_dev_state.healthy[i] = true;
+    }
+
+    // 递增事件计数，使本次未参与的副本下次被识别为过期；
+    // 在第一次写入之前把未正常关闭标记落盘
+    mirror_dev_state.header.events++;
+    mirror_dev_state.header.version = MIRROR_VERSION;
+    mirror_dev_state.header.clean = 0;
+    mirror_dev_commit_headers();
+
+    int healthy = mirror_dev_healthy_count();
+    if (healthy == 0) {
+        printf("错误: 没有可用的镜像副本\n");
+        mirror_dev_close_members();
+        return -1;
+    }
+    if (healthy < count) {
+        printf("警告: 镜像以降级模式运行 (%d/%d个副本可用)\n", healthy, count);
+    }
+
+    *size = mirror_dev_state.header.disk_size;
+    return 0;
+}
+
+/**
+ * 读取: 从负载最轻的副本读取，失败时换下一个副本
+ */
+static ssize_t mirror_dev_read(off_t offset, void *buffer, size_t size) {
+    int member;
+    while ((member = mirror_dev_pick(offset)) >= 0) {
+        __atomic_fetch_add(&mirror_dev_state.inflight[member], 1, __ATOMIC_RELAXED);
+        int result = mirror_dev_io_full(mirror_dev_state.fds[member], buffer, size,
+                                        MIRROR_HEADER_SIZE + offset, false);
+        __atomic_fetch_sub(&mirror_dev_state.inflight[member], 1, __ATOMIC_RELAXED);
+
+        if (result == 0) {
+            __atomic_store_n(&mirror_dev_state.last_offset[member], offset + (off_t)size,
+                             __ATOMIC_RELAXED);
+            return size;
+        }
+        mirror_dev_fail(member);
+    }
+
+    return -1;
+}
+
+/**
+ * 写入: 写到所有可用副本，至少一个成功即算成功
+ */
+static ssize_t mirror_dev_write(off_t offset, const void *buffer, size_t size) {
+    int written = 0;
+    for (int i = 0; i < mirror_dev_state.count; i++) {
+        if (!__atomic_load_n(&mirror_dev_state.healthy[i], __ATOMIC_RELAXED)) {
+            continue;
+        }
+
+        if (mirror_dev_io_full(mirror_dev_state.fds[i], (void *)buffer, size,
+                               MIRROR_HEADER_SIZE + offset, true) == 0) {
+            written++;
+        } else {
+            mirror_dev_fail(i);
+        }
+    }
+
+    return written > 0 ? (ssize_t)size : -1;
+}
+
+/**
+ * 丢弃: 在所有可用副本上打洞
+ */
+static int mirror_dev_discard(off_t offset, size_t size) {
+    for (int i = 0; i < mirror_dev_state.count; i++) {
+        if (mirror_dev_state.healthy[i] &&
+            fallocate(mirror_dev_state.fds[i], FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                      MIRROR_HEADER_SIZE + offset, size) != 0) {
+            return -1;  // 调用者改为写入全0，各副本保持一致
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * 持久化: 同步所有可用副本
+ */
+static int mirror_dev_sync(void) {
+    for (int i = 0; i < mirror_dev_state.count; i++) {
+        if (mirror_dev_state.healthy[i] && fsync(mirror_dev_state.fds[i]) != 0) {
+            mirror_dev_fail(i);
+        }
+    }
+
+    return mirror_dev_healthy_count() > 0 ? 0 : -1;
+}
+
+/**
+ * 写屏障: 对所有可用副本fdatasync，失败的副本降级
+ */
+static int mirror_dev_barrier(void) {
+    for (int i = 0; i < mirror_dev_state.count; i++) {
+        if (mirror_dev_state.healthy[i] && fdatasync(mirror_dev_state.fds[i]) != 0) {
+            mirror_dev_fail(i);
+        }
+    }
+
+    return mirror_dev_healthy_count() > 0 ? 0 : -1;
+}
+
+/**
+ * 扩容: 延长所有可用副本，再以新的大小和事件计数更新副本头
+ * 未能扩大的副本降级，下次挂载时因事件计数较小而按新大小重建
+ */
+static int mirror_dev_resize(off_t size) {
+    for (int i = 0; i < mirror_dev_state.count; i++) {
+        if (mirror_dev_state.healthy[i] &&
+            (ftruncate(mirror_dev_state.fds[i], MIRROR_HEADER_SIZE + size) != 0 ||
+             fsync(mirror_dev_state.fds[i]) != 0)) {
+            mirror_dev_fail(i);
+        }
+    }
+
+    if (mirror_dev_healthy_count() == 0) {
+        printf("错误: 无法扩大任何镜像副本\n");
+        return -1;
+    }
+
+    mirror_dev_state.header.disk_size = size;
+    __atomic_fetch_add(&mirror_dev_state.header.events, 1, __ATOMIC_RELAXED);
+    mirror_dev_commit_headers();
+
+    return mirror_dev_healthy_count() > 0 ? 0 : -1;
+}
+
+/**
+ * 关闭: 同步所有可用副本后标记为正常关闭
+ */
+static void mirror_dev_close(void) {
+    for (int i = 0; i < mirror_dev_state.count; i++) {
+        if (mirror_dev_state.healthy[i] && fsync(mirror_dev_state.fds[i]) != 0) {
+            mirror_dev_fail(i);
+        }
+    }
+
+    mirror_dev_state.header.clean = 1;
+    mirror_dev_commit_headers();
+    mirror_dev_close_members();
+}
+
+// ============================================================================
+// 后端操作表
+// ============================================================================
+const disk_backend_ops_t disk_mirror_backend = {
+    .name        = "mirror",
+    .exists      = mirror_dev_exists,
+    .create      = mirror_dev_create,
+    .open        = mirror_dev_open,
+    .read        = mirror_dev_read,
+    .write       = mirror_dev_write,
+    .readv       = NULL,
+    .writev      = NULL,
+    .discard     = mirror_dev_discard,
+    .sync        = mirror_dev_sync,
+    .barrier     = mirror_dev_barrier,
+    .resize      = mirror_dev_resize,
+    .close       = mirror_dev_close,
+};
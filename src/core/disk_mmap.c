@@ -0,0 +1,231 @@
+/*
+ * ============================================================================
+ * 文件名: src/core/disk_mmap.c
+ * 描述: mmap后端实现
+ * 功能: 将整个磁盘镜像映射到内存，读写为内存拷贝，同步时按脏区msync
+ * ============================================================================
+ */
+
+#include "disk_backend.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+// ============================================================================
+// 静态变量
+// ============================================================================
+static struct {
+    int fd;                             // 磁盘文件描述符 (-1表示未打开)
+    char *map;                          // 映射地址
+    off_t size;                         // 映射大小
+    off_t reserved;                     // 预留的地址空间大小 (扩容时映射原地向后延伸)
+    off_t dirty_lo;                     // 自上次同步以来的脏区起点 (-1表示无脏数据)
+    off_t dirty_hi;                     // 自上次同步以来的脏区终点
+    pthread_mutex_t dirty_lock;         // 保护脏区范围 (起点和终点必须一起更新和取走)
+} mmap_dev_state = { .fd = -1, .dirty_lo = -1, .dirty_lock = PTHREAD_MUTEX_INITIALIZER };
+
+// ============================================================================
+// 内部辅助函数
+// ============================================================================
+
+/**
+ * 建立整个镜像的共享映射
+ */
+static int mmap_dev_map_image(const disk_config_t *config, off_t size) {
+    if (config->direct) {
+        printf("错误: mmap后端不支持O_DIRECT\n");
+        return -1;
+    }
+
+    // 先预留一段不可访问的地址空间，再把镜像映射到开头，扩容时无需移动映射
+    off_t reserved = size > DISK_RESERVE_SIZE ? size : DISK_RESERVE_SIZE;
+    void *base = mmap(NULL, reserved, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    void *map = base == MAP_FAILED ? MAP_FAILED :
+                mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, mmap_dev_state.fd, 0);
+    if (map == MAP_FAILED) {
+        printf("错误: 无法映射磁盘镜像 (大小: %ld 字节)\n", size);
+        if (base != MAP_FAILED) {
+            munmap(base, reserved);
+        }
+        return -1;
+    }
+
+    mmap_dev_state.map = map;
+    mmap_dev_state.size = size;
+    mmap_dev_state.reserved = reserved;
+    mmap_dev_state.dirty_lo = -1;
+    mmap_dev_state.dirty_hi = 0;
+    return 0;
+}
+
+/**
+ * 记录脏区范围，供同步时只msync必要的区间
+ */
+static void mmap_dev_mark_dirty(off_t offset, size_t size) {
+    off_t end = offset + (off_t)size;
+
+    pthread_mutex_lock(&mmap_dev_state.dirty_lock);
+    if (mmap_dev_state.dirty_lo < 0 || offset < mmap_dev_state.dirty_lo) {
+        mmap_dev_state.dirty_lo = offset;
+    }
+    if (end > mmap_dev_state.dirty_hi) {
+        mmap_dev_state.dirty_hi = end;
+    }
+    pthread_mutex_unlock(&mmap_dev_state.dirty_lock);
+}
+
+// ============================================================================
+// 后端操作实现
+// ============================================================================
+
+/**
+ * 创建新镜像并映射
+ */
+static int mmap_dev_create(const char *path, off_t size, const disk_config_t *config) {
+    mmap_dev_state.fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (mmap_dev_state.fd < 0) {
+        printf("错误: 无法创建磁盘镜像文件 %s\n", path);
+        return -1;
+    }
+
+    if (ftruncate(mmap_dev_state.fd, size) != 0 || mmap_dev_map_image(config, size) != 0) {
+        printf("错误: 无法设置磁盘大小\n");
+        close(mmap_dev_state.fd);
+        mmap_dev_state.fd = -1;
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * 打开现有镜像并映射
+ */
+static int mmap_dev_open(const char *path, off_t *size, const disk_config_t *config) {
+    mmap_dev_state.fd = open(path, O_RDWR);
+    if (mmap_dev_state.fd < 0) {
+        printf("错误: 无法打开磁盘镜像文件 %s\n", path);
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(mmap_dev_state.fd, &st) != 0 || mmap_dev_map_image(config, st.st_size) != 0) {
+        close(mmap_dev_state.fd);
+        mmap_dev_state.fd = -1;
+        return -1;
+    }
+
+    *size = st.st_size;
+    return 0;
+}
+
+/**
+ * 读取: 直接从映射中拷贝，无需系统调用
+ */
+static ssize_t mmap_dev_read(off_t offset, void *buffer, size_t size) {
+    memcpy(buffer, mmap_dev_state.map + offset, size);
+    return size;
+}
+
+/**
+ * 写入: 写入映射并记录脏区，落盘推迟到同步
+ */
+static ssize_t mmap_dev_write(off_t offset, const void *buffer, size_t size) {
+    memcpy(mmap_dev_state.map + offset, buffer, size);
+    mmap_dev_mark_dirty(offset, size);
+    return size;
+}
+
+/**
+ * 丢弃: 在镜像上打洞，共享映射中对应的页随之变为全0
+ */
+static int mmap_dev_discard(off_t offset, size_t size) {
+    return fallocate(mmap_dev_state.fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                     offset, size);
+}
+
+/**
+ * 同步: 只msync自上次同步以来写过的页范围
+ */
+static int mmap_dev_sync(void) {
+    pthread_mutex_lock(&mmap_dev_state.dirty_lock);
+    off_t lo = mmap_dev_state.dirty_lo;
+    off_t hi = mmap_dev_state.dirty_hi;
+    mmap_dev_state.dirty_lo = -1;
+    mmap_dev_state.dirty_hi = 0;
+    pthread_mutex_unlock(&mmap_dev_state.dirty_lock);
+    if (lo < 0) {
+        return 0;  // 没有脏数据
+    }
+
+    long page_size = sysconf(_SC_PAGESIZE);
+    off_t start = lo & ~((off_t)page_size - 1);
+    if (msync(mmap_dev_state.map + start, hi - start, MS_SYNC) != 0) {
+        printf("错误: 无法同步磁盘映射 (偏移: %ld, 长度: %ld)\n", start, hi - start);
+        mmap_dev_mark_dirty(lo, hi - lo);  // 保留脏区，下次同步时重试
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * 扩容: 延长镜像文件后把新增部分映射到预留的地址空间
+ * 其他线程可能正在访问映射，原有部分的地址不变
+ */
+static int mmap_dev_resize(off_t size) {
+    if (size > mmap_dev_state.reserved) {
+        printf("错误: 镜像大小超出预留的地址空间 (%ld 字节)\n", mmap_dev_state.reserved);
+        return -1;
+    }
+
+    if (ftruncate(mmap_dev_state.fd, size) != 0 || fsync(mmap_dev_state.fd) != 0) {
+        printf("错误: 无法把磁盘镜像扩大到 %ld 字节\n", size);
+        return -1;
+    }
+
+    // 从原映射末尾所在的页开始重新映射 (该页仍映射到文件的同一位置，内容不变)
+    off_t start = mmap_dev_state.size / sysconf(_SC_PAGESIZE) * sysconf(_SC_PAGESIZE);
+    if (mmap(mmap_dev_state.map + start, size - start, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_FIXED, mmap_dev_state.fd, start) == MAP_FAILED) {
+        printf("错误: 无法扩大镜像映射 (大小: %ld 字节)\n", size);
+        return -1;
+    }
+
+    mmap_dev_state.size = size;
+    return 0;
+}
+
+/**
+ * 解除映射并关闭镜像
+ */
+static void mmap_dev_close(void) {
+    if (mmap_dev_state.map) {
+        munmap(mmap_dev_state.map, mmap_dev_state.reserved);
+        mmap_dev_state.map = NULL;
+    }
+
+    if (mmap_dev_state.fd >= 0) {
+        close(mmap_dev_state.fd);
+        mmap_dev_state.fd = -1;
+    }
+}
+
+// ============================================================================
+// 后端操作表
+// ============================================================================
+const disk_backend_ops_t disk_mmap_backend = {
+    .name        = "mmap",
+    .exists      = NULL,
+    .create      = mmap_dev_create,
+    .open        = mmap_dev_open,
+    .read        = mmap_dev_read,
+    .write       = mmap_dev_write,
+    .readv       = NULL,
+    .writev      = NULL,
+    .discard     = mmap_dev_discard,
+    .sync        = mmap_dev_sync,
+    .barrier     = NULL,
+    .resize      = mmap_dev_resize,
+    .close       = mmap_dev_close,
+};
@@ -0,0 +1,125 @@
+/*
+ * ============================================================================
+ * 文件名: src/core/disk_ram.c
+ * 描述: 内存盘后端实现
+ * 功能: 整个磁盘保存在进程内存中，不产生任何主机I/O，卸载后内容丢弃
+ * ============================================================================
+ */
+
+#include "disk_backend.h"
+#include <sys/mman.h>
+
+// ============================================================================
+// 静态变量
+// ============================================================================
+static struct {
+    char *data;                         // 内存盘数据
+    off_t size;                         // 内存盘大小
+    off_t reserved;                     // 预留的地址空间大小 (扩容时原地向后延伸)
+} ram_dev_state = { .data = NULL };
+
+// ============================================================================
+// 后端操作实现
+// ============================================================================
+
+/**
+ * 创建内存盘 (镜像路径仅用于显示，不访问主机文件)
+ */
+static int ram_dev_create(const char *path, off_t size, const disk_config_t *config) {
+    (void) path;
+    (void) config;  // 没有主机I/O，io_uring和O_DIRECT不适用
+
+    // 预留地址空间后只开放镜像大小的部分: 页面在首次写入时才占用内存，扩容时原地开放更多页
+    off_t reserved = size > DISK_RESERVE_SIZE ? size : DISK_RESERVE_SIZE;
+    void *data = mmap(NULL, reserved, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (data == MAP_FAILED || mprotect(data, size, PROT_READ | PROT_WRITE) != 0) {
+        printf("错误: 无法分配内存盘 (大小: %ld 字节)\n", size);
+        if (data != MAP_FAILED) {
+            munmap(data, reserved);
+        }
+        return -1;
+    }
+
+    ram_dev_state.data = data;
+    ram_dev_state.reserved = reserved;
+
+    ram_dev_state.size = size;
+    return 0;
+}
+
+/**
+ * 读取: 内存拷贝
+ */
+static ssize_t ram_dev_read(off_t offset, void *buffer, size_t size) {
+    memcpy(buffer, ram_dev_state.data + offset, size);
+    return size;
+}
+
+/**
+ * 写入: 内存拷贝
+ */
+static ssize_t ram_dev_write(off_t offset, const void *buffer, size_t size) {
+    memcpy(ram_dev_state.data + offset, buffer, size);
+    return size;
+}
+
+/**
+ * 丢弃: 清零
+ */
+static int ram_dev_discard(off_t offset, size_t size) {
+    memset(ram_dev_state.data + offset, 0, size);
+    return 0;
+}
+
+/**
+ * 同步: 内存盘无需持久化
+ */
+static int ram_dev_sync(void) {
+    return 0;
+}
+
+/**
+ * 扩容: 开放预留地址空间中的后续页面 (原有数据不移动)，新增页面为全0
+ */
+static int ram_dev_resize(off_t size) {
+    off_t start = ram_dev_state.size / sysconf(_SC_PAGESIZE) * sysconf(_SC_PAGESIZE);
+    if (size > ram_dev_state.reserved ||
+        mprotect(ram_dev_state.data + start, size - start, PROT_READ | PROT_WRITE) != 0) {
+        printf("错误: 无法扩大内存盘 (大小: %ld 字节)\n", size);
+        return -1;
+    }
+
+    ram_dev_state.size = size;
+    return 0;
+}
+
+/**
+ * 释放内存盘
+ */
+static void ram_dev_close(void) {
+    if (ram_dev_state.data) {
+        munmap(ram_dev_state.data, ram_dev_state.reserved);
+    }
+    ram_dev_state.data = NULL;
+    ram_dev_state.size = 0;
+    ram_dev_state.reserved = 0;
+}
+
+// ============================================================================
+// 后端操作表
+// ============================================================================
+const disk_backend_ops_t disk_ram_backend = {
+    .name        = "ram",
+    .exists      = NULL,
+    .create      = ram_dev_create,
+    .open        = NULL,                // 每次挂载都是全新的空盘
+    .read        = ram_dev_read,
+    .write       = ram_dev_write,
+    .readv       = NULL,
+    .writev      = NULL,
+    .discard     = ram_dev_discard,
+    .sync        = ram_dev_sync,
+    .barrier     = NULL,
+    .resize      = ram_dev_resize,
+    .close       = ram_dev_close,
+};
@@ -0,0 +1,741 @@
+/*
+ * ============================================================================
+ * 文件名: src/core/disk_stripe.c
+ * 描述: 条带化后端实现
+ * 功能: 把逻辑磁盘按条带轮转分布到多个镜像文件 (RAID-0)，
+ *       镜像路径为以':'分隔的成员列表；跨成员的请求由各成员的工作线程同时执行
+ * ============================================================================
+ */
+
+#include "disk_backend.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/uio.h>
+
+// ============================================================================
+// 条带常量
+// ============================================================================
+#define STRIPE_MAGIC        0x45325354  // 成员头魔数 "TS2E"
+#define STRIPE_VERSION      1           // 成员头版本
+#define STRIPE_HEADER_SIZE  4096        // 成员头占用的空间 (数据区保持4 KiB对齐)
+#define STRIPE_MAX_MEMBERS  16          // 最大成员数
+#define STRIPE_IOV_MAX      64          // 每个成员一次preadv/pwritev最多合并的段数
+
+/**
+ * 成员头 (位于每个成员文件开头)
+ * 挂载时检查所有成员的fs_id、成员数和条带大小一致，且顺序与成员列表相符
+ */
+typedef struct {
+    uint32_t magic;                     // 魔数
+    uint32_t version;                   // 成员头版本
+    uint64_t fs_id;                     // 创建时生成的文件系统标识
+    uint32_t member_index;              // 本成员在条带中的序号
+    uint32_t member_count;              // 成员总数
+    uint64_t stripe_size;               // 条带大小 (字节)
+    uint64_t disk_size;                 // 逻辑磁盘大小 (字节)
+} stripe_header_t;
+
+/**
+ * 某个成员上待提交的连续段
+ */
+typedef struct {
+    off_t offset;                       // 成员内起始偏移 (-1表示空)
+    size_t total;                       // 已合并的字节数
+    int iovcnt;                         // 已合并的段数
+    struct iovec iov[STRIPE_IOV_MAX];   // 段列表
+} stripe_run_t;
+
+/**
+ * 一次请求 (等待分派到各成员的任务全部完成)
+ */
+typedef struct {
+    pthread_mutex_t lock;               // 保护pending和status
+    pthread_cond_t done;                // pending降为0时通知
+    int pending;                        // 未完成的任务数
+    int status;                         // 0表示全部成功
+} stripe_request_t;
+
+/**
+ * 一次请求在某个成员上的任务: 按顺序执行的连续段
+ */
+typedef struct stripe_job {
+    struct stripe_job *next;            // 工作线程队列中的下一个任务
+    stripe_request_t *request;          // 所属请求
+    int member;                         // 成员序号
+    bool write;                         // 是否为写入
+    stripe_run_t *runs;                 // 段数组
+    int run_count;                      // 段数
+    int run_capacity;                   // 段数组容量
+} stripe_job_t;
+
+/**
+ * 成员工作线程 (每个成员一个，串行执行该成员上的任务)
+ */
+typedef struct {
+    pthread_t thread;                   // 线程
+    pthread_mutex_t lock;               // 保护任务队列
+    pthread_cond_t wake;                // 有新任务或需要退出
+    stripe_job_t *head;                 // 任务队列头
+    stripe_job_t *tail;                 // 任务队列尾
+    bool running;                       // 线程是否已启动
+    bool stop;                          // 是否退出
+} stripe_worker_t;
+
+// ============================================================================
+// 静态变量
+// ============================================================================
+static struct {
+    int fds[STRIPE_MAX_MEMBERS];        // 成员文件描述符
+    int count;                          // 成员数
+    off_t stripe_size;                  // 条带大小
+    stripe_worker_t workers[STRIPE_MAX_MEMBERS]; // 各成员的工作线程
+} stripe_dev_state = { .count = 0 };
+
+// ============================================================================
+// 内部辅助函数
+// ============================================================================
+
+/**
+ * 把以':'分隔的成员列表拆分为路径数组
+ * @return 成员数，格式错误返回负数
+ */
+static int stripe_dev_split(const char *list, char paths[][256]) {
+    int count = 0;
+    const char *p = list;
+
+    while (*p) {
+        const char *end = strchr(p, ':');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        if (len == 0 || len >= 256 || count >= STRIPE_MAX_MEMBERS) {
+            printf("错误: 条带成员列表格式错误 (最多%d个成员): %s\n", STRIPE_MAX_MEMBERS, list);
+            return -1;
+        }
+
+        memcpy(paths[count], p, len);
+        paths[count][len] = '\0';
+        count++;
+        p += len + (end ? 1 : 0);
+    }
+
+    if (count < 2) {
+        printf("错误: 条带至少需要2个成员: %s\n", list);
+        return -1;
+    }
+
+    return count;
+}
+
+/**
+ * 把逻辑偏移映射到成员及成员内偏移
+ * @return 从该偏移到条带边界的剩余字节数
+ */
+static size_t stripe_dev_locate(off_t offset, int *member, off_t *member_offset) {
+    off_t stripe = offset / stripe_dev_state.stripe_size;
+    off_t within = offset % stripe_dev_state.stripe_size;
+
+    *member = stripe % stripe_dev_state.count;
+    *member_offset = STRIPE_HEADER_SIZE +
+                     (stripe / stripe_dev_state.count) * stripe_dev_state.stripe_size + within;
+    return stripe_dev_state.stripe_size - within;
+}
+
+/**
+ * 成员文件大小 (成员头 + 分到该成员的条带)
+ */
+static off_t stripe_dev_member_size(off_t disk_size) {
+    off_t stripes = (disk_size + stripe_dev_state.stripe_size - 1) / stripe_dev_state.stripe_size;
+    off_t per_member = (stripes + stripe_dev_state.count - 1) / stripe_dev_state.count;
+    return STRIPE_HEADER_SIZE + per_member * stripe_dev_state.stripe_size;
+}
+
+/**
+ * 生成文件系统标识
+ */
+static uint64_t stripe_dev_new_id(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ((uint64_t)ts.tv_sec << 32) ^ (uint64_t)ts.tv_nsec ^ ((uint64_t)getpid() << 16);
+}
+
+/**
+ * 对一段连续成员区域执行一次preadv/pwritev，短读写的剩余部分逐段补齐
+ */
+static int stripe_dev_flush_run(int member, stripe_run_t *run, bool write) {
+    if (run->iovcnt == 0) {
+        return 0;
+    }
+
+    int fd = stripe_dev_state.fds[member];
+    ssize_t n;
+    do {
+        n = write ? pwritev(fd, run->iov, run->iovcnt, run->offset)
+                  : preadv(fd, run->iov, run->iovcnt, run->offset);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        printf("错误: 条带成员%d %s失败 (偏移: %ld, %s)\n",
+               member, write ? "写入" : "读取", run->offset, strerror(errno));
+        return -1;
+    }
+
+    // 短读写: 跳过已完成的部分，剩余部分逐段完成 (读到文件末尾之后视为全0)
+    size_t skip = n;
+    off_t pos = run->offset;
+    for (int i = 0; i < run->iovcnt && (size_t)n < run->total; i++) {
+        size_t len = run->iov[i].iov_len;
+        if (skip >= len) {
+            skip -= len;
+            pos += len;
+            continue;
+        }
+
+        char *base = (char *)run->iov[i].iov_base;
+        for (size_t done = skip; done < len; ) {
+            ssize_t r = write ? pwrite(fd, base + done, len - done, pos + done)
+                              : pread(fd, base + done, len - done, pos + done);
+            if (r < 0 && errno == EINTR) {
+                continue;
+            }
+            if (r < 0) {
+                return -1;
+            }
+            if (r == 0 && !write) {
+                memset(base + done, 0, len - done);
+                break;
+            }
+            done += r;
+        }
+        skip = 0;
+        pos += len;
+    }
+
+    run->iovcnt = 0;
+    run->total = 0;
+    return 0;
+}
+
+/**
+ * 执行一个成员任务并向所属请求报告结果
+ */
+static void stripe_dev_run_job(stripe_job_t *job) {
+    int status = 0;
+    for (int i = 0; i < job->run_count && status == 0; i++) {
+        status = stripe_dev_flush_run(job->member, &job->runs[i], job->write);
+    }
+
+    stripe_request_t *request = job->request;
+    pthread_mutex_lock(&request->lock);
+    if (status != 0) {
+        request->status = status;
+    }
+    if (--request->pending == 0) {
+        pthread_cond_signal(&request->done);
+    }
+    pthread_mutex_unlock(&request->lock);
+}
+
+/**
+ * 成员工作线程: 依次取出队列中的任务执行
+ */
+static void *stripe_dev_worker(void *arg) {
+    stripe_worker_t *worker = (stripe_worker_t *)arg;
+
+    pthread_mutex_lock(&worker->lock);
+    for (;;) {
+        while (!worker->head && !worker->stop) {
+            pthread_cond_wait(&worker->wake, &worker->lock);
+        }
+        if (!worker->head) {
+            break;  // 队列已清空且需要退出
+        }
+
+        stripe_job_t *job = worker->head;
+        worker->head = job->next;
+        if (!worker->head) {
+            worker->tail = NULL;
+        }
+        pthread_mutex_unlock(&worker->lock);
+
+        stripe_dev_run_job(job);
+        pthread_mutex_lock(&worker->lock);
+    }
+    pthread_mutex_unlock(&worker->lock);
+
+    return NULL;
+}
+
+/**
+ * 把任务交给成员的工作线程，线程未启动时在调用者线程中执行
+ */
+static void stripe_dev_submit_job(stripe_job_t *job) {
+    stripe_worker_t *worker = &stripe_dev_state.workers[job->member];
+    if (!worker->running) {
+        stripe_dev_run_job(job);
+        return;
+    }
+
+    job->next = NULL;
+    pthread_mutex_lock(&worker->lock);
+    if (worker->tail) {
+        worker->tail->next = job;
+    } else {
+        worker->head = job;
+    }
+    worker->tail = job;
+    pthread_cond_signal(&worker->wake);
+    pthread_mutex_unlock(&worker->lock);
+}
+
+/**
+ * 为每个成员启动工作线程 (启动失败的成员退回到在调用者线程中执行)
+ */
+static void stripe_dev_start_workers(void) {
+    for (int i = 0; i < stripe_dev_state.count; i++) {
+        stripe_worker_t *worker = &stripe_dev_state.workers[i];
+        pthread_mutex_init(&worker->lock, NULL);
+        pthread_cond_init(&worker->wake, NULL);
+        worker->head = NULL;
+        worker->tail = NULL;
+        worker->stop = false;
+        worker->running = pthread_create(&worker->thread, NULL, stripe_dev_worker, worker) == 0;
+        if (!worker->running) {
+            printf("警告: 无法启动条带成员%d的工作线程，该成员的I/O在调用者线程中执行\n", i);
+        }
+    }
+}
+
+/**
+ * 停止所有工作线程 (队列中剩余的任务先执行完)
+ */
+static void stripe_dev_stop_workers(void) {
+    for (int i = 0; i < stripe_dev_state.count; i++) {
+        stripe_worker_t *worker = &stripe_dev_state.workers[i];
+        if (!worker->running) {
+            continue;
+        }
+
+        pthread_mutex_lock(&worker->lock);
+        worker->stop = true;
+        pthread_cond_signal(&worker->wake);
+        pthread_mutex_unlock(&worker->lock);
+
+        pthread_join(worker->thread, NULL);
+        pthread_cond_destroy(&worker->wake);
+        pthread_mutex_destroy(&worker->lock);
+        worker->running = false;
+    }
+}
+
+/**
+ * 关闭所有已打开的成员
+ */
+static void stripe_dev_close_members(void) {
+    stripe_dev_stop_workers();
+    for (int i = 0; i < stripe_dev_state.count; i++) {
+        if (stripe_dev_state.fds[i] >= 0) {
+            close(stripe_dev_state.fds[i]);
+            stripe_dev_state.fds[i] = -1;
+        }
+    }
+    stripe_dev_state.count = 0;
+}
+
+/**
+ * 在成员任务末尾追加一个空段
+ * @return 新段，内存不足返回NULL
+ */
+static stripe_run_t *stripe_dev_new_run(stripe_job_t *job, off_t member_offset) {
+    if (job->run_count == job->run_capacity) {
+        int capacity = job->run_capacity ? job->run_capacity * 2 : 1;
+        stripe_run_t *runs = realloc(job->runs, capacity * sizeof(stripe_run_t));
+        if (!runs) {
+            return NULL;
+        }
+        job->runs = runs;
+        job->run_capacity = capacity;
+    }
+
+    stripe_run_t *run = &job->runs[job->run_count++];
+    run->offset = member_offset;
+    run->iovcnt = 0;
+    run->total = 0;
+    return run;
+}
+
+/**
+ * 按条带边界拆分请求，同一成员上连续的段合并为一次preadv/pwritev；
+ * 涉及多个成员时各成员的段由各自的工作线程同时执行，全部完成后返回
+ */
+static int stripe_dev_vector(const disk_io_t *ios, int count, bool write) {
+    stripe_job_t *jobs = calloc(stripe_dev_state.count, sizeof(stripe_job_t));
+    if (!jobs) {
+        return -1;
+    }
+
+    int status = 0;
+    for (int i = 0; i < count && status == 0; i++) {
+        char *buf = (char *)ios[i].buffer;
+        off_t offset = ios[i].offset;
+        size_t remaining = ios[i].size;
+
+        while (remaining > 0) {
+            int member;
+            off_t member_offset;
+            size_t chunk = stripe_dev_locate(offset, &member, &member_offset);
+            if (chunk > remaining) {
+                chunk = remaining;
+            }
+
+            // 与该成员上一段不连续或段已满时另起一段
+            stripe_job_t *job = &jobs[member];
+            stripe_run_t *run = job->run_count > 0 ? &job->runs[job->run_count - 1] : NULL;
+            if (!run || run->offset + (off_t)run->total != member_offset ||
+                run->iovcnt == STRIPE_IOV_MAX) {
+                run = stripe_dev_new_run(job, member_offset);
+                if (!run) {
+                    status = -1;
+                    break;
+                }
+            }
+            run->iov[run->iovcnt].iov_base = buf;
+            run->iov[run->iovcnt].iov_len = chunk;
+            run->iovcnt++;
+            run->total += chunk;
+
+            buf += chunk;
+            offset += chunk;
+            remaining -= chunk;
+        }
+    }
+
+    // 分派各成员的任务: 只涉及一个成员时直接执行，否则最后一个在调用者线程中执行，其余交给工作线程
+    stripe_request_t request = { .pending = 0, .status = status };
+    int last = -1;
+    for (int m = 0; m < stripe_dev_state.count && status == 0; m++) {
+        jobs[m].request = &request;
+        jobs[m].member = m;
+        jobs[m].write = write;
+        if (jobs[m].run_count > 0) {
+            request.pending++;
+            last = m;
+        }
+    }
+
+    if (last >= 0) {
+        pthread_mutex_init(&request.lock, NULL);
+        pthread_cond_init(&request.done, NULL);
+
+        for (int m = 0; m < last; m++) {
+            if (jobs[m].run_count > 0) {
+                stripe_dev_submit_job(&jobs[m]);
+            }
+        }
+        stripe_dev_run_job(&jobs[last]);
+
+        pthread_mutex_lock(&request.lock);
+        while (request.pending > 0) {
+            pthread_cond_wait(&request.done, &request.lock);
+        }
+        pthread_mutex_unlock(&request.lock);
+
+        pthread_cond_destroy(&request.done);
+        pthread_mutex_destroy(&request.lock);
+    }
+
+    for (int m = 0; m < stripe_dev_state.count; m++) {
+        free(jobs[m].runs);
+    }
+    free(jobs);
+    return request.status;
+}
+
+// ============================================================================
+// 后端操作实现
+// ============================================================================
+
+/**
+ * 任一成员存在即按现有条带打开，缺失的成员在打开时报告 (不能当作新条带覆盖其余成员)
+ */
+static bool stripe_dev_exists(const char *path) {
+    char paths[STRIPE_MAX_MEMBERS][256];
+    int count = stripe_dev_split(path, paths);
+
+    for (int i = 0; i < count; i++) {
+        if (access(paths[i], F_OK) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * 创建新条带: 创建所有成员并写入成员头
+ */
+static int stripe_dev_create(const char *path, off_t size, const disk_config_t *config) {
+    char paths[STRIPE_MAX_MEMBERS][256];
+    int count = stripe_dev_split(path, paths);
+    if (count < 0) {
+        return -1;
+    }
+
+    if (config->direct) {
+        printf("错误: 条带后端不支持O_DIRECT\n");
+        return -1;
+    }
+
+    stripe_dev_state.stripe_size = config->stripe_size ? config->stripe_size : DISK_STRIPE_SIZE;
+    if (stripe_dev_state.stripe_size % MIN_BLOCK_SIZE != 0) {
+        printf("错误: 条带大小必须是%d的整数倍\n", MIN_BLOCK_SIZE);
+        return -1;
+    }
+
+    stripe_header_t header = {
+        .magic = STRIPE_MAGIC,
+        .version = STRIPE_VERSION,
+        .fs_id = stripe_dev_new_id(),
+        .member_count = count,
+        .stripe_size = stripe_dev_state.stripe_size,
+        .disk_size = size,
+    };
+
+    stripe_dev_state.count = count;
+    for (int i = 0; i < count; i++) {
+        stripe_dev_state.fds[i] = -1;
+    }
+
+    off_t member_size = stripe_dev_member_size(size);
+    for (int i = 0; i < count; i++) {
+        // 已存在的文件可能是其他条带的成员，不截断
+        stripe_dev_state.fds[i] = open(paths[i], O_RDWR | O_CREAT | O_EXCL, 0644);
+        header.member_index = i;
+        if (stripe_dev_state.fds[i] < 0) {
+            printf("错误: 无法创建条带成员 %s (%s)\n", paths[i], strerror(errno));
+        } else if (ftruncate(stripe_dev_state.fds[i], member_size) != 0 ||
+                   pwrite(stripe_dev_state.fds[i], &header, sizeof(header), 0) != sizeof(header)) {
+            printf("错误: 无法初始化条带成员 %s\n", paths[i]);
+            i++;  // 本成员已由本次创建，一并删除
+        } else {
+            continue;
+        }
+
+        // 删除本次创建的成员，下次挂载不会把不完整的条带当作现有条带
+        stripe_dev_close_members();
+        while (i-- > 0) {
+            unlink(paths[i]);
+        }
+        return -1;
+    }
+
+    stripe_dev_start_workers();
+    printf("条带创建完成: %d个成员, 条带大小 %ld 字节\n", count, stripe_dev_state.stripe_size);
+    return 0;
+}
+
+/**
+ * 打开现有条带并校验所有成员属于同一文件系统
+ */
+static int stripe_dev_open(const char *path, off_t *size, const disk_config_t *config) {
+    char paths[STRIPE_MAX_MEMBERS][256];
+    int count = stripe_dev_split(path, paths);
+    if (count < 0) {
+        return -1;
+    }
+
+    if (config->direct) {
+        printf("错误: 条带后端不支持O_DIRECT\n");
+        return -1;
+    }
+
+    stripe_dev_state.count = count;
+    for (int i = 0; i < count; i++) {
+        stripe_dev_state.fds[i] = -1;
+    }
+
+    stripe_header_t first = {0};
+    for (int i = 0; i < count; i++) {
+        stripe_dev_state.fds[i] = open(paths[i], O_RDWR);
+        if (stripe_dev_state.fds[i] < 0) {
+            printf("错误: 条带成员缺失或无法打开: %s (%s)\n", paths[i], strerror(errno));
+            stripe_dev_close_members();
+            return -1;
+        }
+
+        stripe_header_t header;
+        if (pread(stripe_dev_state.fds[i], &header, sizeof(header), 0) != sizeof(header) ||
+            header.magic != STRIPE_MAGIC || header.version != STRIPE_VERSION) {
+            printf("错误: %s 不是条带成员\n", paths[i]);
+            stripe_dev_close_members();
+            return -1;
+        }
+
+        if (i == 0) {
+            first = header;
+        }
+        if (header.fs_id != first.fs_id || header.member_count != (uint32_t)count ||
+            header.member_index != (uint32_t)i || header.stripe_size != first.stripe_size) {
+            printf("错误: 条带成员 %s 不匹配 (文件系统: %016lx, 序号: %u/%u, 期望: %016lx, %d/%d)\n",
+                   paths[i], header.fs_id, header.member_index, header.member_count,
+                   first.fs_id, i, count);
+            stripe_dev_close_members();
+            return -1;
+        }
+
+        // 扩容时先延长所有成员再逐个更新成员头，中途崩溃时取最小的大小
+        // (超级块在所有成员头更新之后才提交，仍描述扩容前的大小)
+        if (header.disk_size < first.disk_size) {
+            first.disk_size = header.disk_size;
+        }
+    }
+
+    if (config->stripe_size && (uint64_t)config->stripe_size != first.stripe_size) {
+        printf("错误: 条带大小 %zu 与创建时的 %lu 不一致\n", config->stripe_size, first.stripe_size);
+        stripe_dev_close_members();
+        return -1;
+    }
+
+    stripe_dev_state.stripe_size = first.stripe_size;
+    stripe_dev_start_workers();
+    *size = first.disk_size;
+    return 0;
+}
+
+/**
+ * 读取: 按条带拆分到各成员
+ */
+static ssize_t stripe_dev_read(off_t offset, void *buffer, size_t size) {
+    disk_io_t io = { .offset = offset, .buffer = buffer, .size = size };
+    return stripe_dev_vector(&io, 1, false) == 0 ? (ssize_t)size : -1;
+}
+
+/**
+ * 写入: 按条带拆分到各成员
+ */
+static ssize_t stripe_dev_write(off_t offset, const void *buffer, size_t size) {
+    disk_io_t io = { .offset = offset, .buffer = (void *)buffer, .size = size };
+    return stripe_dev_vector(&io, 1, true) == 0 ? (ssize_t)size : -1;
+}
+
+/**
+ * 分散读取
+ */
+static int stripe_dev_readv(const disk_io_t *ios, int count) {
+    return stripe_dev_vector(ios, count, false);
+}
+
+/**
+ * 聚集写入
+ */
+static int stripe_dev_writev(const disk_io_t *ios, int count) {
+    return stripe_dev_vector(ios, count, true);
+}
+
+/**
+ * 丢弃: 在各成员对应的区域上打洞
+ */
+static int stripe_dev_discard(off_t offset, size_t size) {
+    while (size > 0) {
+        int member;
+        off_t member_offset;
+        size_t chunk = stripe_dev_locate(offset, &member, &member_offset);
+        if (chunk > size) {
+            chunk = size;
+        }
+
+        if (fallocate(stripe_dev_state.fds[member], FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                      member_offset, chunk) != 0) {
+            return -1;
+        }
+        offset += chunk;
+        size -= chunk;
+    }
+
+    return 0;
+}
+
+/**
+ * 持久化: 同步所有成员
+ */
+static int stripe_dev_sync(void) {
+    int result = 0;
+    for (int i = 0; i < stripe_dev_state.count; i++) {
+        if (fsync(stripe_dev_state.fds[i]) != 0) {
+            result = -1;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * 写屏障: 对所有成员fdatasync
+ */
+static int stripe_dev_barrier(void) {
+    int result = 0;
+    for (int i = 0; i < stripe_dev_state.count; i++) {
+        if (fdatasync(stripe_dev_state.fds[i]) != 0) {
+            result = -1;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * 扩容: 先延长所有成员，再更新各成员头中记录的逻辑磁盘大小
+ */
+static int stripe_dev_resize(off_t size) {
+    off_t member_size = stripe_dev_member_size(size);
+    for (int i = 0; i < stripe_dev_state.count; i++) {
+        if (ftruncate(stripe_dev_state.fds[i], member_size) != 0 ||
+            fsync(stripe_dev_state.fds[i]) != 0) {
+            printf("错误: 无法扩大条带成员%d\n", i);
+            return -1;
+        }
+    }
+
+    for (int i = 0; i < stripe_dev_state.count; i++) {
+        stripe_header_t header;
+        if (pread(stripe_dev_state.fds[i], &header, sizeof(header), 0) != sizeof(header)) {
+            printf("错误: 无法读取条带成员%d的成员头\n", i);
+            return -1;
+        }
+
+        header.disk_size = size;
+        if (pwrite(stripe_dev_state.fds[i], &header, sizeof(header), 0) != sizeof(header) ||
+            fsync(stripe_dev_state.fds[i]) != 0) {
+            printf("错误: 无法更新条带成员%d的成员头\n", i);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * 关闭所有成员
+ */
+static void stripe_dev_close(void) {
+    stripe_dev_close_members();
+}
+
+// ============================================================================
+// 后端操作表
+// ============================================================================
+const disk_backend_ops_t disk_stripe_backend = {
+    .name        = "stripe",
+    .exists      = stripe_dev_exists,
+    .create      = stripe_dev_create,
+    .open        = stripe_dev_open,
+    .read        = stripe_dev_read,
+    .write       = stripe_dev_write,
+    .readv       = stripe_dev_readv,
+    .writev      = stripe_dev_writev,
+    .discard     = stripe_dev_discard,
+    .sync        = stripe_dev_sync,
+    .barrier     = stripe_dev_barrier,
+    .resize      = stripe_dev_resize,
+    .close       = stripe_dev_close,
+};
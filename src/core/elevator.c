@@ -0,0 +1,302 @@
+/*
+ * ============================================================================
+ * 文件名: src/core/elevator.c
+ * 描述: 写入调度 (电梯) 模块实现
+ * 功能: 写入先进入队列，同步时按偏移排序、合并后以少量大块顺序写提交
+ * ============================================================================
+ */
+
+#include "elevator.h"
+#include <pthread.h>
+
+// ============================================================================
+// 队列结构
+// ============================================================================
+
+/**
+ * 排队的写入请求
+ */
+typedef struct {
+    off_t offset;                       // 磁盘偏移量
+    size_t size;                        // 大小
+    uint64_t seq;                       // 入队序号 (重叠时序号大的数据优先)
+    char *data;                         // 数据拷贝
+} elevator_req_t;
+
+// ============================================================================
+// 静态变量
+// ============================================================================
+static struct {
+    bool enabled;                       // 是否启用
+    pthread_rwlock_t lock;              // 读取持读锁，入队和提交持写锁
+    elevator_req_t *reqs;               // 按入队顺序排列的请求
+    int count;                          // 请求数
+    int capacity;                       // 数组容量
+    size_t pending_bytes;               // 排队数据总量
+    uint64_t seq;                       // 下一个入队序号
+    uint64_t queued;                    // 统计: 入队的写入数
+    uint64_t submitted;                 // 统计: 合并后提交的写入数
+    uint64_t flushes;                   // 统计: 提交次数
+} elevator_state = { .lock = PTHREAD_RWLOCK_INITIALIZER };
+
+// ============================================================================
+// 内部辅助函数
+// ============================================================================
+
+/**
+ * 按偏移排序，偏移相同时按入队顺序
+ */
+static int elevator_compare_offset(const void *a, const void *b) {
+    const elevator_req_t *x = *(const elevator_req_t * const *)a;
+    const elevator_req_t *y = *(const elevator_req_t * const *)b;
+
+    if (x->offset != y->offset) {
+        return x->offset < y->offset ? -1 : 1;
+    }
+    return x->seq < y->seq ? -1 : (x->seq > y->seq);
+}
+
+/**
+ * 按入队顺序排序
+ */
+static int elevator_compare_seq(const void *a, const void *b) {
+    const elevator_req_t *x = *(const elevator_req_t * const *)a;
+    const elevator_req_t *y = *(const elevator_req_t * const *)b;
+
+    return x->seq < y->seq ? -1 : (x->seq > y->seq);
+}
+
+/**
+ * 把请求中与 [offset, offset+size) 重叠的部分复制到buffer
+ */
+static void elevator_overlay(const elevator_req_t *req, off_t offset, char *buffer, size_t size) {
+    off_t start = req->offset > offset ? req->offset : offset;
+    off_t end = req->offset + (off_t)req->size;
+    if (end > offset + (off_t)size) {
+        end = offset + size;
+    }
+
+    if (start < end) {
+        memcpy(buffer + (start - offset), req->data + (start - req->offset), end - start);
+    }
+}
+
+/**
+ * 释放所有排队的请求 (调用者持有写锁)
+ */
+static void elevator_clear(void) {
+    for (int i = 0; i < elevator_state.count; i++) {
+        free(elevator_state.reqs[i].data);
+    }
+    elevator_state.count = 0;
+    elevator_state.pending_bytes = 0;
+}
+
+// ============================================================================
+// 电梯函数实现
+// ============================================================================
+
+/**
+ * 初始化写入队列
+ */
+int elevator_init(void) {
+    elevator_state.capacity = 64;
+    elevator_state.reqs = malloc(elevator_state.capacity * sizeof(elevator_req_t));
+    if (!elevator_state.reqs) {
+        printf("错误: 无法分配写入队列\n");
+        return -1;
+    }
+
+    elevator_state.count = 0;
+    elevator_state.pending_bytes = 0;
+    elevator_state.queued = 0;
+    elevator_state.submitted = 0;
+    elevator_state.flushes = 0;
+    elevator_state.enabled = true;
+    return 0;
+}
+
+/**
+ * 检查写入队列是否启用
+ */
+bool elevator_enabled(void) {
+    return elevator_state.enabled;
+}
+
+/**
+ * 把一次写入加入队列
+ */
+int elevator_queue(off_t offset, const void *buffer, size_t size) {
+    char *data = malloc(size);
+    if (!data) {
+        return -1;
+    }
+    memcpy(data, buffer, size);
+
+    pthread_rwlock_wrlock(&elevator_state.lock);
+
+    if (elevator_state.count == elevator_state.capacity) {
+        int capacity = elevator_state.capacity * 2;
+        elevator_req_t *reqs = realloc(elevator_state.reqs, capacity * sizeof(elevator_req_t));
+        if (!reqs) {
+            pthread_rwlock_unlock(&elevator_state.lock);
+            free(data);
+            return -1;
+        }
+        elevator_state.reqs = reqs;
+        elevator_state.capacity = capacity;
+    }
+
+    elevator_req_t *req = &elevator_state.reqs[elevator_state.count++];
+    req->offset = offset;
+    req->size = size;
+    req->seq = elevator_state.seq++;
+    req->data = data;
+    elevator_state.pending_bytes += size;
+    elevator_state.queued++;
+
+    bool full = elevator_state.pending_bytes >= ELEVATOR_MAX_BYTES;
+    pthread_rwlock_unlock(&elevator_state.lock);
+
+    return full ? 1 : 0;
+}
+
+/**
+ * 读取并覆盖尚未提交的数据
+ */
+int elevator_readv(const disk_io_t *ios, int count,
+                   int (*readv)(const disk_io_t *ios, int count)) {
+    pthread_rwlock_rdlock(&elevator_state.lock);
+
+    int result = readv(ios, count);
+    if (result == 0) {
+        // 按入队顺序覆盖，后写入的数据最终生效
+        for (int r = 0; r < elevator_state.count; r++) {
+            for (int i = 0; i < count; i++) {
+                elevator_overlay(&elevator_state.reqs[r], ios[i].offset, ios[i].buffer, ios[i].size);
+            }
+        }
+    }
+
+    pthread_rwlock_unlock(&elevator_state.lock);
+    return result;
+}
+
+/**
+ * 提交队列
+ */
+int elevator_flush(int (*writev)(const disk_io_t *ios, int count)) {
+    pthread_rwlock_wrlock(&elevator_state.lock);
+
+    int count = elevator_state.count;
+    if (count == 0) {
+        pthread_rwlock_unlock(&elevator_state.lock);
+        return 0;
+    }
+
+    // 按偏移排序的请求指针 (请求数组本身保持入队顺序，供读取覆盖使用)
+    elevator_req_t **order = malloc(count * sizeof(elevator_req_t *));
+    disk_io_t *ios = malloc(count * sizeof(disk_io_t));
+    char **merged = malloc(count * sizeof(char *));
+    if (!order || !ios || !merged) {
+        free(order);
+        free(ios);
+        free(merged);
+        pthread_rwlock_unlock(&elevator_state.lock);
+        return -1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        order[i] = &elevator_state.reqs[i];
+    }
+    qsort(order, count, sizeof(elevator_req_t *), elevator_compare_offset);
+
+    // 合并相邻或重叠的请求
+    int io_count = 0;
+    int merged_count = 0;
+    int status = 0;
+    for (int i = 0; i < count && status == 0; ) {
+        off_t start = order[i]->offset;
+        off_t end = start + (off_t)order[i]->size;
+        int j = i + 1;
+        while (j < count && order[j]->offset <= end) {
+            off_t req_end = order[j]->offset + (off_t)order[j]->size;
+            if (req_end > end) {
+                end = req_end;
+            }
+            j++;
+        }
+
+        ios[io_count].offset = start;
+        ios[io_count].size = end - start;
+        if (j - i == 1) {
+            ios[io_count].buffer = order[i]->data;
+        } else {
+            char *buffer = malloc(end - start);
+            if (!buffer) {
+                status = -1;
+                break;
+            }
+
+            // 组内按入队顺序拷贝，后写入的数据覆盖先写入的
+            qsort(order + i, j - i, sizeof(elevator_req_t *), elevator_compare_seq);
+            for (int k = i; k < j; k++) {
+                memcpy(buffer + (order[k]->offset - start), order[k]->data, order[k]->size);
+            }
+            merged[merged_count++] = buffer;
+            ios[io_count].buffer = buffer;
+        }
+        io_count++;
+        i = j;
+    }
+
+    if (status == 0) {
+        status = writev(ios, io_count);
+    }
+
+    if (status == 0) {
+        elevator_state.submitted += io_count;
+        elevator_state.flushes++;
+        elevator_clear();
+    }
+
+    for (int i = 0; i < merged_count; i++) {
+        free(merged[i]);
+    }
+    free(merged);
+    free(ios);
+    free(order);
+
+    pthread_rwlock_unlock(&elevator_state.lock);
+    return status;
+}
+
+/**
+ * 打印写入队列统计信息
+ */
+void elevator_print_stats(void) {
+    if (!elevator_state.enabled) {
+        return;
+    }
+
+    printf("写入队列: 入队%lu次写入，合并为%lu次提交 (共提交%lu批)\n",
+           elevator_state.queued, elevator_state.submitted, elevator_state.flushes);
+}
+
+/**
+ * 释放写入队列
+ */
+void elevator_cleanup(void) {
+    pthread_rwlock_wrlock(&elevator_state.lock);
+
+    if (elevator_state.count > 0) {
+        printf("警告: 写入队列中仍有%d个未提交的写入被丢弃\n", elevator_state.count);
+    }
+    elevator_clear();
+    free(elevator_state.reqs);
+    elevator_state.reqs = NULL;
+    elevator_state.capacity = 0;
+    elevator_state.enabled = false;
+
+    pthread_rwlock_unlock(&elevator_state.lock);
+}
@@ -0,0 +1,73 @@
+/*
+ * ============================================================================
+ * 文件名: src/core/elevator.h
+ * 描述: 写入调度 (电梯) 模块头文件
+ * 功能: 缓存待写入的请求，提交前按镜像偏移排序并合并相邻或重叠的区域
+ * ============================================================================
+ */
+
+#ifndef ELEVATOR_H
+#define ELEVATOR_H
+
+#include "../../include/ext2fs.h"
+#include "disk.h"
+
+// ============================================================================
+// 电梯常量
+// ============================================================================
+#define ELEVATOR_MAX_BYTES (4 * 1024 * 1024)    // 排队数据达到此大小时提前提交
+
+// ============================================================================
+// 电梯函数
+// ============================================================================
+
+/**
+ * 初始化写入队列
+ * @return 成功返回0，失败返回负数
+ */
+int elevator_init(void);
+
+/**
+ * 检查写入队列是否启用
+ * @return 启用返回true
+ */
+bool elevator_enabled(void);
+
+/**
+ * 把一次写入加入队列 (拷贝数据)
+ * @param offset 偏移量
+ * @param buffer 数据
+ * @param size 大小
+ * @return 成功返回0，排队数据已超过上限 (调用者应提交) 返回1，失败返回负数
+ */
+int elevator_queue(off_t offset, const void *buffer, size_t size);
+
+/**
+ * 读取: 先从后端读取，再用队列中尚未提交的数据覆盖重叠部分
+ * 读取期间持有读锁，不会与提交交错
+ * @param ios 请求数组
+ * @param count 请求数量
+ * @param readv 后端读取函数
+ * @return 后端读取的返回值
+ */
+int elevator_readv(const disk_io_t *ios, int count,
+                   int (*readv)(const disk_io_t *ios, int count));
+
+/**
+ * 提交队列: 按偏移排序，合并相邻或重叠的区域 (后写入的数据优先) 后一次提交
+ * @param writev 后端写入函数
+ * @return 成功返回0，失败返回负数 (队列保留，下次重试)
+ */
+int elevator_flush(int (*writev)(const disk_io_t *ios, int count));
+
+/**
+ * 打印写入队列统计信息
+ */
+void elevator_print_stats(void);
+
+/**
+ * 释放写入队列 (调用前应先提交)
+ */
+void elevator_cleanup(void);
+
+#endif /* ELEVATOR_H */
@@ -0,0 +1,342 @@
+/*
+ * ============================================================================
+ * 文件名: src/core/iostat.c
+ * 描述: I/O延迟统计模块实现
+ * 功能: 每个线程写自己的统计分片 (无锁)，查询时汇总所有分片
+ * ============================================================================
+ */
+
+#include "iostat.h"
+#include <pthread.h>
+#include <stdarg.h>
+
+// ============================================================================
+// 统计分片
+// ============================================================================
+
+/**
+ * 单个线程的统计分片
+ * 只有所属线程写入 (relaxed原子加)，汇总和清零可在任意线程进行
+ */
+typedef struct iostat_shard {
+    uint64_t latency[IOSTAT_OP_COUNT][IOSTAT_BUCKETS];  // 延迟分布 (纳秒)
+    uint64_t size[IOSTAT_OP_COUNT][IOSTAT_BUCKETS];     // 请求大小分布 (字节)
+    uint64_t total_ns[IOSTAT_OP_COUNT];                 // 累计延迟
+    uint64_t depth[IOSTAT_BUCKETS];                     // 磁盘队列深度分布
+    struct iostat_shard *next;                          // 分片链表
+} iostat_shard_t;
+
+// 操作名称
+static const char *iostat_op_names[IOSTAT_OP_COUNT] = {
+    "read", "write", "sync", "discard", "file_read", "file_write",
+};
+
+// ============================================================================
+// 静态变量
+// ============================================================================
+static iostat_shard_t *iostat_shards = NULL;    // 所有线程的分片 (只增不减)
+static __thread iostat_shard_t *iostat_local;   // 当前线程的分片
+static int iostat_inflight = 0;                 // 进行中的磁盘请求数
+
+// ============================================================================
+// 内部辅助函数
+// ============================================================================
+
+/**
+ * 获取当前线程的分片，首次调用时分配并无锁地挂入链表
+ * 线程退出后分片保留，其计数仍计入汇总
+ */
+static iostat_shard_t *iostat_shard(void) {
+    if (iostat_local) {
+        return iostat_local;
+    }
+
+    iostat_shard_t *shard = calloc(1, sizeof(iostat_shard_t));
+    if (!shard) {
+        return NULL;
+    }
+
+    shard->next = __atomic_load_n(&iostat_shards, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&iostat_shards, &shard->next, shard, true,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+
+    iostat_local = shard;
+    return shard;
+}
+
+/**
+ * 计算数值所在的对数桶 (0单独一桶)
+ */
+static int iostat_bucket(uint64_t value) {
+    if (value == 0) {
+        return 0;
+    }
+
+    int bucket = 64 - __builtin_clzll(value);
+    return bucket < IOSTAT_BUCKETS ? bucket : IOSTAT_BUCKETS - 1;
+}
+
+/**
+ * 桶的上界 (不含)
+ */
+static uint64_t iostat_bucket_limit(int bucket) {
+    return bucket >= 63 ? UINT64_MAX : (uint64_t)1 << bucket;
+}
+
+/**
+ * 向报告追加格式化文本，超出缓冲区时截断
+ */
+static void iostat_append(char *buffer, size_t size, size_t *length, const char *format, ...) {
+    if (*length + 1 >= size) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buffer + *length, size - *length, format, args);
+    va_end(args);
+
+    if (n > 0) {
+        *length += (size_t)n < size - *length ? (size_t)n : size - *length - 1;
+    }
+}
+
+/**
+ * 格式化时间 (纳秒)
+ */
+static void iostat_format_ns(uint64_t ns, char *out, size_t size) {
+    if (ns < 1000) {
+        snprintf(out, size, "%luns", ns);
+    } else if (ns < 1000000) {
+        snprintf(out, size, "%.1fus", ns / 1e3);
+    } else {
+        snprintf(out, size, "%.1fms", ns / 1e6);
+    }
+}
+
+/**
+ * 格式化字节数
+ */
+static void iostat_format_bytes(uint64_t bytes, char *out, size_t size) {
+    if (bytes < 1024) {
+        snprintf(out, size, "%luB", bytes);
+    } else if (bytes < 1024 * 1024) {
+        snprintf(out, size, "%luK", bytes / 1024);
+    } else {
+        snprintf(out, size, "%luM", bytes / (1024 * 1024));
+    }
+}
+
+/**
+ * 在汇总后的分布中求百分位数所在桶的上界
+ */
+static uint64_t iostat_percentile(const uint64_t *hist, uint64_t count, double fraction) {
+    uint64_t target = (uint64_t)(count * fraction);
+    if (target >= count) {
+        target = count - 1;
+    }
+
+    uint64_t seen = 0;
+    for (int b = 0; b < IOSTAT_BUCKETS; b++) {
+        seen += hist[b];
+        if (seen > target) {
+            return b == 0 ? 0 : iostat_bucket_limit(b);
+        }
+    }
+
+    return iostat_bucket_limit(IOSTAT_BUCKETS - 1);
+}
+
+/**
+ * 追加一个分布的非空桶
+ */
+static void iostat_append_hist(char *buffer, size_t size, size_t *length, const uint64_t *hist,
+                               void (*format_value)(uint64_t, char *, size_t)) {
+    for (int b = 0; b < IOSTAT_BUCKETS; b++) {
+        if (hist[b] == 0) {
+            continue;
+        }
+
+        char low[24], high[24];
+        format_value(b == 0 ? 0 : iostat_bucket_limit(b - 1), low, sizeof(low));
+        format_value(iostat_bucket_limit(b), high, sizeof(high));
+        iostat_append(buffer, size, length, "    [%8s, %8s)  %lu\n", low, high, hist[b]);
+    }
+}
+
+/**
+ * 以数值本身格式化 (队列深度)
+ */
+static void iostat_format_count(uint64_t value, char *out, size_t size) {
+    snprintf(out, size, "%lu", value);
+}
+
+// ============================================================================
+// 统计函数实现
+// ============================================================================
+
+/**
+ * 开始一次计时
+ */
+uint64_t iostat_start(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * 结束一次计时并记录
+ */
+void iostat_record(iostat_op_t op, uint64_t start, size_t bytes) {
+    iostat_shard_t *shard = iostat_shard();
+    if (!shard) {
+        return;
+    }
+
+    uint64_t elapsed = iostat_start() - start;
+    __atomic_fetch_add(&shard->latency[op][iostat_bucket(elapsed)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&shard->size[op][iostat_bucket(bytes)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&shard->total_ns[op], elapsed, __ATOMIC_RELAXED);
+}
+
+/**
+ * 开始一次磁盘请求
+ */
+uint64_t iostat_disk_begin(void) {
+    int depth = __atomic_add_fetch(&iostat_inflight, 1, __ATOMIC_RELAXED);
+
+    iostat_shard_t *shard = iostat_shard();
+    if (shard) {
+        __atomic_fetch_add(&shard->depth[iostat_bucket(depth)], 1, __ATOMIC_RELAXED);
+    }
+
+    return iostat_start();
+}
+
+/**
+ * 结束一次磁盘请求
+ */
+void iostat_disk_end(iostat_op_t op, uint64_t start, size_t bytes) {
+    iostat_record(op, start, bytes);
+    __atomic_fetch_sub(&iostat_inflight, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * 把所有线程的统计汇总为文本报告
+ */
+size_t iostat_format(char *buffer, size_t size) {
+    static uint64_t latency[IOSTAT_OP_COUNT][IOSTAT_BUCKETS];
+    static uint64_t sizes[IOSTAT_OP_COUNT][IOSTAT_BUCKETS];
+    static uint64_t total_ns[IOSTAT_OP_COUNT];
+    static uint64_t depth[IOSTAT_BUCKETS];
+    static pthread_mutex_t format_lock = PTHREAD_MUTEX_INITIALIZER;
+
+    // 汇总缓冲区较大，放在静态区并串行化查询
+    pthread_mutex_lock(&format_lock);
+    memset(latency, 0, sizeof(latency));
+    memset(sizes, 0, sizeof(sizes));
+    memset(total_ns, 0, sizeof(total_ns));
+    memset(depth, 0, sizeof(depth));
+
+    for (iostat_shard_t *shard = __atomic_load_n(&iostat_shards, __ATOMIC_ACQUIRE);
+         shard; shard = shard->next) {
+        for (int op = 0; op < IOSTAT_OP_COUNT; op++) {
+            for (int b = 0; b < IOSTAT_BUCKETS; b++) {
+                latency[op][b] += __atomic_load_n(&shard->latency[op][b], __ATOMIC_RELAXED);
+                sizes[op][b] += __atomic_load_n(&shard->size[op][b], __ATOMIC_RELAXED);
+            }
+            total_ns[op] += __atomic_load_n(&shard->total_ns[op], __ATOMIC_RELAXED);
+        }
+        for (int b = 0; b < IOSTAT_BUCKETS; b++) {
+            depth[b] += __atomic_load_n(&shard->depth[b], __ATOMIC_RELAXED);
+        }
+    }
+
+    size_t length = 0;
+    buffer[0] = '\0';
+    iostat_append(buffer, size, &length, "=== I/O延迟统计 ===\n");
+    // 每个汉字占3字节、显示2列，表头宽度按字节补齐
+    iostat_append(buffer, size, &length, "%-13s %12s %11s %9s %9s %9s %9s %11s\n",
+                  "操作", "次数", "平均", "p50", "p90", "p99", "p99.9", "最大");
+
+    uint64_t counts[IOSTAT_OP_COUNT];
+    for (int op = 0; op < IOSTAT_OP_COUNT; op++) {
+        counts[op] = 0;
+        int top = 0;
+        for (int b = 0; b < IOSTAT_BUCKETS; b++) {
+            counts[op] += latency[op][b];
+            if (latency[op][b]) {
+                top = b;
+            }
+        }
+        if (counts[op] == 0) {
+            continue;
+        }
+
+        char avg[24], p50[24], p90[24], p99[24], p999[24], max[24];
+        iostat_format_ns(total_ns[op] / counts[op], avg, sizeof(avg));
+        iostat_format_ns(iostat_percentile(latency[op], counts[op], 0.50), p50, sizeof(p50));
+        iostat_format_ns(iostat_percentile(latency[op], counts[op], 0.90), p90, sizeof(p90));
+        iostat_format_ns(iostat_percentile(latency[op], counts[op], 0.99), p99, sizeof(p99));
+        iostat_format_ns(iostat_percentile(latency[op], counts[op], 0.999), p999, sizeof(p999));
+        iostat_format_ns(iostat_bucket_limit(top), max, sizeof(max));
+        iostat_append(buffer, size, &length, "%-11s %10lu %9s %9s %9s %9s %9s %9s\n",
+                      iostat_op_names[op], counts[op], avg, p50, p90, p99, p999, max);
+    }
+    iostat_append(buffer, size, &length, "(百分位和最大值为所在对数桶的上界)\n");
+
+    for (int op = 0; op < IOSTAT_OP_COUNT; op++) {
+        if (counts[op] == 0) {
+            continue;
+        }
+
+        iostat_append(buffer, size, &length, "\n--- %s 延迟分布 ---\n", iostat_op_names[op]);
+        iostat_append_hist(buffer, size, &length, latency[op], iostat_format_ns);
+        if (op != IOSTAT_SYNC) {
+            iostat_append(buffer, size, &length, "--- %s 大小分布 ---\n", iostat_op_names[op]);
+            iostat_append_hist(buffer, size, &length, sizes[op], iostat_format_bytes);
+        }
+    }
+
+    iostat_append(buffer, size, &length, "\n--- 磁盘队列深度分布 (进行中: %d) ---\n",
+                  __atomic_load_n(&iostat_inflight, __ATOMIC_RELAXED));
+    iostat_append_hist(buffer, size, &length, depth, iostat_format_count);
+
+    pthread_mutex_unlock(&format_lock);
+    return length;
+}
+
+/**
+ * 打印统计报告
+ */
+void iostat_print(void) {
+    size_t size = 64 * 1024;
+    char *buffer = malloc(size);
+    if (!buffer) {
+        return;
+    }
+
+    iostat_format(buffer, size);
+    printf("%s\n", buffer);
+    free(buffer);
+}
+
+/**
+ * 清零所有统计
+ */
+void iostat_reset(void) {
+    for (iostat_shard_t *shard = __atomic_load_n(&iostat_shards, __ATOMIC_ACQUIRE);
+         shard; shard = shard->next) {
+        for (int op = 0; op < IOSTAT_OP_COUNT; op++) {
+            for (int b = 0; b < IOSTAT_BUCKETS; b++) {
+                __atomic_store_n(&shard->latency[op][b], 0, __ATOMIC_RELAXED);
+                __atomic_store_n(&shard->size[op][b], 0, __ATOMIC_RELAXED);
+            }
+            __atomic_store_n(&shard->total_ns[op], 0, __ATOMIC_RELAXED);
+        }
+        for (int b = 0; b < IOSTAT_BUCKETS; b++) {
+            __atomic_store_n(&shard->depth[b], 0, __ATOMIC_RELAXED);
+        }
+    }
+}
@@ -0,0 +1,85 @@
+/*
+ * ============================================================================
+ * 文件名: src/core/iostat.h
+ * 描述: I/O延迟统计模块头文件
+ * 功能: 按操作记录对数分桶的延迟、请求大小和队列深度分布
+ * ============================================================================
+ */
+
+#ifndef IOSTAT_H
+#define IOSTAT_H
+
+#include "../../include/ext2fs.h"
+
+// ============================================================================
+// 统计常量
+// ============================================================================
+#define IOSTAT_BUCKETS 64               // 对数分桶数 (第b桶覆盖 [2^(b-1), 2^b))
+
+/**
+ * 被统计的操作
+ * 磁盘层操作另外记录队列深度；文件层操作包含磁盘I/O和文件系统逻辑的全部耗时，
+ * 两者对比即可区分尾延迟来自镜像还是文件系统本身
+ */
+typedef enum {
+    IOSTAT_READ = 0,                    // 磁盘读取
+    IOSTAT_WRITE,                       // 磁盘写入
+    IOSTAT_SYNC,                        // 磁盘同步
+    IOSTAT_DISCARD,                     // 磁盘丢弃
+    IOSTAT_FILE_READ,                   // 文件读取 (file_read)
+    IOSTAT_FILE_WRITE,                  // 文件写入 (file_write)
+    IOSTAT_OP_COUNT
+} iostat_op_t;
+
+// ============================================================================
+// 统计函数
+// ============================================================================
+
+/**
+ * 开始一次计时
+ * @return 当前单调时钟 (纳秒)
+ */
+uint64_t iostat_start(void);
+
+/**
+ * 结束一次计时并记录
+ * 计数写入当前线程私有的分片，不加锁
+ * @param op 操作
+ * @param start iostat_start的返回值
+ * @param bytes 请求字节数 (同步操作为0)
+ */
+void iostat_record(iostat_op_t op, uint64_t start, size_t bytes);
+
+/**
+ * 开始一次磁盘请求: 进行中的请求数加1并记录此时的队列深度
+ * @return 当前单调时钟 (纳秒)
+ */
+uint64_t iostat_disk_begin(void);
+
+/**
+ * 结束一次磁盘请求: 进行中的请求数减1并记录延迟和大小
+ * @param op 操作
+ * @param start iostat_disk_begin的返回值
+ * @param bytes 请求字节数
+ */
+void iostat_disk_end(iostat_op_t op, uint64_t start, size_t bytes);
+
+/**
+ * 把所有线程的统计汇总为文本报告
+ * @param buffer 输出缓冲区
+ * @param size 缓冲区大小
+ * @return 报告长度 (不含结尾的'\0'，超出缓冲区时截断)
+ */
+size_t iostat_format(char *buffer, size_t size);
+
+/**
+ * 打印统计报告
+ */
+void iostat_print(void);
+
+/**
+ * 清零所有统计
+ */
+void iostat_reset(void);
+
+#endif /* IOSTAT_H */
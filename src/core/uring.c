@@ -0,0 +1,253 @@
+/*
+ * ============================================================================
+ * 文件名: src/core/uring.c
+ * 描述: io_uring异步I/O引擎实现
+ * 功能: 直接通过系统调用驱动io_uring，不依赖liburing
+ * ============================================================================
+ */
+
+#include "uring.h"
+#include <errno.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+// ============================================================================
+// 静态变量
+// ============================================================================
+static struct {
+    int ring_fd;                        // io_uring实例 (-1表示不可用)
+    int disk_fd;                        // 磁盘镜像文件描述符
+    unsigned entries;                   // 提交队列深度
+    // 提交队列
+    void *sq_ptr;
+    size_t sq_size;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    // 完成队列
+    void *cq_ptr;
+    size_t cq_size;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+    // 一轮提交使用的iovec (须在完成前保持有效)
+    struct iovec *iovecs;
+    pthread_mutex_t lock;               // 环由多个FUSE线程共享
+} uring_state = { .ring_fd = -1, .lock = PTHREAD_MUTEX_INITIALIZER };
+
+// ============================================================================
+// 内部辅助函数
+// ============================================================================
+
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params *p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+/**
+ * 释放环映射和实例
+ */
+static void uring_unmap(void) {
+    if (uring_state.sqes) {
+        munmap(uring_state.sqes, uring_state.sqes_size);
+    }
+    if (uring_state.cq_ptr && uring_state.cq_ptr != uring_state.sq_ptr) {
+        munmap(uring_state.cq_ptr, uring_state.cq_size);
+    }
+    if (uring_state.sq_ptr) {
+        munmap(uring_state.sq_ptr, uring_state.sq_size);
+    }
+    if (uring_state.ring_fd >= 0) {
+        close(uring_state.ring_fd);
+    }
+    free(uring_state.iovecs);
+
+    uring_state.sqes = NULL;
+    uring_state.cq_ptr = NULL;
+    uring_state.sq_ptr = NULL;
+    uring_state.iovecs = NULL;
+    uring_state.ring_fd = -1;
+}
+
+// ============================================================================
+// io_uring引擎函数实现
+// ============================================================================
+
+/**
+ * 初始化io_uring引擎
+ */
+int uring_init(int fd, unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    int ring_fd = sys_io_uring_setup(entries, &params);
+    if (ring_fd < 0) {
+        printf("警告: io_uring不可用 (%s)，使用同步I/O\n", strerror(errno));
+        return -1;
+    }
+
+    uring_state.ring_fd = ring_fd;
+    uring_state.disk_fd = fd;
+    uring_state.entries = params.sq_entries;
+
+    // 映射提交队列和完成队列 (新内核可共用一次映射)
+    uring_state.sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    uring_state.cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (uring_state.cq_size > uring_state.sq_size) {
+            uring_state.sq_size = uring_state.cq_size;
+        }
+        uring_state.cq_size = uring_state.sq_size;
+    }
+
+    uring_state.sq_ptr = mmap(NULL, uring_state.sq_size, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    if (uring_state.sq_ptr == MAP_FAILED) {
+        uring_state.sq_ptr = NULL;
+        goto fail;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        uring_state.cq_ptr = uring_state.sq_ptr;
+    } else {
+        uring_state.cq_ptr = mmap(NULL, uring_state.cq_size, PROT_READ | PROT_WRITE,
+                                  MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+        if (uring_state.cq_ptr == MAP_FAILED) {
+            uring_state.cq_ptr = NULL;
+            goto fail;
+        }
+    }
+
+    uring_state.sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    uring_state.sqes = mmap(NULL, uring_state.sqes_size, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    if (uring_state.sqes == MAP_FAILED) {
+        uring_state.sqes = NULL;
+        goto fail;
+    }
+
+    char *sq = uring_state.sq_ptr;
+    uring_state.sq_head = (unsigned *)(sq + params.sq_off.head);
+    uring_state.sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    uring_state.sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    uring_state.sq_array = (unsigned *)(sq + params.sq_off.array);
+
+    char *cq = uring_state.cq_ptr;
+    uring_state.cq_head = (unsigned *)(cq + params.cq_off.head);
+    uring_state.cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    uring_state.cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    uring_state.cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    uring_state.iovecs = calloc(params.sq_entries, sizeof(struct iovec));
+    if (!uring_state.iovecs) {
+        goto fail;
+    }
+
+    printf("io_uring引擎已启用 (队列深度: %u)\n", uring_state.entries);
+    return 0;
+
+fail:
+    printf("警告: io_uring环映射失败，使用同步I/O\n");
+    uring_unmap();
+    return -1;
+}
+
+/**
+ * 检查io_uring引擎是否可用
+ */
+bool uring_is_available(void) {
+    return uring_state.ring_fd >= 0;
+}
+
+/**
+ * 批量提交读写请求并等待全部完成
+ */
+int uring_submit_batch(const disk_io_t *ios, int count, bool write, ssize_t *results) {
+    if (uring_state.ring_fd < 0) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&uring_state.lock);
+
+    int done = 0;
+    while (done < count) {
+        // 本轮最多填满整个提交队列
+        unsigned batch = count - done;
+        if (batch > uring_state.entries) {
+            batch = uring_state.entries;
+        }
+
+        unsigned tail = *uring_state.sq_tail;
+        unsigned mask = *uring_state.sq_mask;
+        for (unsigned i = 0; i < batch; i++) {
+            const disk_io_t *io = &ios[done + i];
+            unsigned idx = (tail + i) & mask;
+            struct io_uring_sqe *sqe = &uring_state.sqes[idx];
+
+            uring_state.iovecs[i].iov_base = io->buffer;
+            uring_state.iovecs[i].iov_len = io->size;
+
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = write ? IORING_OP_WRITEV : IORING_OP_READV;
+            sqe->fd = uring_state.disk_fd;
+            sqe->off = io->offset;
+            sqe->addr = (unsigned long)&uring_state.iovecs[i];
+            sqe->len = 1;
+            sqe->user_data = done + i;
+            uring_state.sq_array[idx] = idx;
+        }
+        __atomic_store_n(uring_state.sq_tail, tail + batch, __ATOMIC_RELEASE);
+
+        // 一次系统调用提交整轮请求，并等待它们全部完成
+        unsigned submitted = 0;
+        unsigned completed = 0;
+        while (completed < batch) {
+            int ret = sys_io_uring_enter(uring_state.ring_fd, batch - submitted,
+                                         batch - completed, IORING_ENTER_GETEVENTS);
+            if (ret < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                printf("错误: io_uring_enter失败 (%s)\n", strerror(errno));
+                pthread_mutex_unlock(&uring_state.lock);
+                return -1;
+            }
+            submitted += ret;
+
+            // 批量回收完成事件
+            unsigned head = *uring_state.cq_head;
+            unsigned cq_tail = __atomic_load_n(uring_state.cq_tail, __ATOMIC_ACQUIRE);
+            while (head != cq_tail) {
+                struct io_uring_cqe *cqe = &uring_state.cqes[head & *uring_state.cq_mask];
+                results[cqe->user_data] = cqe->res;
+                head++;
+                completed++;
+            }
+            __atomic_store_n(uring_state.cq_head, head, __ATOMIC_RELEASE);
+        }
+
+        done += batch;
+    }
+
+    pthread_mutex_unlock(&uring_state.lock);
+    return 0;
+}
+
+/**
+ * 清理io_uring引擎
+ */
+void uring_cleanup(void) {
+    if (uring_state.ring_fd >= 0) {
+        uring_unmap();
+    }
+}
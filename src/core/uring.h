@@ -0,0 +1,54 @@
+/*
+ * ============================================================================
+ * 文件名: src/core/uring.h
+ * 描述: io_uring异步I/O引擎头文件
+ * 功能: 批量提交块I/O请求并批量回收完成事件
+ * ============================================================================
+ */
+
+#ifndef URING_H
+#define URING_H
+
+#include "../../include/ext2fs.h"
+#include "disk.h"
+
+// ============================================================================
+// io_uring引擎常量
+// ============================================================================
+#define URING_QUEUE_DEPTH 64            // 提交队列深度 (同时在途的最大I/O数)
+
+// ============================================================================
+// io_uring引擎函数
+// ============================================================================
+
+/**
+ * 初始化io_uring引擎
+ * @param fd 磁盘镜像文件描述符
+ * @param entries 提交队列深度
+ * @return 成功返回0，内核不支持或被禁止时返回负数 (调用者应回退到同步路径)
+ */
+int uring_init(int fd, unsigned entries);
+
+/**
+ * 检查io_uring引擎是否可用
+ * @return 已初始化返回true，否则返回false
+ */
+bool uring_is_available(void);
+
+/**
+ * 批量提交读写请求并等待全部完成
+ * 超过队列深度的请求会分多轮提交，每轮一次io_uring_enter
+ * @param ios 请求数组
+ * @param count 请求数量
+ * @param write true为写入，false为读取
+ * @param results 输出每个请求的完成结果 (字节数或负的errno)
+ * @return 成功返回0，提交失败返回负数
+ */
+int uring_submit_batch(const disk_io_t *ios, int count, bool write, ssize_t *results);
+
+/**
+ * 清理io_uring引擎
+ */
+void uring_cleanup(void);
+
+#endif /* URING_H */
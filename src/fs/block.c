@@ -8,8 +8,503 @@
 
 #include "block.h"
 #include "inode.h"
+#include "group.h"
+#include "fragment.h"
 #include "../core/disk.h"
 #include "../core/bitmap.h"
+#include "../core/bufpool.h"
+#include <pthread.h>
+
+// ============================================================================
+// 映射块缓存 (间接块和extent树节点)
+// ============================================================================
+#define MAP_CACHE_SIZE 64                   // 缓存的映射块数 (按块编号直接映射)
+
+/**
+ * 缓存的映射块 (块内容为块指针数组或extent树节点)
+ */
+typedef struct {
+    int block_id;                       // 块编号，0表示空槽 (第0块不会用作映射块)
+    bool dirty;                         // 是否有尚未写回的修改
+    uint32_t *ptrs;                     // 块内容
+} map_cache_entry_t;
+
+static struct {
+    pthread_mutex_t lock;               // 保护全部槽位
+    map_cache_entry_t entries[MAP_CACHE_SIZE];
+    char *buffers;                      // 各槽位的块缓冲区 (对齐分配，O_DIRECT下可直接读写)
+    uint64_t hits;                      // 统计: 命中次数
+    uint64_t misses;                    // 统计: 未命中次数
+} map_cache = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+/**
+ * 待丢弃并释放的一段连续数据块 (丢弃之前仍标记为已分配)
+ */
+typedef struct {
+    int start;                          // 起始块编号
+    int length;                         // 块数
+} block_run_t;
+
+// ============================================================================
+// 内部辅助函数
+// ============================================================================
+
+/**
+ * 写回一个修改过的缓存槽 (调用者持有锁)
+ */
+static int map_cache_writeback(map_cache_entry_t *entry) {
+    if (!entry->dirty) {
+        return 0;
+    }
+    if (block_write(entry->block_id, entry->ptrs) != 0) {
+        return -1;
+    }
+    entry->dirty = false;
+    return 0;
+}
+
+/**
+ * 取得映射块所在的缓存槽，未命中时换出原内容并读入 (调用者持有锁)
+ * @return 缓存槽，失败返回NULL
+ */
+static map_cache_entry_t *map_cache_get(int block_id) {
+    if (!map_cache.buffers) {
+        map_cache.buffers = bufpool_alloc((size_t)MAP_CACHE_SIZE * FS_BLOCK_SIZE);
+        if (!map_cache.buffers) {
+            return NULL;
+        }
+        for (int i = 0; i < MAP_CACHE_SIZE; i++) {
+            map_cache.entries[i].block_id = 0;
+            map_cache.entries[i].dirty = false;
+            map_cache.entries[i].ptrs = (uint32_t *)(map_cache.buffers + (size_t)i * FS_BLOCK_SIZE);
+        }
+    }
+    
+    map_cache_entry_t *entry = &map_cache.entries[block_id % MAP_CACHE_SIZE];
+    if (entry->block_id == block_id) {
+        map_cache.hits++;
+        return entry;
+    }
+    
+    map_cache.misses++;
+    if (entry->block_id != 0 && map_cache_writeback(entry) != 0) {
+        return NULL;
+    }
+    entry->block_id = 0;
+    if (block_read(block_id, entry->ptrs) < 0) {
+        return NULL;
+    }
+    entry->block_id = block_id;
+    return entry;
+}
+
+/**
+ * 复制映射块的内容
+ */
+static int map_cache_load(int block_id, uint32_t *ptrs) {
+    pthread_mutex_lock(&map_cache.lock);
+    map_cache_entry_t *entry = map_cache_get(block_id);
+    if (entry) {
+        memcpy(ptrs, entry->ptrs, FS_BLOCK_SIZE);
+    }
+    pthread_mutex_unlock(&map_cache.lock);
+    return entry ? 0 : -1;
+}
+
+/**
+ * 替换映射块的内容 (写回推迟到换出或同步时)
+ */
+static int map_cache_store(int block_id, const uint32_t *ptrs) {
+    pthread_mutex_lock(&map_cache.lock);
+    map_cache_entry_t *entry = map_cache_get(block_id);
+    if (entry) {
+        memcpy(entry->ptrs, ptrs, FS_BLOCK_SIZE);
+        entry->dirty = true;
+    }
+    pthread_mutex_unlock(&map_cache.lock);
+    return entry ? 0 : -1;
+}
+
+/**
+ * 丢弃已释放映射块的缓存 (不写回)
+ */
+static void map_cache_forget(int block_id) {
+    pthread_mutex_lock(&map_cache.lock);
+    map_cache_entry_t *entry = &map_cache.entries[block_id % MAP_CACHE_SIZE];
+    if (map_cache.buffers && entry->block_id == block_id) {
+        entry->block_id = 0;
+        entry->dirty = false;
+    }
+    pthread_mutex_unlock(&map_cache.lock);
+}
+
+/**
+ * 每个间接块能容纳的块指针数
+ */
+static int block_ptrs_per_block(void) {
+    return FS_BLOCK_SIZE / sizeof(uint32_t);
+}
+
+/**
+ * 单个文件最多可映射的数据块数 (受块索引类型限制)
+ */
+static int block_map_capacity(const Inode *inode) {
+    if (inode->flags & INODE_FLAG_EXTENTS) {
+        return INT32_MAX;
+    }
+    
+    int64_t per_block = block_ptrs_per_block();
+    int64_t capacity = MAX_DIRECT_BLOCKS + per_block + per_block * per_block +
+                       per_block * per_block * per_block;
+    return capacity > INT32_MAX ? INT32_MAX : (int)capacity;
+}
+
+/**
+ * 计算逻辑块在映射树中的路径
+ * @param index 逻辑块索引
+ * @param slots 输出: slots[0]为data_blocks中的位置，slots[1..depth]为各级间接块中的位置
+ * @return 间接层数 (0为直接块)，超出映射范围返回-1
+ */
+static int block_map_path(int index, int slots[4]) {
+    if (index < MAX_DIRECT_BLOCKS) {
+        slots[0] = index;
+        return 0;
+    }
+    
+    int64_t per_block = block_ptrs_per_block();
+    int64_t rest = index - MAX_DIRECT_BLOCKS;
+    int64_t span = per_block;
+    for (int depth = 1; depth <= 3; depth++) {
+        if (rest < span) {
+            slots[0] = INDIRECT_BLOCK + depth - 1;
+            for (int level = depth; level >= 1; level--) {
+                slots[level] = rest % per_block;
+                rest /= per_block;
+            }
+            return depth;
+        }
+        rest -= span;
+        span *= per_block;
+    }
+    return -1;
+}
+
+/**
+ * 查找逻辑块对应的数据块
+ * @return 块编号，未映射返回-1
+ */
+static int block_map_lookup(const Inode *inode, int index) {
+    int slots[4];
+    int depth = block_map_path(index, slots);
+    if (depth < 0) {
+        return -1;
+    }
+    
+    uint32_t block_id = inode->data_blocks[slots[0]];
+    if (depth > 0 && block_id != 0) {
+        pthread_mutex_lock(&map_cache.lock);
+        for (int level = 1; level <= depth && block_id != 0; level++) {
+            map_cache_entry_t *entry = map_cache_get(block_id);
+            block_id = entry ? entry->ptrs[slots[level]] : 0;
+        }
+        pthread_mutex_unlock(&map_cache.lock);
+    }
+    
+    return block_id != 0 ? (int)block_id : -1;
+}
+
+/**
+ * 把逻辑块映射到数据块，路径上缺少的间接块紧挨着数据块分配
+ */
+static int block_map_set(Inode *inode, int index, int block_id) {
+    int slots[4];
+    int depth = block_map_path(index, slots);
+    if (depth < 0) {
+        return -1;
+    }
+    if (depth == 0) {
+        inode->data_blocks[slots[0]] = block_id;
+        return 0;
+    }
+    
+    if (inode->data_blocks[slots[0]] == 0) {
+        int meta = block_alloc(block_id);
+        if (meta == -1) {
+            return -1;
+        }
+        inode->data_blocks[slots[0]] = meta;
+    }
+    
+    int status = -1;
+    uint32_t parent = inode->data_blocks[slots[0]];
+    pthread_mutex_lock(&map_cache.lock);
+    for (int level = 1; level <= depth; level++) {
+        map_cache_entry_t *entry = map_cache_get(parent);
+        if (!entry) {
+            break;
+        }
+        
+        if (level == depth) {
+            entry->ptrs[slots[level]] = block_id;
+            entry->dirty = true;
+            status = 0;
+            break;
+        }
+        if (entry->ptrs[slots[level]] == 0) {
+            // block_alloc只写磁盘，不会访问缓存，entry在此期间保持有效
+            int meta = block_alloc(block_id);
+            if (meta == -1) {
+                break;
+            }
+            entry->ptrs[slots[level]] = meta;
+            entry->dirty = true;
+        }
+        parent = entry->ptrs[slots[level]];
+    }
+    pthread_mutex_unlock(&map_cache.lock);
+    
+    return status;
+}
+
+/**
+ * extent树节点中的项
+ */
+static Extent *extent_entries(ExtentHeader *node) {
+    return (Extent *)(node + 1);
+}
+
+/**
+ * 检查extent树节点头
+ */
+static bool extent_node_valid(const ExtentHeader *node, int depth) {
+    return node->magic == EXTENT_MAGIC && node->depth == depth && node->count <= node->max;
+}
+
+/**
+ * 初始化一个空的extent树节点
+ */
+static void extent_node_init(ExtentHeader *node, size_t size, int depth) {
+    memset(node, 0, size);
+    node->magic = EXTENT_MAGIC;
+    node->max = (size - sizeof(ExtentHeader)) / sizeof(Extent);
+    node->depth = depth;
+}
+
+/**
+ * 保存修改过的节点 (根节点就在inode中，无需写出)
+ */
+static int extent_store(ExtentHeader *node, uint32_t block_id) {
+    return block_id == 0 ? 0 : map_cache_store(block_id, (const uint32_t *)node);
+}
+
+/**
+ * 在extent树中查找逻辑块
+ * @param count 输出从该块起到extent末尾的块数
+ * @return 块编号，未映射返回-1
+ */
+static int extent_lookup(const Inode *inode, int index, int *count) {
+    const ExtentHeader *node = (const ExtentHeader *)inode->data_blocks;
+    int result = -1;
+    bool locked = false;
+    
+    for (int depth = node->depth; node && extent_node_valid(node, depth); depth--) {
+        const Extent *entries = (const Extent *)(node + 1);
+        
+        // 二分查找最后一个起始逻辑块不大于index的项
+        int found = -1;
+        int low = 0;
+        int high = node->count - 1;
+        while (low <= high) {
+            int mid = (low + high) / 2;
+            if (entries[mid].logical <= (uint32_t)index) {
+                found = mid;
+                low = mid + 1;
+            } else {
+                high = mid - 1;
+            }
+        }
+        if (found < 0) {
+            break;
+        }
+        
+        if (depth == 0) {
+            const Extent *extent = &entries[found];
+            if ((uint32_t)index < extent->logical + extent->length) {
+                *count = extent->logical + extent->length - index;
+                result = extent->start + (index - extent->logical);
+            }
+            break;
+        }
+        
+        // 沿路径读取下级节点，持锁期间直接使用缓存中的内容
+        if (!locked) {
+            pthread_mutex_lock(&map_cache.lock);
+            locked = true;
+        }
+        map_cache_entry_t *entry = map_cache_get(entries[found].start);
+        node = entry ? (const ExtentHeader *)entry->ptrs : NULL;
+    }
+    
+    if (locked) {
+        pthread_mutex_unlock(&map_cache.lock);
+    }
+    return result;
+}
+
+/**
+ * 根节点已满时树长高一层: 根节点的项移到新块中，根节点只保留指向它的一项
+ */
+static int extent_grow(Inode *inode, int goal) {
+    ExtentHeader *root = (ExtentHeader *)inode->data_blocks;
+    if (root->depth >= EXTENT_MAX_DEPTH) {
+        return -1;
+    }
+    
+    ExtentHeader *node = bufpool_get(FS_BLOCK_SIZE);
+    if (!node) {
+        return -1;
+    }
+    extent_node_init(node, FS_BLOCK_SIZE, root->depth);
+    memcpy(extent_entries(node), extent_entries(root), root->count * sizeof(Extent));
+    node->count = root->count;
+    
+    int block_id = block_alloc(goal);
+    if (block_id == -1 || map_cache_store(block_id, (const uint32_t *)node) != 0) {
+        if (block_id != -1) {
+            block_free(block_id);
+        }
+        bufpool_put(node, FS_BLOCK_SIZE);
+        return -1;
+    }
+    
+    Extent *entry = &extent_entries(root)[0];
+    entry->logical = extent_entries(node)[0].logical;
+    entry->length = 0;
+    entry->start = block_id;
+    root->count = 1;
+    root->depth++;
+    
+    bufpool_put(node, FS_BLOCK_SIZE);
+    return 0;
+}
+
+/**
+ * 在extent树末尾追加一段数据块 (能与最后一个extent衔接时直接延长)
+ */
+static int extent_append(Inode *inode, Extent extent) {
+    ExtentHeader *root = (ExtentHeader *)inode->data_blocks;
+    int depth = root->depth;
+    ExtentHeader *nodes[EXTENT_MAX_DEPTH + 1] = { root };
+    uint32_t blocks[EXTENT_MAX_DEPTH + 1] = { 0 };
+    uint32_t chain[EXTENT_MAX_DEPTH + 1];
+    int chain_count = 0;
+    int status = -1;
+    
+    if (!extent_node_valid(root, depth) || depth > EXTENT_MAX_DEPTH) {
+        return -1;
+    }
+    
+    // 追加总是发生在文件末尾，只需要最右侧的一条路径
+    int loaded = 0;
+    for (int level = 1; level <= depth; level++) {
+        ExtentHeader *parent = nodes[level - 1];
+        nodes[level] = bufpool_get(FS_BLOCK_SIZE);
+        if (!nodes[level]) {
+            goto out;
+        }
+        loaded = level;
+        if (parent->count == 0) {
+            goto out;
+        }
+        blocks[level] = extent_entries(parent)[parent->count - 1].start;
+        if (map_cache_load(blocks[level], (uint32_t *)nodes[level]) != 0 ||
+            !extent_node_valid(nodes[level], depth - level)) {
+            goto out;
+        }
+    }
+    
+    ExtentHeader *leaf = nodes[depth];
+    if (leaf->count > 0) {
+        Extent *last = &extent_entries(leaf)[leaf->count - 1];
+        if (last->logical + last->length == extent.logical &&
+            last->start + last->length == extent.start &&
+            extent.start % FS_BLOCKS_PER_GROUP != 0) {
+            last->length += extent.length;
+            status = extent_store(leaf, blocks[depth]);
+            goto out;
+        }
+    }
+    if (leaf->count < leaf->max) {
+        extent_entries(leaf)[leaf->count++] = extent;
+        status = extent_store(leaf, blocks[depth]);
+        goto out;
+    }
+    
+    // 叶子已满: 自下而上找到第一个还有空位的节点，在它下面挂一条新路径
+    int level = depth - 1;
+    while (level >= 0 && nodes[level]->count == nodes[level]->max) {
+        level--;
+    }
+    if (level < 0) {
+        status = extent_grow(inode, extent.start);
+        if (status == 0) {
+            status = extent_append(inode, extent);
+        }
+        goto out;
+    }
+    
+    Extent child = extent;
+    for (int l = depth; l > level; l--) {
+        ExtentHeader *node = bufpool_get(FS_BLOCK_SIZE);
+        if (!node) {
+            goto out;
+        }
+        extent_node_init(node, FS_BLOCK_SIZE, depth - l);
+        extent_entries(node)[0] = child;
+        node->count = 1;
+        
+        int block_id = block_alloc(extent.start);
+        if (block_id != -1) {
+            chain[chain_count++] = block_id;
+        }
+        int stored = block_id != -1 ? map_cache_store(block_id, (const uint32_t *)node) : -1;
+        bufpool_put(node, FS_BLOCK_SIZE);
+        if (stored != 0) {
+            goto out;
+        }
+        
+        child.logical = extent.logical;
+        child.length = 0;
+        child.start = block_id;
+    }
+    extent_entries(nodes[level])[nodes[level]->count++] = child;
+    status = extent_store(nodes[level], blocks[level]);
+    
+out:
+    // 失败时释放已分配但尚未挂到树上的节点
+    for (int i = 0; status != 0 && i < chain_count; i++) {
+        map_cache_forget(chain[i]);
+        block_free(chain[i]);
+    }
+    for (int level = 1; level <= loaded; level++) {
+        bufpool_put(nodes[level], FS_BLOCK_SIZE);
+    }
+    return status;
+}
+
+/**
+ * 查找逻辑块对应的数据块
+ * @param count 输出从该块起磁盘上连续的块数 (块指针映射时为1)
+ * @return 块编号，未映射返回-1
+ */
+static int block_lookup(const Inode *inode, int index, int *count) {
+    if (inode->flags & INODE_FLAG_EXTENTS) {
+        return extent_lookup(inode, index, count);
+    }
+    
+    *count = 1;
+    return block_map_lookup(inode, index);
+}
 
 // ============================================================================
 // 数据块管理函数实现
@@ -29,86 +524,177 @@ int block_init(void) {
 /**
  * 分配一个空闲数据块
  */
-int block_alloc(void) {
-    // 从第1块开始查找 (第0块保留)
-    int block_id = -1;
-    for (int i = 1; i < MAX_BLOCKS; i++) {
-        if (!bitmap_test_bit(g_fs.block_bitmap, i)) {
-            block_id = i;
-            break;
+int block_alloc(int goal) {
+    // 从目标块所在的组开始查找 (第0块保留，已在位图中标记)
+    int start = (goal > 0 && goal < FS_TOTAL_BLOCKS) ? group_of_block(goal) : 0;
+    
+    for (int n = 0; n < FS_GROUP_COUNT; n++) {
+        int g = (start + n) % FS_GROUP_COUNT;
+        GroupDesc *gd = &g_fs.groups[g];
+        if (__atomic_load_n(&gd->free_blocks, __ATOMIC_RELAXED) == 0) {
+            continue;
         }
+        
+        // 只在本组的位图范围内查找
+        group_lock(g);
+        int first = g * FS_BLOCKS_PER_GROUP;
+        int index = bitmap_find_free_bit(g_fs.block_bitmap + first / 8, group_block_count(g));
+        if (index == -1) {
+            group_unlock(g);
+            continue;
+        }
+        
+        // 标记为已使用
+        bitmap_set_bit(g_fs.block_bitmap, first + index);
+        gd->free_blocks--;
+        group_unlock(g);
+        
+        // 清空块内容
+        int block_id = first + index;
+        block_clear(block_id);
+        
+        // 更新超级块统计
+        __atomic_fetch_sub(&g_fs.superblock.free_blocks, 1, __ATOMIC_RELAXED);
+        g_fs.is_dirty = true;
+        
+        return block_id;
     }
     
-    if (block_id == -1) {
-        printf("错误: 没有空闲数据块\n");
-        return -1;
+    printf("错误: 没有空闲数据块\n");
+    return -1;
+}
+
+/**
+ * 在位图和空闲计数中释放一个数据块 (不处理块内容)
+ * @return 块原本已分配返回true
+ */
+static bool block_release(int block_id) {
+    int g = group_of_block(block_id);
+    
+    group_lock(g);
+    if (!bitmap_test_bit(g_fs.block_bitmap, block_id)) {
+        group_unlock(g);
+        return false;
     }
+    bitmap_clear_bit(g_fs.block_bitmap, block_id);
+    g_fs.groups[g].free_blocks++;
+    group_unlock(g);
     
-    // 标记为已使用
-    bitmap_set_bit(g_fs.block_bitmap, block_id);
+    __atomic_fetch_add(&g_fs.superblock.free_blocks, 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+/**
+ * 丢弃连续的若干数据块，主机不支持打洞时逐块写入全0
+ */
+static void block_discard(int first_block, int count) {
+    off_t offset = block_offset(first_block);
+    if (offset >= 0 && disk_discard(offset, (size_t)count * FS_BLOCK_SIZE) == 0) {
+        return;
+    }
     
-    // 清空块内容
-    block_clear(block_id);
+    for (int i = 0; i < count; i++) {
+        block_clear(first_block + i);
+    }
+}
+
+/**
+ * 丢弃区间中的数据块后再在位图中释放
+ * 释放之前其他线程不会分配到这些块，丢弃不会抹掉它们新写入的内容
+ */
+static void block_run_flush(block_run_t *run) {
+    if (run->length == 0) {
+        return;
+    }
     
-    // 更新超级块统计
-    g_fs.superblock.free_blocks--;
-    g_fs.is_dirty = true;
+    block_discard(run->start, run->length);
+    for (int i = 0; i < run->length; i++) {
+        block_release(run->start + i);
+    }
+    run->length = 0;
+}
+
+/**
+ * 把数据块加入待释放的连续区间，不连续 (或跨组) 时先丢弃并释放之前的区间
+ */
+static void block_run_add(block_run_t *run, int block_id) {
+    if (block_id <= 0 || block_id >= FS_TOTAL_BLOCKS || !block_is_used(block_id)) {
+        return;
+    }
     
-    return block_id;
+    if (run->length > 0 && block_id == run->start + run->length &&
+        block_id % FS_BLOCKS_PER_GROUP != 0) {
+        run->length++;
+        return;
+    }
+    block_run_flush(run);
+    run->start = block_id;
+    run->length = 1;
 }
 
 /**
  * 释放一个数据块
  */
 void block_free(int block_id) {
-    if (block_id <= 0 || block_id >= MAX_BLOCKS) {
+    if (block_id <= 0 || block_id >= FS_TOTAL_BLOCKS) {
         return;  // 保护第0块和无效块
     }
     
-    // 清除位图标记
-    bitmap_clear_bit(g_fs.block_bitmap, block_id);
+    if (!block_is_used(block_id)) {
+        return;
+    }
     
-    // 清空块内容
-    block_clear(block_id);
+    // 先丢弃块内容 (空闲块读出必须为全0)，再清除位图标记并更新空闲计数；
+    // 顺序反过来时其他线程可能在丢弃之前分配并写入该块
+    block_discard(block_id, 1);
+    block_release(block_id);
     
-    // 更新超级块统计
-    g_fs.superblock.free_blocks++;
     g_fs.is_dirty = true;
 }
 
+/**
+ * 计算数据块在磁盘中的偏移量
+ */
+off_t block_offset(int block_id) {
+    if (block_id < 0 || block_id >= FS_TOTAL_BLOCKS) {
+        return -1;
+    }
+    
+    // 块编号在组内连续，组与组之间隔着下一组的位图和inode表
+    int g = group_of_block(block_id);
+    int index = block_id - g * FS_BLOCKS_PER_GROUP;
+    return g_fs.groups[g].data_blocks_offset + (off_t)index * FS_BLOCK_SIZE;
+}
+
 /**
  * 读取数据块内容
  */
 int block_read(int block_id, void *buffer) {
-    if (block_id < 0 || block_id >= MAX_BLOCKS || !buffer) {
+    off_t offset = block_offset(block_id);
+    if (offset < 0 || !buffer) {
         return -1;
     }
     
-    SuperBlock *sb = &g_fs.superblock;
-    off_t offset = sb->data_blocks_offset + block_id * BLOCK_SIZE;
-    
-    return disk_read(offset, buffer, BLOCK_SIZE);
+    return disk_read(offset, buffer, FS_BLOCK_SIZE);
 }
 
 /**
  * 写入数据块内容
  */
 int block_write(int block_id, const void *buffer) {
-    if (block_id < 0 || block_id >= MAX_BLOCKS || !buffer) {
+    off_t offset = block_offset(block_id);
+    if (offset < 0 || !buffer) {
         return -1;
     }
     
-    SuperBlock *sb = &g_fs.superblock;
-    off_t offset = sb->data_blocks_offset + block_id * BLOCK_SIZE;
-    
-    return disk_write(offset, buffer, BLOCK_SIZE);
+    return disk_write(offset, buffer, FS_BLOCK_SIZE);
 }
 
 /**
  * 检查数据块是否被使用
  */
 bool block_is_used(int block_id) {
-    if (block_id < 0 || block_id >= MAX_BLOCKS) {
+    if (block_id < 0 || block_id >= FS_TOTAL_BLOCKS) {
         return false;
     }
     
@@ -119,14 +705,169 @@ bool block_is_used(int block_id) {
  * 清空数据块内容
  */
 int block_clear(int block_id) {
-    if (block_id < 0 || block_id >= MAX_BLOCKS) {
+    if (block_id < 0 || block_id >= FS_TOTAL_BLOCKS) {
+        return -1;
+    }
+    
+    // 使用对齐缓冲区，O_DIRECT下可以直接写出
+    char *zero_buffer = bufpool_get(FS_BLOCK_SIZE);
+    if (!zero_buffer) {
+        return -1;
+    }
+    memset(zero_buffer, 0, FS_BLOCK_SIZE);
+    
+    int result = block_write(block_id, zero_buffer);
+    bufpool_put(zero_buffer, FS_BLOCK_SIZE);
+    return result;
+}
+
+/**
+ * 收集子树中的全部extent和节点块 (按逻辑块顺序)
+ */
+static int extent_collect(ExtentHeader *node, Extent **extents, int *extent_count,
+                          uint32_t **nodes, int *node_count) {
+    if (node->depth == 0) {
+        Extent *grown = realloc(*extents, (*extent_count + node->count + 1) * sizeof(Extent));
+        if (!grown) {
+            return -1;
+        }
+        *extents = grown;
+        memcpy(*extents + *extent_count, extent_entries(node), node->count * sizeof(Extent));
+        *extent_count += node->count;
+        return 0;
+    }
+    
+    ExtentHeader *child = bufpool_get(FS_BLOCK_SIZE);
+    if (!child) {
         return -1;
     }
     
-    char zero_buffer[BLOCK_SIZE];
-    memset(zero_buffer, 0, BLOCK_SIZE);
+    int status = 0;
+    for (int i = 0; i < node->count && status == 0; i++) {
+        uint32_t block_id = extent_entries(node)[i].start;
+        uint32_t *grown = realloc(*nodes, (*node_count + 1) * sizeof(uint32_t));
+        if (!grown) {
+            status = -1;
+            break;
+        }
+        *nodes = grown;
+        (*nodes)[(*node_count)++] = block_id;
+        
+        if (map_cache_load(block_id, (uint32_t *)child) != 0 ||
+            !extent_node_valid(child, node->depth - 1)) {
+            status = -1;
+            break;
+        }
+        status = extent_collect(child, extents, extent_count, nodes, node_count);
+    }
     
-    return block_write(block_id, zero_buffer);
+    bufpool_put(child, FS_BLOCK_SIZE);
+    return status;
+}
+
+/**
+ * 把extent树缩减到指定块数: 取出全部extent，释放树节点和多余的数据块，
+ * 再把保留的extent重新追加 (extent数量很少，重建比原地修改简单)
+ */
+static int extent_truncate(Inode *inode, int keep, block_run_t *run) {
+    ExtentHeader *root = (ExtentHeader *)inode->data_blocks;
+    Extent *extents = NULL;
+    uint32_t *nodes = NULL;
+    int extent_count = 0;
+    int node_count = 0;
+    
+    if (!extent_node_valid(root, root->depth) ||
+        extent_collect(root, &extents, &extent_count, &nodes, &node_count) != 0) {
+        free(extents);
+        free(nodes);
+        return -1;
+    }
+    
+    for (int i = 0; i < node_count; i++) {
+        map_cache_forget(nodes[i]);
+        block_free(nodes[i]);
+    }
+    free(nodes);
+    extent_node_init(root, sizeof(inode->data_blocks), 0);
+    
+    int status = 0;
+    for (int i = 0; i < extent_count; i++) {
+        Extent extent = extents[i];
+        uint32_t kept = 0;
+        if (extent.logical < (uint32_t)keep) {
+            kept = (uint32_t)keep - extent.logical;
+            if (kept > extent.length) {
+                kept = extent.length;
+            }
+        }
+        
+        for (uint32_t b = kept; b < extent.length; b++) {
+            block_run_add(run, extent.start + b);
+        }
+        if (kept > 0 && status == 0) {
+            extent.length = kept;
+            status = extent_append(inode, extent);
+        }
+    }
+    
+    free(extents);
+    return status;
+}
+
+/**
+ * 释放映射子树中逻辑索引不小于keep的数据块，以及整棵子树都不再需要的间接块
+ * @param slot 指向子树根的指针 (位于inode或上级间接块中)
+ * @param depth 子树的间接层数 (0表示slot直接指向数据块)
+ * @param base 子树覆盖的第一个逻辑块索引
+ * @param keep 保留的块数
+ * @param run 待丢弃的连续数据块
+ */
+static int block_trim_tree(uint32_t *slot, int depth, int64_t base, int64_t keep,
+                           block_run_t *run) {
+    if (*slot == 0) {
+        return 0;
+    }
+    if (depth == 0) {
+        if (base >= keep) {
+            block_run_add(run, *slot);
+            *slot = 0;
+        }
+        return 0;
+    }
+    
+    int per_block = block_ptrs_per_block();
+    int64_t span = 1;
+    for (int level = 1; level < depth; level++) {
+        span *= per_block;
+    }
+    
+    uint32_t *ptrs = bufpool_get(FS_BLOCK_SIZE);
+    if (!ptrs || map_cache_load(*slot, ptrs) != 0) {
+        bufpool_put(ptrs, FS_BLOCK_SIZE);
+        return -1;
+    }
+    
+    int status = 0;
+    bool changed = false;
+    for (int i = 0; i < per_block && status == 0; i++) {
+        int64_t child_base = base + i * span;
+        if (ptrs[i] == 0 || child_base + span <= keep) {
+            continue;
+        }
+        status = block_trim_tree(&ptrs[i], depth - 1, child_base, keep, run);
+        changed = true;
+    }
+    
+    if (status == 0 && base >= keep) {
+        map_cache_forget(*slot);
+        block_free(*slot);
+        *slot = 0;
+    } else if (changed) {
+        status = map_cache_store(*slot, ptrs) != 0 ? -1 : status;
+    }
+    
+    bufpool_put(ptrs, FS_BLOCK_SIZE);
+    return status;
 }
 
 /**
@@ -138,21 +879,37 @@ int block_alloc_for_inode(int inode_id) {
     }
     
     Inode *inode = &g_fs.inode_table[inode_id];
+    int index = inode->block_count;
+    
+    // 内联数据和碎片位置占用了块映射区域，须先由文件层转为块映射
+    if (inode->flags & (INODE_FLAG_INLINE | INODE_FLAG_FRAGMENT)) {
+        printf("错误: inode %d 的数据内联保存或打包在碎片块中，不能分配数据块\n", inode_id);
+        return -1;
+    }
     
     // 检查是否还有空间分配新块
-    if (inode->block_count >= MAX_DIRECT_BLOCKS) {
+    if (index >= block_map_capacity(inode)) {
         printf("错误: inode %d 已达到最大数据块数\n", inode_id);
         return -1;
     }
     
-    // 分配新块
-    int block_id = block_alloc();
+    // 分配新块: 紧跟文件最后一块，空文件从inode所在的组开始
+    int count;
+    int goal = index > 0 ? block_lookup(inode, index - 1, &count) + 1
+                         : group_of_inode(inode_id) * FS_BLOCKS_PER_GROUP;
+    int block_id = block_alloc(goal);
     if (block_id == -1) {
         return -1;
     }
     
-    // 添加到inode的数据块列表
-    inode->data_blocks[inode->block_count] = block_id;
+    // 加入inode的块映射 (与上一段连续时延长extent，块指针映射必要时分配间接块)
+    Extent extent = { (uint32_t)index, 1, (uint32_t)block_id };
+    int status = (inode->flags & INODE_FLAG_EXTENTS) ? extent_append(inode, extent)
+                                                     : block_map_set(inode, index, block_id);
+    if (status != 0) {
+        block_free(block_id);
+        return -1;
+    }
     inode->block_count++;
     
     g_fs.is_dirty = true;
@@ -160,27 +917,69 @@ int block_alloc_for_inode(int inode_id) {
 }
 
 /**
- * 释放inode的所有数据块
+ * 把inode的数据块缩减到指定数量
  */
-int block_free_all_for_inode(int inode_id) {
-    if (!inode_is_used(inode_id)) {
+int block_truncate_for_inode(int inode_id, int block_count) {
+    if (!inode_is_used(inode_id) || block_count < 0) {
         return -1;
     }
     
     Inode *inode = &g_fs.inode_table[inode_id];
+    if ((uint32_t)block_count > inode->block_count ||
+        (inode->flags & (INODE_FLAG_INLINE | INODE_FLAG_FRAGMENT))) {
+        return 0;  // 内联数据和碎片不占用整个数据块
+    }
     
-    // 释放所有数据块
-    for (int i = 0; i < inode->block_count && i < MAX_DIRECT_BLOCKS; i++) {
-        if (inode->data_blocks[i] > 0) {
-            block_free(inode->data_blocks[i]);
-            inode->data_blocks[i] = 0;
+    // 释放的数据块中磁盘上连续 (编号相邻且在同一组内) 的合并为一次丢弃
+    block_run_t run = { 0, 0 };
+    int status = 0;
+    if (inode->flags & INODE_FLAG_EXTENTS) {
+        status = extent_truncate(inode, block_count, &run);
+    } else {
+        for (int i = 0; i < MAX_DIRECT_BLOCKS; i++) {
+            block_trim_tree(&inode->data_blocks[i], 0, i, block_count, &run);
+        }
+        
+        int64_t per_block = block_ptrs_per_block();
+        int64_t base = MAX_DIRECT_BLOCKS;
+        int64_t span = per_block;
+        for (int depth = 1; depth <= 3 && status == 0; depth++) {
+            status = block_trim_tree(&inode->data_blocks[INDIRECT_BLOCK + depth - 1], depth,
+                                     base, block_count, &run);
+            base += span;
+            span *= per_block;
         }
     }
+    block_run_flush(&run);
     
-    inode->block_count = 0;
-    inode->size = 0;
+    if (status == 0) {
+        inode->block_count = block_count;
+    }
     
     g_fs.is_dirty = true;
+    return status;
+}
+
+/**
+ * 释放inode的所有数据块
+ */
+int block_free_all_for_inode(int inode_id) {
+    if (block_truncate_for_inode(inode_id, 0) != 0) {
+        return -1;
+    }
+    
+    // 碎片文件归还槽位，与内联文件一样回到空的内联状态
+    Inode *inode = &g_fs.inode_table[inode_id];
+    if (inode->flags & INODE_FLAG_FRAGMENT) {
+        fragment_release(inode);
+    }
+    if (inode->flags & (INODE_FLAG_INLINE | INODE_FLAG_FRAGMENT)) {
+        memset(inode->data_blocks, 0, sizeof(inode->data_blocks));
+        inode->flags = (inode->flags & ~INODE_FLAG_FRAGMENT) | INODE_FLAG_INLINE;
+        g_fs.is_dirty = true;
+    }
+    
+    inode->size = 0;
     return 0;
 }
 
@@ -194,40 +993,182 @@ int block_get_for_inode(int inode_id, int block_index) {
     
     Inode *inode = &g_fs.inode_table[inode_id];
     
-    if (block_index >= inode->block_count || block_index >= MAX_DIRECT_BLOCKS) {
+    if ((uint32_t)block_index >= inode->block_count) {
         return -1;
     }
     
-    return inode->data_blocks[block_index];
+    int count;
+    return block_lookup(inode, block_index, &count);
+}
+
+/**
+ * 获取inode从第n块开始磁盘上连续的一段数据块
+ */
+int block_get_range_for_inode(int inode_id, int block_index, int max_count, int *count) {
+    if (!inode_is_used(inode_id) || block_index < 0 || max_count <= 0 || !count) {
+        return -1;
+    }
+    
+    Inode *inode = &g_fs.inode_table[inode_id];
+    if ((uint32_t)block_index >= inode->block_count) {
+        return -1;
+    }
+    if ((uint32_t)max_count > inode->block_count - block_index) {
+        max_count = inode->block_count - block_index;
+    }
+    
+    int run;
+    int block_id = block_lookup(inode, block_index, &run);
+    if (block_id == -1) {
+        return -1;
+    }
+    
+    // 块指针映射逐块检查后续块是否紧挨着
+    while (run < max_count && !(inode->flags & INODE_FLAG_EXTENTS)) {
+        int next;
+        if (block_lookup(inode, block_index + run, &next) != block_id + run) {
+            break;
+        }
+        run++;
+    }
+    
+    // 块编号在组内连续，跨组后磁盘偏移不再相邻
+    int group_end = (group_of_block(block_id) + 1) * FS_BLOCKS_PER_GROUP;
+    if (run > max_count) {
+        run = max_count;
+    }
+    if (run > group_end - block_id) {
+        run = group_end - block_id;
+    }
+    
+    *count = run;
+    return block_id;
+}
+
+/**
+ * 初始化inode的块映射
+ */
+void block_map_init(Inode *inode, bool extents) {
+    memset(inode->data_blocks, 0, sizeof(inode->data_blocks));
+    inode->flags &= ~(INODE_FLAG_INLINE | INODE_FLAG_FRAGMENT);
+    if (extents) {
+        extent_node_init((ExtentHeader *)inode->data_blocks, sizeof(inode->data_blocks), 0);
+        inode->flags |= INODE_FLAG_EXTENTS;
+    } else {
+        inode->flags &= ~INODE_FLAG_EXTENTS;
+    }
+}
+
+/**
+ * 打印inode的块映射 (调试用)
+ */
+void block_print_map(int inode_id) {
+    if (!inode_is_used(inode_id)) {
+        return;
+    }
+    
+    Inode *inode = &g_fs.inode_table[inode_id];
+    if (inode->flags & INODE_FLAG_INLINE) {
+        printf("内联数据: %lu/%d 字节\n", inode->size, INODE_INLINE_SIZE);
+        return;
+    }
+    if (inode->flags & INODE_FLAG_FRAGMENT) {
+        printf("碎片: 数据块%u，槽位%u-%u (%lu/%zu 字节)\n", inode->data_blocks[FRAGMENT_BLOCK],
+               inode->data_blocks[FRAGMENT_FIRST_SLOT],
+               inode->data_blocks[FRAGMENT_FIRST_SLOT] + inode->data_blocks[FRAGMENT_SLOT_COUNT] - 1,
+               inode->size, fragment_capacity(inode));
+        return;
+    }
+    if (!(inode->flags & INODE_FLAG_EXTENTS)) {
+        printf("直接数据块: ");
+        for (uint32_t i = 0; i < inode->block_count && i < MAX_DIRECT_BLOCKS; i++) {
+            printf("%u ", inode->data_blocks[i]);
+        }
+        printf("\n");
+        printf("间接块: 一级 %u, 二级 %u, 三级 %u\n", inode->data_blocks[INDIRECT_BLOCK],
+               inode->data_blocks[DOUBLE_INDIRECT_BLOCK], inode->data_blocks[TRIPLE_INDIRECT_BLOCK]);
+        return;
+    }
+    
+    ExtentHeader *root = (ExtentHeader *)inode->data_blocks;
+    printf("extent树: 高度%u\n", root->depth);
+    for (uint32_t index = 0; index < inode->block_count; ) {
+        int count;
+        int block_id = block_lookup(inode, index, &count);
+        if (block_id == -1) {
+            printf("  逻辑块%u: 未映射\n", index);
+            break;
+        }
+        printf("  逻辑块%u-%u -> 数据块%d-%d\n", index, index + count - 1,
+               block_id, block_id + count - 1);
+        index += count;
+    }
+}
+
+/**
+ * 写回映射块缓存中修改过的块
+ */
+int block_sync(void) {
+    int status = 0;
+    
+    pthread_mutex_lock(&map_cache.lock);
+    if (map_cache.buffers) {
+        for (int i = 0; i < MAP_CACHE_SIZE; i++) {
+            map_cache_entry_t *entry = &map_cache.entries[i];
+            if (entry->block_id != 0 && map_cache_writeback(entry) != 0) {
+                status = -1;
+            }
+        }
+    }
+    pthread_mutex_unlock(&map_cache.lock);
+    
+    return status;
+}
+
+/**
+ * 释放映射块缓存
+ */
+void block_cleanup(void) {
+    if (block_sync() != 0) {
+        printf("警告: 映射块缓存写回失败\n");
+    }
+    
+    pthread_mutex_lock(&map_cache.lock);
+    free(map_cache.buffers);
+    map_cache.buffers = NULL;
+    map_cache.hits = 0;
+    map_cache.misses = 0;
+    pthread_mutex_unlock(&map_cache.lock);
 }
 
 /**
  * 计算需要的数据块数量
  */
-int block_count_needed(size_t size) {
+int block_count_needed(uint64_t size) {
     if (size == 0) {
         return 0;
     }
     
-    return (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    return (size + FS_BLOCK_SIZE - 1) / FS_BLOCK_SIZE;
 }
 
 /**
  * 打印数据块使用统计
  */
 void block_print_usage(void) {
-    int used = bitmap_count_used_bits(g_fs.block_bitmap, MAX_BLOCKS);
-    int free = MAX_BLOCKS - used;
+    int used = bitmap_count_used_bits(g_fs.block_bitmap, FS_TOTAL_BLOCKS);
+    int free = FS_TOTAL_BLOCKS - used;
     
     printf("\n=== 数据块使用统计 ===\n");
-    printf("总数据块数: %d\n", MAX_BLOCKS);
+    printf("总数据块数: %d\n", FS_TOTAL_BLOCKS);
     printf("已使用: %d\n", used);
     printf("空闲: %d\n", free);
-    printf("使用率: %.1f%%\n", (float)used / MAX_BLOCKS * 100);
-    printf("块大小: %d 字节\n", BLOCK_SIZE);
-    printf("总容量: %.1f KB\n", (float)(MAX_BLOCKS * BLOCK_SIZE) / 1024);
-    printf("已使用容量: %.1f KB\n", (float)(used * BLOCK_SIZE) / 1024);
-    printf("空闲容量: %.1f KB\n", (float)(free * BLOCK_SIZE) / 1024);
+    printf("使用率: %.1f%%\n", (float)used / FS_TOTAL_BLOCKS * 100);
+    printf("块大小: %d 字节\n", FS_BLOCK_SIZE);
+    printf("总容量: %.1f KB\n", (float)(FS_TOTAL_BLOCKS * FS_BLOCK_SIZE) / 1024);
+    printf("已使用容量: %.1f KB\n", (float)(used * FS_BLOCK_SIZE) / 1024);
+    printf("空闲容量: %.1f KB\n", (float)(free * FS_BLOCK_SIZE) / 1024);
+    printf("映射块缓存: 命中%lu次，未命中%lu次\n", map_cache.hits, map_cache.misses);
     printf("====================\n\n");
 }
 
@@ -235,32 +1176,34 @@ void block_print_usage(void) {
  * 打印数据块信息 (调试用)
  */
 void block_print_info(int block_id) {
-    if (block_id < 0 || block_id >= MAX_BLOCKS) {
+    if (block_id < 0 || block_id >= FS_TOTAL_BLOCKS) {
         printf("数据块 %d: 无效\n", block_id);
         return;
     }
     
     bool used = block_is_used(block_id);
-    SuperBlock *sb = &g_fs.superblock;
-    off_t offset = sb->data_blocks_offset + block_id * BLOCK_SIZE;
+    off_t offset = block_offset(block_id);
     
     printf("\n=== 数据块 %d 信息 ===\n", block_id);
     printf("状态: %s\n", used ? "已使用" : "空闲");
-    printf("大小: %d 字节\n", BLOCK_SIZE);
+    printf("大小: %d 字节\n", FS_BLOCK_SIZE);
     printf("磁盘偏移: %ld\n", offset);
     
     if (used) {
         // 读取并显示块的前64字节内容
-        char buffer[BLOCK_SIZE];
-        if (block_read(block_id, buffer) > 0) {
+        char *buffer = bufpool_get(FS_BLOCK_SIZE);
+        if (buffer && block_read(block_id, buffer) > 0) {
             printf("内容预览 (前64字节):\n");
-            for (int i = 0; i < 64 && i < BLOCK_SIZE; i++) {
+            for (int i = 0; i < 64 && i < FS_BLOCK_SIZE; i++) {
                 if (i % 16 == 0) printf("%04x: ", i);
                 printf("%02x ", (unsigned char)buffer[i]);
                 if (i % 16 == 15) printf("\n");
             }
             if (64 % 16 != 0) printf("\n");
         }
+        if (buffer) {
+            bufpool_put(buffer, FS_BLOCK_SIZE);
+        }
     }
     
     printf("===================\n\n");
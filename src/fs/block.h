@@ -23,9 +23,12 @@ int block_init(void);
 
 /**
  * 分配一个空闲数据块
+ * 从目标块所在的块组开始查找，组内首次适配，组已满时依次尝试后面的组；
+ * 各组分别加锁，分配在不同组中的线程互不阻塞
+ * @param goal 目标块编号 (通常是文件最后一块的下一块，0表示无偏好)
  * @return 成功返回块编号，失败返回负数
  */
-int block_alloc(void);
+int block_alloc(int goal);
 
 /**
  * 释放一个数据块
@@ -33,6 +36,13 @@ int block_alloc(void);
  */
 void block_free(int block_id);
 
+/**
+ * 计算数据块在磁盘中的偏移量
+ * @param block_id 块编号
+ * @return 成功返回偏移量，无效块返回负数
+ */
+off_t block_offset(int block_id);
+
 /**
  * 读取数据块内容
  * @param block_id 块编号
@@ -71,26 +81,68 @@ int block_clear(int block_id);
 int block_alloc_for_inode(int inode_id);
 
 /**
- * 释放inode的所有数据块
+ * 把inode的数据块缩减到指定数量，并释放不再需要的间接块
+ * @param inode_id inode编号
+ * @param block_count 保留的块数
+ * @return 成功返回0，失败返回负数
+ */
+int block_truncate_for_inode(int inode_id, int block_count);
+
+/**
+ * 释放inode的所有数据块 (碎片文件归还槽位并回到空的内联状态)
  * @param inode_id inode编号
  * @return 成功返回0，失败返回负数
  */
 int block_free_all_for_inode(int inode_id);
 
 /**
- * 获取inode的第n个数据块
+ * 获取inode的第n个数据块 (经映射块缓存查找，顺序访问不会重复读取间接块)
  * @param inode_id inode编号
  * @param block_index 块索引 (0-based)
  * @return 成功返回块编号，失败返回负数
  */
 int block_get_for_inode(int inode_id, int block_index);
 
+/**
+ * 获取inode从第n块开始磁盘上连续的一段数据块 (extent映射时一次查找即得整段)
+ * @param inode_id inode编号
+ * @param block_index 起始块索引 (0-based)
+ * @param max_count 最多需要的块数
+ * @param count 输出连续的块数 (不超过max_count，不跨越块组)
+ * @return 成功返回首块编号，失败返回负数
+ */
+int block_get_range_for_inode(int inode_id, int block_index, int max_count, int *count);
+
+/**
+ * 初始化inode的块映射 (新建inode或内联、碎片文件转为块映射时调用，清除内联和碎片标志)
+ * @param inode inode
+ * @param extents 是否使用extent树 (否则使用直接/间接块指针)
+ */
+void block_map_init(Inode *inode, bool extents);
+
+/**
+ * 打印inode的块映射 (调试用)
+ * @param inode_id inode编号
+ */
+void block_print_map(int inode_id);
+
+/**
+ * 写回映射块 (间接块和extent树节点) 缓存中修改过的块 (提交元数据时调用)
+ * @return 成功返回0，失败返回负数
+ */
+int block_sync(void);
+
+/**
+ * 写回并释放映射块缓存
+ */
+void block_cleanup(void);
+
 /**
  * 计算需要的数据块数量
  * @param size 文件大小
  * @return 需要的块数
  */
-int block_count_needed(size_t size);
+int block_count_needed(uint64_t size);
 
 /**
  * 打印数据块使用统计
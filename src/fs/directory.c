@@ -23,7 +23,7 @@ int dir_create(const char *name, int parent_inode) {
     }
     
     // 检查父目录是否存在且为目录
-    if (!inode_is_used(parent_inode) || !g_fs.inode_table[parent_inode].is_directory) {
+    if (!inode_is_used(parent_inode) || !S_ISDIR(g_fs.inode_table[parent_inode].mode)) {
         return -1;
     }
     
@@ -52,7 +52,7 @@ int dir_create(const char *name, int parent_inode) {
  * 删除目录
  */
 int dir_delete(int inode_id) {
-    if (!inode_is_used(inode_id) || !g_fs.inode_table[inode_id].is_directory) {
+    if (!inode_is_used(inode_id) || !S_ISDIR(g_fs.inode_table[inode_id].mode)) {
         return -1;
     }
     
@@ -74,12 +74,12 @@ int dir_delete(int inode_id) {
  * 在目录中查找条目
  */
 int dir_find_entry(int dir_inode, const char *name) {
-    if (!inode_is_used(dir_inode) || !g_fs.inode_table[dir_inode].is_directory || !name) {
+    if (!inode_is_used(dir_inode) || !S_ISDIR(g_fs.inode_table[dir_inode].mode) || !name) {
         return -1;
     }
     
     // 简化实现：遍历所有inode查找匹配的子项
-    for (int i = 0; i < MAX_INODES; i++) {
+    for (int i = 0; i < FS_TOTAL_INODES; i++) {
         if (inode_is_used(i) && 
             g_fs.inode_table[i].parent_inode == dir_inode &&
             strcmp(g_fs.inode_table[i].name, name) == 0) {
@@ -94,7 +94,7 @@ int dir_find_entry(int dir_inode, const char *name) {
  * 向目录添加条目
  */
 int dir_add_entry(int dir_inode, const char *name, int inode_id) {
-    if (!inode_is_used(dir_inode) || !g_fs.inode_table[dir_inode].is_directory ||
+    if (!inode_is_used(dir_inode) || !S_ISDIR(g_fs.inode_table[dir_inode].mode) ||
         !name || !inode_is_used(inode_id)) {
         return -1;
     }
@@ -120,7 +120,7 @@ int dir_add_entry(int dir_inode, const char *name, int inode_id) {
  * 从目录删除条目
  */
 int dir_remove_entry(int dir_inode, const char *name) {
-    if (!inode_is_used(dir_inode) || !g_fs.inode_table[dir_inode].is_directory || !name) {
+    if (!inode_is_used(dir_inode) || !S_ISDIR(g_fs.inode_table[dir_inode].mode) || !name) {
         return -1;
     }
     
@@ -131,12 +131,12 @@ int dir_remove_entry(int dir_inode, const char *name) {
     }
     
     // 如果是目录，检查是否为空
-    if (g_fs.inode_table[target_inode].is_directory && !dir_is_empty(target_inode)) {
+    if (S_ISDIR(g_fs.inode_table[target_inode].mode) && !dir_is_empty(target_inode)) {
         return -1;  // 目录不为空
     }
     
     // 释放目标inode的资源
-    if (g_fs.inode_table[target_inode].is_directory) {
+    if (S_ISDIR(g_fs.inode_table[target_inode].mode)) {
         dir_delete(target_inode);
     } else {
         block_free_all_for_inode(target_inode);
@@ -153,14 +153,14 @@ int dir_remove_entry(int dir_inode, const char *name) {
  * 列出目录中的所有条目
  */
 int dir_list_entries(int dir_inode, void (*callback)(const char *name, int inode)) {
-    if (!inode_is_used(dir_inode) || !g_fs.inode_table[dir_inode].is_directory || !callback) {
+    if (!inode_is_used(dir_inode) || !S_ISDIR(g_fs.inode_table[dir_inode].mode) || !callback) {
         return -1;
     }
     
     int count = 0;
     
     // 遍历所有inode查找子项
-    for (int i = 0; i < MAX_INODES; i++) {
+    for (int i = 0; i < FS_TOTAL_INODES; i++) {
         if (inode_is_used(i) && g_fs.inode_table[i].parent_inode == dir_inode) {
             callback(g_fs.inode_table[i].name, i);
             count++;
@@ -177,12 +177,12 @@ int dir_list_entries(int dir_inode, void (*callback)(const char *name, int inode
  * 检查目录是否为空
  */
 bool dir_is_empty(int dir_inode) {
-    if (!inode_is_used(dir_inode) || !g_fs.inode_table[dir_inode].is_directory) {
+    if (!inode_is_used(dir_inode) || !S_ISDIR(g_fs.inode_table[dir_inode].mode)) {
         return false;
     }
     
     // 检查是否有子项
-    for (int i = 0; i < MAX_INODES; i++) {
+    for (int i = 0; i < FS_TOTAL_INODES; i++) {
         if (inode_is_used(i) && g_fs.inode_table[i].parent_inode == dir_inode) {
             return false;  // 找到子项，不为空
         }
@@ -309,13 +309,13 @@ int dir_get_full_path(int inode_id, char *path, size_t max_len) {
  * 统计目录中的条目数量
  */
 int dir_count_entries(int dir_inode) {
-    if (!inode_is_used(dir_inode) || !g_fs.inode_table[dir_inode].is_directory) {
+    if (!inode_is_used(dir_inode) || !S_ISDIR(g_fs.inode_table[dir_inode].mode)) {
         return -1;
     }
     
     int count = 0;
     
-    for (int i = 0; i < MAX_INODES; i++) {
+    for (int i = 0; i < FS_TOTAL_INODES; i++) {
         if (inode_is_used(i) && g_fs.inode_table[i].parent_inode == dir_inode) {
             count++;
         }
@@ -328,7 +328,7 @@ int dir_count_entries(int dir_inode) {
  * 打印目录信息 (调试用)
  */
 void dir_print_info(int dir_inode) {
-    if (!inode_is_used(dir_inode) || !g_fs.inode_table[dir_inode].is_directory) {
+    if (!inode_is_used(dir_inode) || !S_ISDIR(g_fs.inode_table[dir_inode].mode)) {
         printf("目录 %d: 无效或不是目录\n", dir_inode);
         return;
     }
@@ -343,14 +343,16 @@ void dir_print_info(int dir_inode) {
     printf("父目录: %d\n", inode->parent_inode);
     printf("条目数量: %d\n", dir_count_entries(dir_inode));
     printf("是否为空: %s\n", dir_is_empty(dir_inode) ? "是" : "否");
-    printf("创建时间: %s", ctime(&inode->created));
-    printf("修改时间: %s", ctime(&inode->modified));
+    time_t created = inode->created;
+    time_t modified = inode->modified;
+    printf("创建时间: %s", ctime(&created));
+    printf("修改时间: %s", ctime(&modified));
     
     printf("子条目:\n");
-    for (int i = 0; i < MAX_INODES; i++) {
+    for (int i = 0; i < FS_TOTAL_INODES; i++) {
         if (inode_is_used(i) && g_fs.inode_table[i].parent_inode == dir_inode) {
             printf("  %s (%s)\n", g_fs.inode_table[i].name,
-                   g_fs.inode_table[i].is_directory ? "目录" : "文件");
+                   S_ISDIR(g_fs.inode_table[i].mode) ? "目录" : "文件");
         }
     }
     
@@ -10,6 +10,131 @@
 #include "inode.h"
 #include "block.h"
 #include "directory.h"
+#include "fragment.h"
+#include "../core/disk.h"
+#include "../core/bufpool.h"
+#include "../core/iostat.h"
+#include <limits.h>
+
+// ============================================================================
+// 内部辅助函数
+// ============================================================================
+
+/**
+ * 检查文件数据是否内联保存在inode中
+ */
+static bool file_is_inline(const Inode *inode) {
+    return (inode->flags & INODE_FLAG_INLINE) != 0;
+}
+
+/**
+ * 检查文件数据是否打包在碎片块中
+ */
+static bool file_is_fragment(const Inode *inode) {
+    return (inode->flags & INODE_FLAG_FRAGMENT) != 0;
+}
+
+/**
+ * 读出内联或碎片文件的全部数据 (不超过fragment_max_size()字节)
+ */
+static int file_packed_load(const Inode *inode, char *data) {
+    if (file_is_inline(inode)) {
+        memcpy(data, inode->data_blocks, inode->size);
+        return 0;
+    }
+    if (inode->size > 0 && disk_read(fragment_offset(inode), data, inode->size) < 0) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * 确保内联或碎片文件能在碎片块中容纳size字节: 槽位不够时分配新的碎片，
+ * 把原内容连同补齐的0写入整个新槽位后再释放原来的碎片 (槽位中超出文件大小的字节总是0)
+ */
+static int file_pack(int inode_id, uint64_t size) {
+    Inode *inode = &g_fs.inode_table[inode_id];
+    if (file_is_fragment(inode) && fragment_capacity(inode) >= size) {
+        return 0;
+    }
+    
+    Inode saved = *inode;
+    char *buffer = bufpool_get(FS_BLOCK_SIZE);
+    if (!buffer) {
+        return -1;
+    }
+    memset(buffer, 0, FS_BLOCK_SIZE);
+    if (file_packed_load(&saved, buffer) != 0 || fragment_alloc(inode_id, inode, size) != 0) {
+        bufpool_put(buffer, FS_BLOCK_SIZE);
+        return -1;
+    }
+    
+    if (disk_write(fragment_offset(inode), buffer, fragment_capacity(inode)) != 0) {
+        fragment_release(inode);
+        *inode = saved;
+        bufpool_put(buffer, FS_BLOCK_SIZE);
+        return -1;
+    }
+    if (file_is_fragment(&saved)) {
+        fragment_release(&saved);
+    }
+    
+    bufpool_put(buffer, FS_BLOCK_SIZE);
+    return 0;
+}
+
+/**
+ * 把磁盘上一段不超过一块的区域写为0 (缩小文件时清零截掉的部分，再次扩大时读出为0)
+ */
+static int file_clear_range(off_t offset, size_t size) {
+    char *zeros = bufpool_get(FS_BLOCK_SIZE);
+    if (!zeros) {
+        return -1;
+    }
+    memset(zeros, 0, FS_BLOCK_SIZE);
+    int status = disk_write(offset, zeros, size);
+    bufpool_put(zeros, FS_BLOCK_SIZE);
+    return status;
+}
+
+/**
+ * 把内联或碎片文件转为extent映射: 有数据时分配第一个数据块并写入原内容
+ * 失败时恢复原来的状态
+ */
+static int file_promote(int inode_id) {
+    Inode *inode = &g_fs.inode_table[inode_id];
+    Inode saved = *inode;
+    char *buffer = bufpool_get(FS_BLOCK_SIZE);
+    if (!buffer) {
+        return -1;
+    }
+    memset(buffer, 0, FS_BLOCK_SIZE);
+    if (file_packed_load(&saved, buffer) != 0) {
+        bufpool_put(buffer, FS_BLOCK_SIZE);
+        return -1;
+    }
+    
+    block_map_init(inode, true);
+    g_fs.is_dirty = true;
+    if (inode->size > 0) {
+        int block_id = block_alloc_for_inode(inode_id);
+        if (block_id == -1 || block_write(block_id, buffer) != 0) {
+            if (block_id != -1) {
+                block_truncate_for_inode(inode_id, 0);
+            }
+            memcpy(inode->data_blocks, saved.data_blocks, sizeof(inode->data_blocks));
+            inode->flags = saved.flags;
+            bufpool_put(buffer, FS_BLOCK_SIZE);
+            return -1;
+        }
+    }
+    if (file_is_fragment(&saved)) {
+        fragment_release(&saved);
+    }
+    
+    bufpool_put(buffer, FS_BLOCK_SIZE);
+    return 0;
+}
 
 // ============================================================================
 // 文件操作函数实现
@@ -24,7 +149,7 @@ int file_create(const char *name, int parent_inode) {
     }
     
     // 检查父目录是否存在且为目录
-    if (!inode_is_used(parent_inode) || !g_fs.inode_table[parent_inode].is_directory) {
+    if (!inode_is_used(parent_inode) || !S_ISDIR(g_fs.inode_table[parent_inode].mode)) {
         return -1;
     }
     
@@ -46,7 +171,7 @@ int file_create(const char *name, int parent_inode) {
  * 删除文件
  */
 int file_delete(int inode_id) {
-    if (!inode_is_used(inode_id) || g_fs.inode_table[inode_id].is_directory) {
+    if (!inode_is_used(inode_id) || S_ISDIR(g_fs.inode_table[inode_id].mode)) {
         return -1;  // 不是文件
     }
     
@@ -59,131 +184,281 @@ int file_delete(int inode_id) {
     return 0;
 }
 
+/**
+ * 把文件字节范围拆分为批量I/O请求
+ * 磁盘上连续的整块合并为一个请求并直接指向调用者缓冲区，首尾不完整的块指向head/tail缓冲区
+ * @return 请求数量，*mapped输出已映射到数据块的字节数
+ */
+static int file_build_batch(int inode_id, char *buf, size_t size, off_t offset,
+                            disk_io_t *ios, char *head_buffer, char *tail_buffer,
+                            size_t *mapped) {
+    int first_index = offset / FS_BLOCK_SIZE;
+    int last_index = (offset + size - 1) / FS_BLOCK_SIZE;
+    off_t end = offset + (off_t)size;
+    bool tail_partial = end % FS_BLOCK_SIZE != 0;
+    int count = 0;
+    
+    *mapped = 0;
+    for (int index = first_index; index <= last_index; ) {
+        // 获取从本块开始磁盘上连续的一段数据块
+        int run;
+        int block_id = block_get_range_for_inode(inode_id, index, last_index - index + 1, &run);
+        if (block_id == -1) {
+            break;  // 没有更多数据块
+        }
+        
+        for (int i = 0; i < run; ) {
+            off_t block_start = (off_t)(index + i) * FS_BLOCK_SIZE;
+            off_t seg_start = offset > block_start ? offset : block_start;
+            off_t seg_end = block_start + FS_BLOCK_SIZE < end ? block_start + FS_BLOCK_SIZE : end;
+            
+            // 不完整的块单独经首尾缓冲区读写
+            if (seg_end - seg_start != FS_BLOCK_SIZE) {
+                ios[count].offset = block_offset(block_id + i);
+                ios[count].buffer = (index + i == first_index) ? head_buffer : tail_buffer;
+                ios[count].size = FS_BLOCK_SIZE;
+                count++;
+                i++;
+                *mapped = seg_end - offset;
+                continue;
+            }
+            
+            // 其余整块 (不含不完整的末块) 合并为一个请求
+            int n = run - i;
+            if (index + i + n - 1 == last_index && tail_partial) {
+                n--;
+            }
+            ios[count].offset = block_offset(block_id + i);
+            ios[count].buffer = buf + (block_start - offset);
+            ios[count].size = (size_t)n * FS_BLOCK_SIZE;
+            count++;
+            i += n;
+            *mapped = block_start + (off_t)n * FS_BLOCK_SIZE - offset;
+        }
+        index += run;
+    }
+    
+    return count;
+}
+
 /**
  * 读取文件内容
  */
-int file_read(int inode_id, void *buffer, size_t size, off_t offset) {
-    if (!inode_is_used(inode_id) || g_fs.inode_table[inode_id].is_directory || !buffer) {
+ssize_t file_read(int inode_id, void *buffer, size_t size, off_t offset) {
+    if (!inode_is_used(inode_id) || S_ISDIR(g_fs.inode_table[inode_id].mode) || !buffer ||
+        offset < 0) {
         return -1;
     }
     
+    uint64_t start = iostat_start();
     Inode *inode = &g_fs.inode_table[inode_id];
     
     // 检查偏移量
-    if (offset >= inode->size) {
+    if ((uint64_t)offset >= inode->size) {
         return 0;  // 超出文件末尾
     }
     
-    // 调整读取大小
-    if (offset + size > (size_t)inode->size) {
-        size = inode->size - offset;
+    // 调整读取大小 (剩余长度用64位计算，不会溢出)
+    if (size > inode->size - (uint64_t)offset) {
+        size = inode->size - (uint64_t)offset;
+    }
+    if (size > SSIZE_MAX) {
+        size = SSIZE_MAX;
     }
     
-    size_t bytes_read = 0;
-    char *buf = (char *)buffer;
+    if (size == 0) {
+        return 0;
+    }
     
-    // 逐块读取
-    while (bytes_read < size) {
-        // 计算当前块索引和块内偏移
-        int block_index = (offset + bytes_read) / BLOCK_SIZE;
-        int block_offset = (offset + bytes_read) % BLOCK_SIZE;
-        
-        // 获取数据块编号
-        int block_id = block_get_for_inode(inode_id, block_index);
-        if (block_id == -1) {
-            break;  // 没有更多数据块
-        }
-        
-        // 读取块数据
-        char block_buffer[BLOCK_SIZE];
-        if (block_read(block_id, block_buffer) < 0) {
-            break;  // 读取失败
+    // 内联数据直接从内存中的inode表复制，不访问磁盘
+    if (file_is_inline(inode)) {
+        memcpy(buffer, (const char *)inode->data_blocks + offset, size);
+        inode_update_times(inode_id, true, false);
+        iostat_record(IOSTAT_FILE_READ, start, size);
+        return size;
+    }
+    
+    // 碎片文件的数据在碎片块中连续存放，一次读取
+    if (file_is_fragment(inode)) {
+        if (disk_read(fragment_offset(inode) + offset, buffer, size) < 0) {
+            return -1;
         }
-        
-        // 计算本次读取的字节数
-        size_t to_read = BLOCK_SIZE - block_offset;
-        if (to_read > size - bytes_read) {
-            to_read = size - bytes_read;
+        inode_update_times(inode_id, true, false);
+        iostat_record(IOSTAT_FILE_READ, start, size);
+        return size;
+    }
+    
+    char *buf = (char *)buffer;
+    size_t max_blocks = (offset + size - 1) / FS_BLOCK_SIZE - offset / FS_BLOCK_SIZE + 1;
+    disk_io_t *ios = malloc(max_blocks * sizeof(disk_io_t));
+    if (!ios) {
+        return -1;
+    }
+    
+    // 首尾缓冲区取自对齐缓冲区池，O_DIRECT下无需再中转
+    char *head_buffer = bufpool_get(FS_BLOCK_SIZE);
+    char *tail_buffer = bufpool_get(FS_BLOCK_SIZE);
+    if (!head_buffer || !tail_buffer) {
+        bufpool_put(head_buffer, FS_BLOCK_SIZE);
+        bufpool_put(tail_buffer, FS_BLOCK_SIZE);
+        free(ios);
+        return -1;
+    }
+    
+    // 一次提交整个请求涉及的所有数据块
+    size_t bytes_read = 0;
+    int count = file_build_batch(inode_id, buf, size, offset, ios,
+                                 head_buffer, tail_buffer, &bytes_read);
+    if (disk_readv(ios, count) != 0) {
+        bufpool_put(head_buffer, FS_BLOCK_SIZE);
+        bufpool_put(tail_buffer, FS_BLOCK_SIZE);
+        free(ios);
+        return -1;  // 读取失败
+    }
+    
+    // 从首尾缓冲区复制不完整块的数据
+    if (count > 0 && ios[0].buffer == head_buffer) {
+        size_t block_offset = offset % FS_BLOCK_SIZE;
+        size_t to_read = FS_BLOCK_SIZE - block_offset;
+        if (to_read > bytes_read) {
+            to_read = bytes_read;
         }
-        
-        // 复制数据
-        memcpy(buf + bytes_read, block_buffer + block_offset, to_read);
-        bytes_read += to_read;
+        memcpy(buf, head_buffer + block_offset, to_read);
+    }
+    if (count > 0 && ios[count - 1].buffer == tail_buffer) {
+        size_t tail_len = (offset + bytes_read) % FS_BLOCK_SIZE;
+        memcpy(buf + bytes_read - tail_len, tail_buffer, tail_len);
     }
+    bufpool_put(head_buffer, FS_BLOCK_SIZE);
+    bufpool_put(tail_buffer, FS_BLOCK_SIZE);
+    free(ios);
     
     // 更新访问时间
     inode_update_times(inode_id, true, false);
     
+    iostat_record(IOSTAT_FILE_READ, start, bytes_read);
     return bytes_read;
 }
 
 /**
  * 写入文件内容
  */
-int file_write(int inode_id, const void *buffer, size_t size, off_t offset) {
-    if (!inode_is_used(inode_id) || g_fs.inode_table[inode_id].is_directory || !buffer) {
+ssize_t file_write(int inode_id, const void *buffer, size_t size, off_t offset) {
+    if (!inode_is_used(inode_id) || S_ISDIR(g_fs.inode_table[inode_id].mode) || !buffer ||
+        offset < 0) {
+        return -1;
+    }
+    
+    // 写入范围不能超过最大文件大小
+    if (size > (uint64_t)file_max_size() || offset > file_max_size() - (off_t)size) {
         return -1;
     }
     
+    uint64_t start = iostat_start();
     Inode *inode = &g_fs.inode_table[inode_id];
     const char *buf = (const char *)buffer;
-    size_t bytes_written = 0;
+    
+    // 写入后仍放得下的内联文件只修改inode，不超过半块的文件打包在碎片块中，
+    // 更大时转为extent映射
+    uint64_t new_size = (uint64_t)offset + size;
+    if (file_is_inline(inode) || file_is_fragment(inode)) {
+        if (size == 0) {
+            return 0;
+        }
+        if (new_size <= fragment_max_size()) {
+            if (file_is_inline(inode) && new_size <= INODE_INLINE_SIZE) {
+                memcpy((char *)inode->data_blocks + offset, buf, size);
+            } else if (file_pack(inode_id, new_size) != 0 ||
+                       disk_write(fragment_offset(inode) + offset, buf, size) != 0) {
+                return -1;
+            }
+            if (new_size > inode->size) {
+                inode->size = new_size;
+            }
+            inode_update_times(inode_id, false, true);
+            g_fs.is_dirty = true;
+            iostat_record(IOSTAT_FILE_WRITE, start, size);
+            return size;
+        }
+        if (file_promote(inode_id) != 0) {
+            return -1;
+        }
+    }
     
     // 确保有足够的数据块
-    size_t new_size = offset + size;
     if (file_alloc_blocks(inode_id, new_size) != 0) {
         return -1;  // 分配失败
     }
     
-    // 逐块写入
-    while (bytes_written < size) {
-        // 计算当前块索引和块内偏移
-        int block_index = (offset + bytes_written) / BLOCK_SIZE;
-        int block_offset = (offset + bytes_written) % BLOCK_SIZE;
-        
-        // 获取数据块编号
-        int block_id = block_get_for_inode(inode_id, block_index);
-        if (block_id == -1) {
-            // 需要分配新块
-            block_id = block_alloc_for_inode(inode_id);
-            if (block_id == -1) {
-                break;  // 分配失败
-            }
-        }
-        
-        // 读取现有块数据 (如果需要部分写入)
-        char block_buffer[BLOCK_SIZE];
-        if (block_offset != 0 || (size - bytes_written) < BLOCK_SIZE) {
-            if (block_read(block_id, block_buffer) < 0) {
-                memset(block_buffer, 0, BLOCK_SIZE);  // 清零
-            }
-        }
-        
-        // 计算本次写入的字节数
-        size_t to_write = BLOCK_SIZE - block_offset;
-        if (to_write > size - bytes_written) {
-            to_write = size - bytes_written;
-        }
-        
-        // 复制数据到块缓冲区
-        memcpy(block_buffer + block_offset, buf + bytes_written, to_write);
-        
-        // 写入块
-        if (block_write(block_id, block_buffer) < 0) {
-            break;  // 写入失败
+    if (size == 0) {
+        return 0;
+    }
+    
+    size_t max_blocks = (offset + size - 1) / FS_BLOCK_SIZE - offset / FS_BLOCK_SIZE + 1;
+    disk_io_t *ios = malloc(max_blocks * sizeof(disk_io_t));
+    if (!ios) {
+        return -1;
+    }
+    
+    char *head_buffer = bufpool_get(FS_BLOCK_SIZE);
+    char *tail_buffer = bufpool_get(FS_BLOCK_SIZE);
+    if (!head_buffer || !tail_buffer) {
+        bufpool_put(head_buffer, FS_BLOCK_SIZE);
+        bufpool_put(tail_buffer, FS_BLOCK_SIZE);
+        free(ios);
+        return -1;
+    }
+    
+    // 整块直接从调用者缓冲区写出，只读取首尾不完整的块
+    size_t bytes_written = 0;
+    int count = file_build_batch(inode_id, (char *)buf, size, offset, ios,
+                                 head_buffer, tail_buffer, &bytes_written);
+    
+    disk_io_t partial[2];
+    int partial_count = 0;
+    if (count > 0 && ios[0].buffer == head_buffer) {
+        partial[partial_count++] = ios[0];
+    }
+    if (count > 1 && ios[count - 1].buffer == tail_buffer) {
+        partial[partial_count++] = ios[count - 1];
+    }
+    if (disk_readv(partial, partial_count) != 0) {
+        memset(head_buffer, 0, FS_BLOCK_SIZE);  // 清零
+        memset(tail_buffer, 0, FS_BLOCK_SIZE);
+    }
+    
+    // 复制数据到首尾块缓冲区
+    if (count > 0 && ios[0].buffer == head_buffer) {
+        size_t block_offset = offset % FS_BLOCK_SIZE;
+        size_t to_write = FS_BLOCK_SIZE - block_offset;
+        if (to_write > bytes_written) {
+            to_write = bytes_written;
         }
-        
-        bytes_written += to_write;
+        memcpy(head_buffer + block_offset, buf, to_write);
+    }
+    if (count > 1 && ios[count - 1].buffer == tail_buffer) {
+        size_t tail_len = (offset + bytes_written) % FS_BLOCK_SIZE;
+        memcpy(tail_buffer, buf + bytes_written - tail_len, tail_len);
+    }
+    
+    // 一次提交所有块的写入
+    int result = disk_writev(ios, count);
+    bufpool_put(head_buffer, FS_BLOCK_SIZE);
+    bufpool_put(tail_buffer, FS_BLOCK_SIZE);
+    free(ios);
+    if (result != 0) {
+        return -1;  // 写入失败
     }
     
     // 更新文件大小
-    if (offset + bytes_written > (size_t)inode->size) {
-        inode->size = offset + bytes_written;
+    if ((uint64_t)offset + bytes_written > inode->size) {
+        inode->size = (uint64_t)offset + bytes_written;
     }
     
     // 更新修改时间
     inode_update_times(inode_id, false, true);
     
+    iostat_record(IOSTAT_FILE_WRITE, start, bytes_written);
     return bytes_written;
 }
 
@@ -191,25 +466,58 @@ int file_write(int inode_id, const void *buffer, size_t size, off_t offset) {
  * 截断文件
  */
 int file_truncate(int inode_id, off_t size) {
-    if (!inode_is_used(inode_id) || g_fs.inode_table[inode_id].is_directory) {
+    if (!inode_is_used(inode_id) || S_ISDIR(g_fs.inode_table[inode_id].mode)) {
         return -1;
     }
     
     Inode *inode = &g_fs.inode_table[inode_id];
     
-    if (size < 0) {
+    if (size < 0 || size > file_max_size()) {
         return -1;  // 无效大小
     }
     
+    // 内联和碎片文件: 缩小时清零截掉的部分 (超出文件大小的字节保持为0)，
+    // 扩大时按需换到更大的碎片，超过半块时转为extent映射；截断为0时碎片由下面释放
+    if ((file_is_inline(inode) || file_is_fragment(inode)) && size > 0) {
+        if ((uint64_t)size <= fragment_max_size()) {
+            int status = 0;
+            if (file_is_inline(inode) && (uint64_t)size <= INODE_INLINE_SIZE) {
+                if ((uint64_t)size < inode->size) {
+                    memset((char *)inode->data_blocks + size, 0, inode->size - size);
+                }
+            } else if ((uint64_t)size > inode->size) {
+                status = file_pack(inode_id, size);
+            } else if ((uint64_t)size < inode->size) {
+                status = file_clear_range(fragment_offset(inode) + size, inode->size - size);
+            }
+            if (status != 0) {
+                return -1;
+            }
+            inode->size = size;
+            inode_update_times(inode_id, false, true);
+            g_fs.is_dirty = true;
+            return 0;
+        }
+        if (file_promote(inode_id) != 0) {
+            return -1;
+        }
+    }
+    
     if (size == 0) {
         // 截断为0，释放所有数据块
         block_free_all_for_inode(inode_id);
         inode->size = 0;
-    } else if ((size_t)size < inode->size) {
-        // 缩小文件，释放多余的块
+    } else if ((uint64_t)size < inode->size) {
+        // 缩小文件，释放多余的块，并清零保留的最后一块中截掉的部分
         file_free_excess_blocks(inode_id, size);
+        int block_id = block_get_for_inode(inode_id, size / FS_BLOCK_SIZE);
+        if (size % FS_BLOCK_SIZE != 0 && block_id != -1 &&
+            file_clear_range(block_offset(block_id) + size % FS_BLOCK_SIZE,
+                             FS_BLOCK_SIZE - size % FS_BLOCK_SIZE) != 0) {
+            return -1;
+        }
         inode->size = size;
-    } else if ((size_t)size > inode->size) {
+    } else if ((uint64_t)size > inode->size) {
         // 扩大文件，分配新块
         if (file_alloc_blocks(inode_id, size) == 0) {
             inode->size = size;
@@ -235,13 +543,20 @@ int file_rename(int inode_id, const char *new_name) {
  * 获取文件大小
  */
 off_t file_get_size(int inode_id) {
-    if (!inode_is_used(inode_id) || g_fs.inode_table[inode_id].is_directory) {
+    if (!inode_is_used(inode_id) || S_ISDIR(g_fs.inode_table[inode_id].mode)) {
         return -1;
     }
     
     return g_fs.inode_table[inode_id].size;
 }
 
+/**
+ * 获取单个文件允许的最大大小
+ */
+off_t file_max_size(void) {
+    return (off_t)INT32_MAX * FS_BLOCK_SIZE;
+}
+
 /**
  * 设置文件大小
  */
@@ -254,7 +569,7 @@ int file_set_size(int inode_id, off_t size) {
  */
 int file_exists(int parent_inode, const char *name) {
     int inode_id = dir_find_entry(parent_inode, name);
-    if (inode_id != -1 && !g_fs.inode_table[inode_id].is_directory) {
+    if (inode_id != -1 && !S_ISDIR(g_fs.inode_table[inode_id].mode)) {
         return inode_id;
     }
     return -1;
@@ -263,7 +578,7 @@ int file_exists(int parent_inode, const char *name) {
 /**
  * 分配文件所需的数据块
  */
-int file_alloc_blocks(int inode_id, size_t size) {
+int file_alloc_blocks(int inode_id, uint64_t size) {
     if (!inode_is_used(inode_id)) {
         return -1;
     }
@@ -272,7 +587,7 @@ int file_alloc_blocks(int inode_id, size_t size) {
     int needed_blocks = block_count_needed(size);
     
     // 分配不足的块
-    while (inode->block_count < needed_blocks && inode->block_count < MAX_DIRECT_BLOCKS) {
+    while (inode->block_count < (uint32_t)needed_blocks) {
         int block_id = block_alloc_for_inode(inode_id);
         if (block_id == -1) {
             return -1;  // 分配失败
@@ -285,27 +600,13 @@ int file_alloc_blocks(int inode_id, size_t size) {
 /**
  * 释放文件多余的数据块
  */
-int file_free_excess_blocks(int inode_id, size_t new_size) {
+int file_free_excess_blocks(int inode_id, uint64_t new_size) {
     if (!inode_is_used(inode_id)) {
         return -1;
     }
     
-    Inode *inode = &g_fs.inode_table[inode_id];
-    int needed_blocks = block_count_needed(new_size);
-    
-    // 释放多余的块
-    while (inode->block_count > needed_blocks) {
-        int last_block = inode->block_count - 1;
-        if (last_block >= 0 && last_block < MAX_DIRECT_BLOCKS) {
-            block_free(inode->data_blocks[last_block]);
-            inode->data_blocks[last_block] = 0;
-            inode->block_count--;
-        } else {
-            break;
-        }
-    }
-    
-    return 0;
+    // 释放多余的块 (连同不再需要的间接块)
+    return block_truncate_for_inode(inode_id, block_count_needed(new_size));
 }
 
 /**
@@ -317,7 +618,7 @@ void file_print_info(int inode_id) {
         return;
     }
     
-    if (g_fs.inode_table[inode_id].is_directory) {
+    if (S_ISDIR(g_fs.inode_table[inode_id].mode)) {
         printf("文件 %d: 这是一个目录\n", inode_id);
         return;
     }
@@ -326,21 +627,20 @@ void file_print_info(int inode_id) {
     
     printf("\n=== 文件 %d 信息 ===\n", inode_id);
     printf("名称: %s\n", inode->name);
-    printf("大小: %u 字节\n", inode->size);
+    printf("大小: %lu 字节\n", inode->size);
     printf("数据块数: %u\n", inode->block_count);
-    printf("所有者: %u\n", inode->owner_id);
-    printf("权限: %s\n", inode->permissions);
+    printf("所有者: %u:%u\n", inode->uid, inode->gid);
+    printf("权限: %04o\n", inode->mode & 07777);
     printf("父目录: %u\n", inode->parent_inode);
     printf("硬链接数: %u\n", inode->link_count);
-    printf("创建时间: %s", ctime(&inode->created));
-    printf("修改时间: %s", ctime(&inode->modified));
-    printf("访问时间: %s", ctime(&inode->accessed));
+    time_t created = inode->created;
+    time_t modified = inode->modified;
+    time_t accessed = inode->accessed;
+    printf("创建时间: %s", ctime(&created));
+    printf("修改时间: %s", ctime(&modified));
+    printf("访问时间: %s", ctime(&accessed));
     
-    printf("数据块列表: ");
-    for (int i = 0; i < inode->block_count && i < MAX_DIRECT_BLOCKS; i++) {
-        printf("%u ", inode->data_blocks[i]);
-    }
-    printf("\n");
+    block_print_map(inode_id);
     
     printf("完整性: %s\n", file_verify_integrity(inode_id) ? "正常" : "损坏");
     printf("==================\n\n");
@@ -350,16 +650,26 @@ void file_print_info(int inode_id) {
  * 验证文件完整性
  */
 bool file_verify_integrity(int inode_id) {
-    if (!inode_is_used(inode_id) || g_fs.inode_table[inode_id].is_directory) {
+    if (!inode_is_used(inode_id) || S_ISDIR(g_fs.inode_table[inode_id].mode)) {
         return false;
     }
     
     Inode *inode = &g_fs.inode_table[inode_id];
     
+    // 内联数据不占用数据块，碎片文件的数据不超过所占槽位
+    if (file_is_inline(inode)) {
+        return inode->block_count == 0 && inode->size <= INODE_INLINE_SIZE;
+    }
+    if (file_is_fragment(inode)) {
+        int block_id = inode->data_blocks[FRAGMENT_BLOCK];
+        return inode->block_count == 0 && inode->size <= fragment_capacity(inode) &&
+               block_id > 0 && block_id < FS_TOTAL_BLOCKS && block_is_used(block_id);
+    }
+    
     // 检查数据块是否有效
-    for (int i = 0; i < inode->block_count && i < MAX_DIRECT_BLOCKS; i++) {
-        int block_id = inode->data_blocks[i];
-        if (block_id <= 0 || block_id >= MAX_BLOCKS || !block_is_used(block_id)) {
+    for (int i = 0; i < inode->block_count; i++) {
+        int block_id = block_get_for_inode(inode_id, i);
+        if (block_id <= 0 || block_id >= FS_TOTAL_BLOCKS || !block_is_used(block_id)) {
             return false;  // 无效的数据块
         }
     }
@@ -38,7 +38,7 @@ int file_delete(int inode_id);
  * @param offset 偏移量
  * @return 成功返回实际读取字节数，失败返回负数
  */
-int file_read(int inode_id, void *buffer, size_t size, off_t offset);
+ssize_t file_read(int inode_id, void *buffer, size_t size, off_t offset);
 
 /**
  * 写入文件内容
@@ -48,7 +48,7 @@ int file_read(int inode_id, void *buffer, size_t size, off_t offset);
  * @param offset 偏移量
  * @return 成功返回实际写入字节数，失败返回负数
  */
-int file_write(int inode_id, const void *buffer, size_t size, off_t offset);
+ssize_t file_write(int inode_id, const void *buffer, size_t size, off_t offset);
 
 /**
  * 截断文件
@@ -91,6 +91,12 @@ int file_move(int inode_id, int new_parent, const char *new_name);
  */
 off_t file_get_size(int inode_id);
 
+/**
+ * 获取单个文件允许的最大大小 (块索引为32位有符号整数)
+ * @return 最大字节数
+ */
+off_t file_max_size(void);
+
 /**
  * 设置文件大小
  * @param inode_id 文件inode编号
@@ -113,7 +119,7 @@ int file_exists(int parent_inode, const char *name);
  * @param size 文件大小
  * @return 成功返回0，失败返回负数
  */
-int file_alloc_blocks(int inode_id, size_t size);
+int file_alloc_blocks(int inode_id, uint64_t size);
 
 /**
  * 释放文件多余的数据块
@@ -121,7 +127,7 @@ int file_alloc_blocks(int inode_id, size_t size);
  * @param new_size 新文件大小
  * @return 成功返回0，失败返回负数
  */
-int file_free_excess_blocks(int inode_id, size_t new_size);
+int file_free_excess_blocks(int inode_id, uint64_t new_size);
 
 /**
  * 打印文件信息 (调试用)
@@ -0,0 +1,352 @@
+/*
+ * ============================================================================
+ * 文件名: src/fs/fragment.c
+ * 描述: 碎片分配模块实现
+ * 功能: 把多个小文件的数据打包存放在共享的碎片块中，按槽位分配和释放
+ * ============================================================================
+ */
+
+#include "fragment.h"
+#include "inode.h"
+#include "block.h"
+#include "group.h"
+#include <pthread.h>
+
+// ============================================================================
+// 碎片块表
+// ============================================================================
+#define FRAGMENT_SCAN_LIMIT 32          // 分配时最多检查的已有碎片块数，都放不下时分配新块
+
+/**
+ * 碎片块 - 一个被多个小文件共享的数据块
+ */
+typedef struct {
+    int block_id;                       // 数据块编号
+    int free_slots;                     // 空闲槽位数
+    uint64_t used[FRAGMENT_MAX_SLOTS / 64]; // 槽位占用位图
+} fragment_block_t;
+
+static struct {
+    pthread_mutex_t lock;               // 保护整个碎片块表
+    fragment_block_t *blocks;           // 按块编号排序的碎片块
+    int count;                          // 碎片块数
+    int capacity;                       // 数组容量
+    int cursor;                         // 下次分配首先尝试的碎片块
+} fragment_state = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+// ============================================================================
+// 内部辅助函数
+// ============================================================================
+
+/**
+ * 每个碎片块中的槽位数
+ */
+static int fragment_slots_per_block(void) {
+    return FS_BLOCK_SIZE / FRAGMENT_SLOT_SIZE;
+}
+
+/**
+ * 检查槽位是否已占用
+ */
+static bool fragment_slot_used(const fragment_block_t *fb, int slot) {
+    return (fb->used[slot / 64] >> (slot % 64)) & 1;
+}
+
+/**
+ * 标记或清除一段槽位
+ */
+static void fragment_mark(fragment_block_t *fb, int first, int count, bool used) {
+    for (int slot = first; slot < first + count; slot++) {
+        if (used) {
+            fb->used[slot / 64] |= 1ULL << (slot % 64);
+        } else {
+            fb->used[slot / 64] &= ~(1ULL << (slot % 64));
+        }
+    }
+    fb->free_slots += used ? -count : count;
+}
+
+/**
+ * 在碎片块中查找连续count个空闲槽位
+ * @return 起始槽位，没有返回-1
+ */
+static int fragment_find_run(const fragment_block_t *fb, int count) {
+    int run = 0;
+    for (int slot = 0; slot < fragment_slots_per_block(); slot++) {
+        run = fragment_slot_used(fb, slot) ? 0 : run + 1;
+        if (run == count) {
+            return slot - count + 1;
+        }
+    }
+    return -1;
+}
+
+/**
+ * 二分查找碎片块 (调用者持有锁)
+ * @param pos 输出找到的位置，未找到时为应插入的位置
+ * @return 找到返回true
+ */
+static bool fragment_search(int block_id, int *pos) {
+    int low = 0;
+    int high = fragment_state.count;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (fragment_state.blocks[mid].block_id < block_id) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    *pos = low;
+    return low < fragment_state.count && fragment_state.blocks[low].block_id == block_id;
+}
+
+/**
+ * 把数据块加入碎片块表，全部槽位为空闲 (调用者持有锁)
+ * @return 碎片块在表中的位置，失败返回-1
+ */
+static int fragment_insert(int block_id) {
+    if (fragment_state.count == fragment_state.capacity) {
+        int capacity = fragment_state.capacity ? fragment_state.capacity * 2 : 64;
+        fragment_block_t *blocks = realloc(fragment_state.blocks, capacity * sizeof(fragment_block_t));
+        if (!blocks) {
+            printf("错误: 无法分配碎片块表\n");
+            return -1;
+        }
+        fragment_state.blocks = blocks;
+        fragment_state.capacity = capacity;
+    }
+
+    int pos;
+    fragment_search(block_id, &pos);
+    memmove(&fragment_state.blocks[pos + 1], &fragment_state.blocks[pos],
+            (fragment_state.count - pos) * sizeof(fragment_block_t));
+    fragment_state.count++;
+    if (fragment_state.cursor >= pos && fragment_state.count > 1) {
+        fragment_state.cursor++;
+    }
+
+    fragment_block_t *fb = &fragment_state.blocks[pos];
+    memset(fb, 0, sizeof(*fb));
+    fb->block_id = block_id;
+    fb->free_slots = fragment_slots_per_block();
+    return pos;
+}
+
+/**
+ * 从碎片块表中移除一个碎片块 (调用者持有锁)
+ */
+static void fragment_remove(int pos) {
+    memmove(&fragment_state.blocks[pos], &fragment_state.blocks[pos + 1],
+            (fragment_state.count - pos - 1) * sizeof(fragment_block_t));
+    fragment_state.count--;
+    if (fragment_state.cursor > pos) {
+        fragment_state.cursor--;
+    }
+    if (fragment_state.cursor >= fragment_state.count) {
+        fragment_state.cursor = 0;
+    }
+}
+
+// ============================================================================
+// 碎片管理函数实现
+// ============================================================================
+
+/**
+ * 按inode表重建碎片块表
+ */
+int fragment_load(void) {
+    int slots_per_block = fragment_slots_per_block();
+    int files = 0;
+
+    pthread_mutex_lock(&fragment_state.lock);
+    for (int inode_id = 0; inode_id < FS_TOTAL_INODES; inode_id++) {
+        if (!inode_is_used(inode_id)) {
+            continue;
+        }
+        Inode *inode = &g_fs.inode_table[inode_id];
+        if (!(inode->flags & INODE_FLAG_FRAGMENT)) {
+            continue;
+        }
+
+        uint32_t block_id = inode->data_blocks[FRAGMENT_BLOCK];
+        uint32_t first = inode->data_blocks[FRAGMENT_FIRST_SLOT];
+        uint32_t count = inode->data_blocks[FRAGMENT_SLOT_COUNT];
+        if (block_id == 0 || block_id >= (uint32_t)FS_TOTAL_BLOCKS || !block_is_used(block_id) ||
+            count == 0 || first >= (uint32_t)slots_per_block || count > slots_per_block - first ||
+            inode->size > (uint64_t)count * FRAGMENT_SLOT_SIZE) {
+            printf("错误: inode %d 的碎片位置无效\n", inode_id);
+            goto fail;
+        }
+
+        int pos;
+        if (!fragment_search(block_id, &pos)) {
+            pos = fragment_insert(block_id);
+            if (pos == -1) {
+                goto fail;
+            }
+        }
+        fragment_block_t *fb = &fragment_state.blocks[pos];
+        for (uint32_t slot = first; slot < first + count; slot++) {
+            if (fragment_slot_used(fb, slot)) {
+                printf("错误: inode %d 的碎片与其他文件重叠 (数据块%u)\n", inode_id, block_id);
+                goto fail;
+            }
+        }
+        fragment_mark(fb, first, count, true);
+        files++;
+    }
+    fragment_state.cursor = 0;
+    pthread_mutex_unlock(&fragment_state.lock);
+
+    if (files > 0) {
+        printf("碎片块加载完成: %d个文件打包在%d个数据块中\n", files, fragment_state.count);
+    }
+    return 0;
+
+fail:
+    pthread_mutex_unlock(&fragment_state.lock);
+    fragment_cleanup();
+    return -1;
+}
+
+/**
+ * 可打包存放的最大文件大小
+ */
+size_t fragment_max_size(void) {
+    return FS_BLOCK_SIZE / 2;
+}
+
+/**
+ * 为inode分配碎片槽位
+ */
+int fragment_alloc(int inode_id, Inode *inode, size_t size) {
+    if (size == 0 || size > fragment_max_size()) {
+        return -1;
+    }
+
+    int count = (size + FRAGMENT_SLOT_SIZE - 1) / FRAGMENT_SLOT_SIZE;
+    int first = -1;
+    int pos = -1;
+
+    pthread_mutex_lock(&fragment_state.lock);
+
+    // 从上次分配或释放的碎片块开始，只检查有限个块，分配开销不随碎片块数增长
+    int scan = fragment_state.count < FRAGMENT_SCAN_LIMIT ? fragment_state.count : FRAGMENT_SCAN_LIMIT;
+    for (int n = 0; n < scan && first == -1; n++) {
+        pos = (fragment_state.cursor + n) % fragment_state.count;
+        if (fragment_state.blocks[pos].free_slots >= count) {
+            first = fragment_find_run(&fragment_state.blocks[pos], count);
+        }
+    }
+
+    // 已有的碎片块都放不下，分配新块 (与普通文件一样从inode所在的组开始)
+    if (first == -1) {
+        int block_id = block_alloc(group_of_inode(inode_id) * FS_BLOCKS_PER_GROUP);
+        if (block_id == -1) {
+            pthread_mutex_unlock(&fragment_state.lock);
+            return -1;
+        }
+        pos = fragment_insert(block_id);
+        if (pos == -1) {
+            pthread_mutex_unlock(&fragment_state.lock);
+            block_free(block_id);
+            return -1;
+        }
+        first = 0;
+    }
+
+    fragment_block_t *fb = &fragment_state.blocks[pos];
+    fragment_mark(fb, first, count, true);
+    fragment_state.cursor = pos;
+
+    memset(inode->data_blocks, 0, sizeof(inode->data_blocks));
+    inode->data_blocks[FRAGMENT_BLOCK] = fb->block_id;
+    inode->data_blocks[FRAGMENT_FIRST_SLOT] = first;
+    inode->data_blocks[FRAGMENT_SLOT_COUNT] = count;
+    inode->flags = (inode->flags & ~(INODE_FLAG_EXTENTS | INODE_FLAG_INLINE)) | INODE_FLAG_FRAGMENT;
+    inode->block_count = 0;
+
+    pthread_mutex_unlock(&fragment_state.lock);
+
+    g_fs.is_dirty = true;
+    return 0;
+}
+
+/**
+ * 释放inode占用的碎片槽位
+ */
+void fragment_release(const Inode *inode) {
+    int block_id = inode->data_blocks[FRAGMENT_BLOCK];
+    int first = inode->data_blocks[FRAGMENT_FIRST_SLOT];
+    int count = inode->data_blocks[FRAGMENT_SLOT_COUNT];
+
+    pthread_mutex_lock(&fragment_state.lock);
+    int pos;
+    if (!fragment_search(block_id, &pos) || count <= 0 || first < 0 ||
+        first + count > fragment_slots_per_block()) {
+        pthread_mutex_unlock(&fragment_state.lock);
+        printf("警告: 碎片 (数据块%d，槽位%d+%d) 不在碎片块表中\n", block_id, first, count);
+        return;
+    }
+
+    fragment_block_t *fb = &fragment_state.blocks[pos];
+    fragment_mark(fb, first, count, false);
+
+    // 最后一个文件移走后整块归还，否则下次分配先尝试这里刚空出的槽位
+    bool empty = fb->free_slots == fragment_slots_per_block();
+    if (empty) {
+        fragment_remove(pos);
+    } else {
+        fragment_state.cursor = pos;
+    }
+    pthread_mutex_unlock(&fragment_state.lock);
+
+    if (empty) {
+        block_free(block_id);
+    }
+}
+
+/**
+ * 获取碎片文件数据在磁盘中的偏移量
+ */
+off_t fragment_offset(const Inode *inode) {
+    return block_offset(inode->data_blocks[FRAGMENT_BLOCK]) +
+           (off_t)inode->data_blocks[FRAGMENT_FIRST_SLOT] * FRAGMENT_SLOT_SIZE;
+}
+
+/**
+ * 获取碎片文件占用的槽位总字节数
+ */
+size_t fragment_capacity(const Inode *inode) {
+    return (size_t)inode->data_blocks[FRAGMENT_SLOT_COUNT] * FRAGMENT_SLOT_SIZE;
+}
+
+/**
+ * 打印碎片块使用统计
+ */
+void fragment_print_usage(void) {
+    pthread_mutex_lock(&fragment_state.lock);
+    long used_slots = 0;
+    for (int i = 0; i < fragment_state.count; i++) {
+        used_slots += fragment_slots_per_block() - fragment_state.blocks[i].free_slots;
+    }
+    long total_slots = (long)fragment_state.count * fragment_slots_per_block();
+
+    printf("碎片块: %d个，槽位已用 %ld/%ld (每槽%d字节)\n",
+           fragment_state.count, used_slots, total_slots, FRAGMENT_SLOT_SIZE);
+    pthread_mutex_unlock(&fragment_state.lock);
+}
+
+/**
+ * 释放碎片块表
+ */
+void fragment_cleanup(void) {
+    pthread_mutex_lock(&fragment_state.lock);
+    free(fragment_state.blocks);
+    fragment_state.blocks = NULL;
+    fragment_state.count = 0;
+    fragment_state.capacity = 0;
+    fragment_state.cursor = 0;
+    pthread_mutex_unlock(&fragment_state.lock);
+}
@@ -0,0 +1,82 @@
+/*
+ * ============================================================================
+ * 文件名: src/fs/fragment.h
+ * 描述: 碎片分配模块头文件
+ * 功能: 把多个小文件的数据打包存放在共享的碎片块中，按槽位分配和释放
+ * ============================================================================
+ */
+
+#ifndef FRAGMENT_H
+#define FRAGMENT_H
+
+#include "../../include/ext2fs.h"
+
+// ============================================================================
+// 碎片常量
+// ============================================================================
+#define FRAGMENT_SLOT_SIZE 64           // 碎片块中的分配单位 (字节)
+#define FRAGMENT_MAX_SLOTS (MAX_BLOCK_SIZE / FRAGMENT_SLOT_SIZE) // 每块最多的槽位数
+
+// 碎片文件在data_blocks中的位置
+#define FRAGMENT_BLOCK 0                // 碎片块编号
+#define FRAGMENT_FIRST_SLOT 1           // 起始槽位
+#define FRAGMENT_SLOT_COUNT 2           // 占用的槽位数
+
+// ============================================================================
+// 碎片管理函数
+// ============================================================================
+
+/**
+ * 按inode表重建各碎片块的槽位占用情况 (挂载现有镜像时在inode表加载之后调用)
+ * 碎片块本身只是位图中已分配的普通数据块，槽位归属只记录在各inode中
+ * @return 成功返回0，槽位越界或重叠返回负数
+ */
+int fragment_load(void);
+
+/**
+ * 可打包存放的最大文件大小 (半个数据块，更大的文件单独占用数据块)
+ * @return 字节数
+ */
+size_t fragment_max_size(void);
+
+/**
+ * 为inode分配能容纳size字节的连续槽位，并把碎片位置记入inode (不写入数据)
+ * 优先使用最近分配过的碎片块，都放不下时分配一个新的碎片块
+ * @param inode_id inode编号 (新的碎片块从inode所在的组开始查找)
+ * @param inode 接收碎片位置的inode，原有的块映射或内联数据被覆盖
+ * @param size 需要的字节数 (不超过fragment_max_size())
+ * @return 成功返回0，失败返回负数
+ */
+int fragment_alloc(int inode_id, Inode *inode, size_t size);
+
+/**
+ * 释放inode占用的槽位，碎片块中已没有其他文件时释放整个块
+ * @param inode 碎片文件的inode (可以是inode表项的副本)，不修改
+ */
+void fragment_release(const Inode *inode);
+
+/**
+ * 获取碎片文件数据在磁盘中的偏移量
+ * @param inode 碎片文件的inode
+ * @return 偏移量
+ */
+off_t fragment_offset(const Inode *inode);
+
+/**
+ * 获取碎片文件占用的槽位总字节数 (不重新分配时可写入的最大大小)
+ * @param inode 碎片文件的inode
+ * @return 字节数
+ */
+size_t fragment_capacity(const Inode *inode);
+
+/**
+ * 打印碎片块使用统计
+ */
+void fragment_print_usage(void);
+
+/**
+ * 释放碎片块表 (不修改磁盘)
+ */
+void fragment_cleanup(void);
+
+#endif /* FRAGMENT_H */
@@ -0,0 +1,335 @@
+/*
+ * ============================================================================
+ * 文件名: src/fs/group.c
+ * 描述: 块组管理模块实现
+ * 功能: 块组描述符表的创建、加载、保存，以及按组加锁和选择分配起点
+ * ============================================================================
+ */
+
+#include "group.h"
+#include "../core/disk.h"
+#include "../core/bitmap.h"
+#include <pthread.h>
+
+// ============================================================================
+// 静态变量
+// ============================================================================
+static pthread_mutex_t *group_locks = NULL;    // 每组一把锁，保护该组的位图和空闲计数
+
+// ============================================================================
+// 内部辅助函数
+// ============================================================================
+
+/**
+ * 为每个块组创建锁 (包括为在线扩容预留的组)
+ */
+static int group_init_locks(void) {
+    group_locks = malloc(FS_GROUP_CAPACITY * sizeof(pthread_mutex_t));
+    if (!group_locks) {
+        printf("错误: 无法分配块组锁\n");
+        return -1;
+    }
+
+    for (int g = 0; g < FS_GROUP_CAPACITY; g++) {
+        pthread_mutex_init(&group_locks[g], NULL);
+    }
+    return 0;
+}
+
+/**
+ * 分配块组描述符表内存 (按预留的项数分配，扩容时表不移动)
+ */
+static int group_alloc_table(void) {
+    g_fs.groups = calloc(FS_GROUP_CAPACITY, sizeof(GroupDesc));
+    if (!g_fs.groups) {
+        printf("错误: 无法分配块组描述符表内存\n");
+        return -1;
+    }
+
+    if (group_init_locks() != 0) {
+        free(g_fs.groups);
+        g_fs.groups = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+// ============================================================================
+// 块组管理函数实现
+// ============================================================================
+
+/**
+ * 按布局版本对齐区域偏移
+ */
+off_t group_align(off_t offset) {
+    SuperBlock *sb = &g_fs.superblock;
+    if (sb->layout != EXT2FS_LAYOUT_ALIGNED) {
+        return offset;
+    }
+
+    off_t align = sb->block_size > EXT2FS_LAYOUT_ALIGN ? sb->block_size : EXT2FS_LAYOUT_ALIGN;
+    return (offset + align - 1) / align * align;
+}
+
+/**
+ * 按几何参数计算块组各区域的偏移
+ */
+void group_layout(int group, GroupDesc *gd) {
+    SuperBlock *sb = &g_fs.superblock;
+
+    // 描述符表 (含为扩容预留的项) 之后各组等长排列: 数据块位图 | inode位图 | inode表 | 数据块
+    // 对齐布局下每个区域都从对齐边界开始，数据块因此不会跨越主机页
+    off_t first = group_align(sb->group_desc_offset + (off_t)FS_GROUP_CAPACITY * sizeof(GroupDesc));
+    off_t block_bitmap_size = group_align(BITMAP_BYTES(sb->blocks_per_group));
+    off_t inode_bitmap_size = group_align(BITMAP_BYTES(sb->inodes_per_group));
+    off_t inode_table_size = group_align((off_t)sb->inodes_per_group * sizeof(Inode));
+    off_t stride = group_align(block_bitmap_size + inode_bitmap_size + inode_table_size +
+                               (off_t)sb->blocks_per_group * sb->block_size);
+    off_t start = first + (off_t)group * stride;
+
+    gd->block_bitmap_offset = start;
+    gd->inode_bitmap_offset = gd->block_bitmap_offset + block_bitmap_size;
+    gd->inode_table_offset = gd->inode_bitmap_offset + inode_bitmap_size;
+    gd->data_blocks_offset = gd->inode_table_offset + inode_table_size;
+}
+
+/**
+ * 获取块组中实际可用的数据块数
+ */
+int group_block_count(int group) {
+    if (group < FS_GROUP_COUNT - 1) {
+        return FS_BLOCKS_PER_GROUP;
+    }
+    return FS_TOTAL_BLOCKS - group * FS_BLOCKS_PER_GROUP;
+}
+
+/**
+ * 创建块组描述符表
+ */
+int group_init(void) {
+    if (group_alloc_table() != 0) {
+        return -1;
+    }
+
+    for (int g = 0; g < FS_GROUP_COUNT; g++) {
+        group_layout(g, &g_fs.groups[g]);
+    }
+
+    // 空闲计数以位图为准 (根目录等已在位图中标记)
+    group_update_stats();
+
+    printf("块组初始化完成: %d个组 (每组%d块、%d个inode)\n",
+           FS_GROUP_COUNT, FS_BLOCKS_PER_GROUP, FS_INODES_PER_GROUP);
+    return 0;
+}
+
+/**
+ * 从磁盘加载块组描述符表
+ */
+int group_load(void) {
+    SuperBlock *sb = &g_fs.superblock;
+
+    if (group_alloc_table() != 0) {
+        return -1;
+    }
+
+    if (disk_read(sb->group_desc_offset, g_fs.groups, FS_GROUP_COUNT * sizeof(GroupDesc)) < 0) {
+        printf("错误: 无法读取块组描述符表\n");
+        group_cleanup();
+        return -1;
+    }
+
+    // 各组区域的位置由几何参数唯一确定，不一致说明描述符表已损坏
+    for (int g = 0; g < FS_GROUP_COUNT; g++) {
+        GroupDesc expected;
+        group_layout(g, &expected);
+        GroupDesc *gd = &g_fs.groups[g];
+        if (gd->block_bitmap_offset != expected.block_bitmap_offset ||
+            gd->inode_bitmap_offset != expected.inode_bitmap_offset ||
+            gd->inode_table_offset != expected.inode_table_offset ||
+            gd->data_blocks_offset != expected.data_blocks_offset ||
+            gd->free_blocks > (uint32_t)group_block_count(g) ||
+            gd->free_inodes > sb->inodes_per_group) {
+            printf("错误: 块组%d的描述符无效\n", g);
+            group_cleanup();
+            return -1;
+        }
+    }
+
+    printf("块组描述符表加载完成 (%d个组)\n", FS_GROUP_COUNT);
+    return 0;
+}
+
+/**
+ * 保存块组描述符表到磁盘
+ */
+int group_save(void) {
+    if (!g_fs.groups) {
+        printf("错误: 块组描述符表未初始化\n");
+        return -1;
+    }
+
+    if (disk_write(g_fs.superblock.group_desc_offset, g_fs.groups,
+                   FS_GROUP_COUNT * sizeof(GroupDesc)) != 0) {
+        printf("错误: 无法写入块组描述符表\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * 按位图重新统计空闲计数
+ */
+void group_update_stats(void) {
+    SuperBlock *sb = &g_fs.superblock;
+    uint32_t free_blocks = 0;
+    uint32_t free_inodes = 0;
+
+    for (int g = 0; g < FS_GROUP_COUNT; g++) {
+        GroupDesc *gd = &g_fs.groups[g];
+
+        group_lock(g);
+        gd->free_blocks = bitmap_count_free_bits(g_fs.block_bitmap + g * (FS_BLOCKS_PER_GROUP / 8),
+                                                 group_block_count(g));
+        gd->free_inodes = bitmap_count_free_bits(g_fs.inode_bitmap + g * (FS_INODES_PER_GROUP / 8),
+                                                 FS_INODES_PER_GROUP);
+        free_blocks += gd->free_blocks;
+        free_inodes += gd->free_inodes;
+        group_unlock(g);
+    }
+
+    sb->free_blocks = free_blocks;
+    sb->free_inodes = free_inodes;
+    g_fs.is_dirty = true;
+}
+
+/**
+ * 在线扩容: 增加数据块 (和新组的inode)
+ */
+void group_grow(uint32_t total_blocks) {
+    SuperBlock *sb = &g_fs.superblock;
+    uint32_t old_blocks = sb->total_blocks;
+    int old_count = FS_GROUP_COUNT;
+    int new_count = (total_blocks + FS_BLOCKS_PER_GROUP - 1) / FS_BLOCKS_PER_GROUP;
+    int last = old_count - 1;
+
+    // 新组在发布组数之前不可见: 描述符按布局填好，位图和inode表在预留的内存中为全0，
+    // 只需标记新的最后一组中超出总块数的位
+    for (int g = old_count; g < new_count; g++) {
+        GroupDesc *gd = &g_fs.groups[g];
+        group_layout(g, gd);
+        gd->free_blocks = (g < new_count - 1) ? (uint32_t)FS_BLOCKS_PER_GROUP
+                                              : total_blocks - (uint32_t)g * FS_BLOCKS_PER_GROUP;
+        gd->free_inodes = FS_INODES_PER_GROUP;
+    }
+    if (new_count > old_count) {
+        for (uint32_t b = total_blocks; b < (uint32_t)new_count * FS_BLOCKS_PER_GROUP; b++) {
+            bitmap_set_bit(g_fs.block_bitmap, b);
+        }
+        bitmap_grow(old_count, new_count);
+    }
+
+    // 原最后一组补满: 清除原来超出总块数的位。持有该组的锁发布新的几何参数，
+    // 在该组分配的线程不会看到总块数和组数不一致的中间状态，其他组不受影响
+    uint32_t last_end = (uint32_t)old_count * FS_BLOCKS_PER_GROUP;
+    if (last_end > total_blocks) {
+        last_end = total_blocks;
+    }
+
+    group_lock(last);
+    for (uint32_t b = old_blocks; b < last_end; b++) {
+        bitmap_clear_bit(g_fs.block_bitmap, b);
+    }
+    g_fs.groups[last].free_blocks += last_end - old_blocks;
+    __atomic_store_n(&sb->total_blocks, total_blocks, __ATOMIC_RELEASE);
+    __atomic_store_n(&sb->total_inodes, (uint32_t)new_count * FS_INODES_PER_GROUP, __ATOMIC_RELEASE);
+    __atomic_store_n(&sb->group_count, (uint32_t)new_count, __ATOMIC_RELEASE);
+    group_unlock(last);
+
+    __atomic_fetch_add(&sb->free_blocks, total_blocks - old_blocks, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&sb->free_inodes, (uint32_t)(new_count - old_count) * FS_INODES_PER_GROUP,
+                       __ATOMIC_RELAXED);
+    g_fs.is_dirty = true;
+}
+
+/**
+ * 获取数据块所在的组
+ */
+int group_of_block(int block_id) {
+    return block_id / FS_BLOCKS_PER_GROUP;
+}
+
+/**
+ * 获取inode所在的组
+ */
+int group_of_inode(int inode_id) {
+    return inode_id / FS_INODES_PER_GROUP;
+}
+
+/**
+ * 锁定块组
+ */
+void group_lock(int group) {
+    pthread_mutex_lock(&group_locks[group]);
+}
+
+/**
+ * 解锁块组
+ */
+void group_unlock(int group) {
+    pthread_mutex_unlock(&group_locks[group]);
+}
+
+/**
+ * 为新目录选择块组
+ */
+int group_find_for_directory(void) {
+    uint32_t average = __atomic_load_n(&g_fs.superblock.free_inodes, __ATOMIC_RELAXED) /
+                       FS_GROUP_COUNT;
+
+    int best = 0;
+    uint32_t best_free_blocks = 0;
+    for (int g = 0; g < FS_GROUP_COUNT; g++) {
+        uint32_t free_inodes = __atomic_load_n(&g_fs.groups[g].free_inodes, __ATOMIC_RELAXED);
+        uint32_t free_blocks = __atomic_load_n(&g_fs.groups[g].free_blocks, __ATOMIC_RELAXED);
+        if (free_inodes > 0 && free_inodes >= average && free_blocks > best_free_blocks) {
+            best = g;
+            best_free_blocks = free_blocks;
+        }
+    }
+
+    return best;
+}
+
+/**
+ * 释放块组描述符表
+ */
+void group_cleanup(void) {
+    if (group_locks) {
+        for (int g = 0; g < FS_GROUP_CAPACITY; g++) {
+            pthread_mutex_destroy(&group_locks[g]);
+        }
+        free(group_locks);
+        group_locks = NULL;
+    }
+
+    free(g_fs.groups);
+    g_fs.groups = NULL;
+}
+
+/**
+ * 打印块组信息 (调试用)
+ */
+void group_print_info(void) {
+    printf("\n=== 块组信息 ===\n");
+    printf("块组数: %d (每组%d块、%d个inode，预留%d个组)\n",
+           FS_GROUP_COUNT, FS_BLOCKS_PER_GROUP, FS_INODES_PER_GROUP, FS_GROUP_CAPACITY);
+    for (int g = 0; g < FS_GROUP_COUNT; g++) {
+        GroupDesc *gd = &g_fs.groups[g];
+        printf("组%d: 数据块偏移 %lu, 空闲块 %u/%d, 空闲inode %u/%d\n",
+               g, gd->data_blocks_offset, gd->free_blocks, group_block_count(g),
+               gd->free_inodes, FS_INODES_PER_GROUP);
+    }
+    printf("================\n\n");
+}
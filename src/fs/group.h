@@ -0,0 +1,113 @@
+/*
+ * ============================================================================
+ * 文件名: src/fs/group.h
+ * 描述: 块组管理模块头文件
+ * 功能: 块组描述符表的创建、加载、保存，以及按组加锁和选择分配起点
+ * ============================================================================
+ */
+
+#ifndef GROUP_H
+#define GROUP_H
+
+#include "../../include/ext2fs.h"
+
+// ============================================================================
+// 块组管理函数
+// ============================================================================
+
+/**
+ * 按超级块中的布局版本对齐区域偏移
+ * 对齐布局按块大小与4 KiB中较大者向上对齐，紧密布局原样返回
+ * @param offset 偏移或区域大小
+ * @return 对齐后的值
+ */
+off_t group_align(off_t offset);
+
+/**
+ * 按超级块中的几何参数计算块组各区域的偏移 (不含空闲计数)
+ * @param group 组号
+ * @param gd 输出描述符
+ */
+void group_layout(int group, GroupDesc *gd);
+
+/**
+ * 获取块组中实际可用的数据块数 (最后一组可能不满)
+ * @param group 组号
+ * @return 数据块数
+ */
+int group_block_count(int group);
+
+/**
+ * 创建块组描述符表 (格式化时使用，须在位图和inode表初始化之后调用)
+ * @return 成功返回0，失败返回负数
+ */
+int group_init(void);
+
+/**
+ * 从磁盘加载块组描述符表并检查各组区域的偏移
+ * @return 成功返回0，失败返回负数
+ */
+int group_load(void);
+
+/**
+ * 保存块组描述符表到磁盘
+ * @return 成功返回0，失败返回负数
+ */
+int group_save(void);
+
+/**
+ * 按位图重新统计各组和超级块的空闲计数
+ */
+void group_update_stats(void);
+
+/**
+ * 在线扩容: 把总块数增加到total_blocks，补满最后一组并按需追加新组 (每个新组带来一组inode)
+ * 调用者须已检查新的组数不超过预留的项数、镜像已扩大到新的大小，且不与其他扩容并发
+ * @param total_blocks 新的总块数 (大于当前总块数)
+ */
+void group_grow(uint32_t total_blocks);
+
+/**
+ * 获取数据块所在的组
+ * @param block_id 数据块编号
+ * @return 组号
+ */
+int group_of_block(int block_id);
+
+/**
+ * 获取inode所在的组
+ * @param inode_id inode编号
+ * @return 组号
+ */
+int group_of_inode(int inode_id);
+
+/**
+ * 锁定块组 (修改该组的位图和空闲计数前调用，不同组可以并行分配)
+ * @param group 组号
+ */
+void group_lock(int group);
+
+/**
+ * 解锁块组
+ * @param group 组号
+ */
+void group_unlock(int group);
+
+/**
+ * 为新目录选择块组: 在空闲inode不少于平均值的组中选空闲块最多的，
+ * 使目录分散到各组，而目录下的文件随后分配在目录所在的组
+ * @return 组号
+ */
+int group_find_for_directory(void);
+
+/**
+ * 释放块组描述符表
+ */
+void group_cleanup(void);
+
+/**
+ * 打印块组信息 (调试用)
+ */
+void group_print_info(void);
+
+#endif /* GROUP_H */
@@ -7,8 +7,40 @@
  */
 
 #include "inode.h"
+#include "group.h"
+#include "block.h"
+#include "fragment.h"
 #include "../core/disk.h"
 #include "../core/bitmap.h"
+#include "../core/bufpool.h"
+
+// ============================================================================
+// 内部辅助函数
+// ============================================================================
+
+/**
+ * 生成读写各组inode表的请求 (每组一个)
+ */
+static disk_io_t *inode_group_ios(void) {
+    disk_io_t *ios = malloc(FS_GROUP_COUNT * sizeof(disk_io_t));
+    if (!ios) {
+        return NULL;
+    }
+
+    for (int g = 0; g < FS_GROUP_COUNT; g++) {
+        ios[g].offset = g_fs.groups[g].inode_table_offset;
+        ios[g].buffer = &g_fs.inode_table[g * FS_INODES_PER_GROUP];
+        ios[g].size = FS_INODES_PER_GROUP * sizeof(Inode);
+    }
+    return ios;
+}
+
+/**
+ * inode表预留的字节数 (在线扩容时新组的inode表接在后面，已有inode不移动)
+ */
+static size_t inode_table_capacity(void) {
+    return (size_t)FS_GROUP_CAPACITY * FS_INODES_PER_GROUP * sizeof(Inode);
+}
 
 // ============================================================================
 // inode管理函数实现
@@ -18,8 +50,8 @@
  * 初始化inode表
  */
 int inode_init(void) {
-    // 分配inode表内存
-    g_fs.inode_table = calloc(MAX_INODES, sizeof(Inode));
+    // 分配inode表内存 (页对齐，O_DIRECT下可直接读写)
+    g_fs.inode_table = bufpool_reserve(inode_table_capacity());
     if (!g_fs.inode_table) {
         printf("错误: 无法分配inode表内存\n");
         return -1;
@@ -28,8 +60,10 @@ int inode_init(void) {
     // 创建根目录inode
     Inode *root = &g_fs.inode_table[ROOT_INODE];
     strcpy(root->name, "/");
-    root->owner_id = 0;
-    strcpy(root->permissions, "rwx");
+    root->mode = S_IFDIR | 0755;
+    root->version = INODE_VERSION;
+    root->uid = 0;
+    root->gid = 0;
     root->size = 0;
     root->data_blocks[0] = 0;  // 根目录使用第0个数据块
     root->block_count = 1;
@@ -38,7 +72,6 @@ int inode_init(void) {
     root->created = now;
     root->modified = now;
     root->accessed = now;
-    root->is_directory = 1;
     root->parent_inode = ROOT_INODE;  // 根目录的父目录是自己
     root->link_count = 1;
     
@@ -50,20 +83,33 @@ int inode_init(void) {
  * 加载inode表从磁盘
  */
 int inode_load(void) {
-    SuperBlock *sb = &g_fs.superblock;
-    
     // 分配内存
-    g_fs.inode_table = malloc(MAX_INODES * sizeof(Inode));
+    g_fs.inode_table = bufpool_reserve(inode_table_capacity());
     if (!g_fs.inode_table) {
         printf("错误: 无法分配inode表内存\n");
         return -1;
     }
     
-    // 从磁盘读取inode表
-    if (disk_read(sb->inode_table_offset, g_fs.inode_table, 
-                  MAX_INODES * sizeof(Inode)) < 0) {
+    // 一次读取所有组的inode表
+    disk_io_t *ios = inode_group_ios();
+    if (!ios || disk_readv(ios, FS_GROUP_COUNT) != 0) {
         printf("错误: 无法读取inode表\n");
-        free(g_fs.inode_table);
+        free(ios);
+        inode_cleanup();
+        return -1;
+    }
+    free(ios);
+    
+    // 根目录inode记录了格式版本，旧格式的inode表字段布局不同，无法直接使用
+    uint8_t version = g_fs.inode_table[ROOT_INODE].version;
+    if (version != INODE_VERSION) {
+        if (version > 0 && version < INODE_VERSION) {
+            printf("错误: inode格式版本 %u 低于当前版本 %d，请用ext2fs-upgrade离线升级镜像\n",
+                   version, INODE_VERSION);
+        } else {
+            printf("错误: inode格式版本 %u 不受支持 (当前版本 %d)\n", version, INODE_VERSION);
+        }
+        inode_cleanup();
         return -1;
     }
     
@@ -75,62 +121,103 @@ int inode_load(void) {
  * 保存inode表到磁盘
  */
 int inode_save(void) {
-    SuperBlock *sb = &g_fs.superblock;
-    
     if (!g_fs.inode_table) {
         printf("错误: inode表未初始化\n");
         return -1;
     }
     
-    // 写入磁盘
-    if (disk_write(sb->inode_table_offset, g_fs.inode_table, 
-                   MAX_INODES * sizeof(Inode)) < 0) {
+    // 一次写入所有组的inode表
+    disk_io_t *ios = inode_group_ios();
+    if (!ios || disk_writev(ios, FS_GROUP_COUNT) != 0) {
         printf("错误: 无法写入inode表\n");
+        free(ios);
         return -1;
     }
+    free(ios);
     
     return 0;
 }
 
+/**
+ * 释放inode表内存
+ */
+void inode_cleanup(void) {
+    bufpool_release(g_fs.inode_table, inode_table_capacity());
+    g_fs.inode_table = NULL;
+}
+
 /**
  * 分配一个空闲inode
  */
-int inode_alloc(void) {
-    int inode_id = bitmap_find_free_bit(g_fs.inode_bitmap, MAX_INODES);
-    if (inode_id == -1) {
-        printf("错误: 没有空闲inode\n");
-        return -1;
+int inode_alloc(int parent_inode, bool is_directory) {
+    // 目录分散到各组，文件优先放在父目录所在的组
+    int start = 0;
+    if (is_directory) {
+        start = group_find_for_directory();
+    } else if (parent_inode >= 0 && parent_inode < FS_TOTAL_INODES) {
+        start = group_of_inode(parent_inode);
     }
     
-    // 标记为已使用
-    bitmap_set_bit(g_fs.inode_bitmap, inode_id);
-    
-    // 清空inode内容
-    memset(&g_fs.inode_table[inode_id], 0, sizeof(Inode));
-    
-    // 更新超级块统计
-    g_fs.superblock.free_inodes--;
-    g_fs.is_dirty = true;
+    for (int n = 0; n < FS_GROUP_COUNT; n++) {
+        int g = (start + n) % FS_GROUP_COUNT;
+        GroupDesc *gd = &g_fs.groups[g];
+        if (__atomic_load_n(&gd->free_inodes, __ATOMIC_RELAXED) == 0) {
+            continue;
+        }
+        
+        // 只在本组的位图范围内查找
+        group_lock(g);
+        int first = g * FS_INODES_PER_GROUP;
+        int index = bitmap_find_free_bit(g_fs.inode_bitmap + first / 8, FS_INODES_PER_GROUP);
+        if (index == -1) {
+            group_unlock(g);
+            continue;
+        }
+        
+        // 标记为已使用
+        bitmap_set_bit(g_fs.inode_bitmap, first + index);
+        gd->free_inodes--;
+        group_unlock(g);
+        
+        // 清空inode内容
+        int inode_id = first + index;
+        memset(&g_fs.inode_table[inode_id], 0, sizeof(Inode));
+        
+        // 更新超级块统计
+        __atomic_fetch_sub(&g_fs.superblock.free_inodes, 1, __ATOMIC_RELAXED);
+        g_fs.is_dirty = true;
+        
+        return inode_id;
+    }
     
-    return inode_id;
+    printf("错误: 没有空闲inode\n");
+    return -1;
 }
 
 /**
  * 释放一个inode
  */
 void inode_free(int inode_id) {
-    if (inode_id < 0 || inode_id >= MAX_INODES) {
+    if (inode_id < 0 || inode_id >= FS_TOTAL_INODES) {
         return;
     }
     
     // 清除位图标记
+    int g = group_of_inode(inode_id);
+    group_lock(g);
+    if (!bitmap_test_bit(g_fs.inode_bitmap, inode_id)) {
+        group_unlock(g);
+        return;
+    }
     bitmap_clear_bit(g_fs.inode_bitmap, inode_id);
+    g_fs.groups[g].free_inodes++;
+    group_unlock(g);
     
     // 清空inode内容
     memset(&g_fs.inode_table[inode_id], 0, sizeof(Inode));
     
     // 更新超级块统计
-    g_fs.superblock.free_inodes++;
+    __atomic_fetch_add(&g_fs.superblock.free_inodes, 1, __ATOMIC_RELAXED);
     g_fs.is_dirty = true;
 }
 
@@ -138,7 +225,7 @@ void inode_free(int inode_id) {
  * 读取inode信息
  */
 int inode_read(int inode_id, Inode *inode) {
-    if (inode_id < 0 || inode_id >= MAX_INODES || !inode) {
+    if (inode_id < 0 || inode_id >= FS_TOTAL_INODES || !inode) {
         return -1;
     }
     
@@ -154,7 +241,7 @@ int inode_read(int inode_id, Inode *inode) {
  * 写入inode信息
  */
 int inode_write(int inode_id, const Inode *inode) {
-    if (inode_id < 0 || inode_id >= MAX_INODES || !inode) {
+    if (inode_id < 0 || inode_id >= FS_TOTAL_INODES || !inode) {
         return -1;
     }
     
@@ -168,7 +255,7 @@ int inode_write(int inode_id, const Inode *inode) {
  * 检查inode是否被使用
  */
 bool inode_is_used(int inode_id) {
-    if (inode_id < 0 || inode_id >= MAX_INODES) {
+    if (inode_id < 0 || inode_id >= FS_TOTAL_INODES) {
         return false;
     }
     
@@ -184,7 +271,7 @@ int inode_create(const char *name, bool is_directory, int parent_inode) {
     }
     
     // 分配新inode
-    int inode_id = inode_alloc();
+    int inode_id = inode_alloc(parent_inode, is_directory);
     if (inode_id == -1) {
         return -1;
     }
@@ -192,8 +279,11 @@ int inode_create(const char *name, bool is_directory, int parent_inode) {
     // 初始化inode
     Inode *inode = &g_fs.inode_table[inode_id];
     strcpy(inode->name, name);
-    inode->owner_id = 0;  // 默认root用户
-    strcpy(inode->permissions, "rwx");
+    inode->mode = is_directory ? (S_IFDIR | 0755) : (S_IFREG | 0644);
+    inode->version = INODE_VERSION;
+    inode->flags = 0;
+    inode->uid = 0;  // 默认root用户
+    inode->gid = 0;
     inode->size = 0;
     inode->block_count = 0;
     
@@ -201,13 +291,16 @@ int inode_create(const char *name, bool is_directory, int parent_inode) {
     inode->created = now;
     inode->modified = now;
     inode->accessed = now;
-    inode->is_directory = is_directory ? 1 : 0;
     inode->parent_inode = parent_inode;
     inode->link_count = 1;
     
-    // 清空数据块索引
-    for (int i = 0; i < MAX_DIRECT_BLOCKS; i++) {
-        inode->data_blocks[i] = 0;
+    // 新建目录使用extent映射 (根目录沿用块指针)；新建文件的数据先内联在inode中，
+    // 超过INODE_INLINE_SIZE字节时由文件层转为extent映射
+    if (is_directory) {
+        block_map_init(inode, true);
+    } else {
+        memset(inode->data_blocks, 0, sizeof(inode->data_blocks));
+        inode->flags = INODE_FLAG_INLINE;
     }
     
     g_fs.is_dirty = true;
@@ -248,30 +341,17 @@ int inode_get_stat(int inode_id, struct stat *stbuf) {
     
     memset(stbuf, 0, sizeof(struct stat));
     
-    // 设置文件类型和权限
-    if (inode->is_directory) {
-        stbuf->st_mode = S_IFDIR | 0755;
-    } else {
-        stbuf->st_mode = S_IFREG | 0644;
-    }
-    
-    // 根据权限字符串设置权限位
-    if (strchr(inode->permissions, 'r')) {
-        stbuf->st_mode |= S_IRUSR | S_IRGRP | S_IROTH;
-    }
-    if (strchr(inode->permissions, 'w')) {
-        stbuf->st_mode |= S_IWUSR | S_IWGRP | S_IWOTH;
-    }
-    if (strchr(inode->permissions, 'x')) {
-        stbuf->st_mode |= S_IXUSR | S_IXGRP | S_IXOTH;
-    }
-    
+    // 文件类型和权限位直接取自inode
+    stbuf->st_mode = inode->mode;
     stbuf->st_nlink = inode->link_count;
-    stbuf->st_uid = inode->owner_id;
-    stbuf->st_gid = 0;
-    stbuf->st_size = inode->size;
-    stbuf->st_blocks = inode->block_count;
-    stbuf->st_blksize = BLOCK_SIZE;
+    stbuf->st_uid = inode->uid;
+    stbuf->st_gid = inode->gid;
+    stbuf->st_size = (off_t)inode->size;
+    stbuf->st_blocks = (blkcnt_t)inode->block_count * (FS_BLOCK_SIZE / 512);  // 以512字节为单位
+    if (inode->flags & INODE_FLAG_FRAGMENT) {
+        stbuf->st_blocks = (fragment_capacity(inode) + 511) / 512;  // 碎片文件按所占槽位计算
+    }
+    stbuf->st_blksize = FS_BLOCK_SIZE;
     
     stbuf->st_atime = inode->accessed;
     stbuf->st_mtime = inode->modified;
@@ -281,16 +361,37 @@ int inode_get_stat(int inode_id, struct stat *stbuf) {
 }
 
 /**
- * 修改inode权限
+ * 修改inode权限位
+ */
+int inode_set_mode(int inode_id, mode_t mode) {
+    if (!inode_is_used(inode_id)) {
+        return -1;
+    }
+    
+    // 文件类型在创建时确定，这里只替换权限位
+    Inode *inode = &g_fs.inode_table[inode_id];
+    inode->mode = (inode->mode & S_IFMT) | (mode & 07777);
+    
+    inode_update_times(inode_id, false, true);
+    return 0;
+}
+
+/**
+ * 修改inode所有者
  */
-int inode_set_permissions(int inode_id, const char *permissions) {
-    if (!inode_is_used(inode_id) || !permissions) {
+int inode_set_owner(int inode_id, uid_t uid, gid_t gid) {
+    if (!inode_is_used(inode_id)) {
         return -1;
     }
     
+    // (uid_t)-1 / (gid_t)-1 表示保持不变 (与chown(2)一致)
     Inode *inode = &g_fs.inode_table[inode_id];
-    strncpy(inode->permissions, permissions, sizeof(inode->permissions) - 1);
-    inode->permissions[sizeof(inode->permissions) - 1] = '\0';
+    if (uid != (uid_t)-1) {
+        inode->uid = uid;
+    }
+    if (gid != (gid_t)-1) {
+        inode->gid = gid;
+    }
     
     inode_update_times(inode_id, false, true);
     return 0;
@@ -324,34 +425,34 @@ void inode_print_info(int inode_id) {
     
     printf("\n=== inode %d 信息 ===\n", inode_id);
     printf("名称: %s\n", inode->name);
-    printf("类型: %s\n", inode->is_directory ? "目录" : "文件");
-    printf("所有者: %u\n", inode->owner_id);
-    printf("权限: %s\n", inode->permissions);
-    printf("大小: %u 字节\n", inode->size);
+    printf("类型: %s\n", S_ISDIR(inode->mode) ? "目录" : "文件");
+    printf("所有者: %u:%u\n", inode->uid, inode->gid);
+    printf("权限: %04o\n", inode->mode & 07777);
+    printf("大小: %lu 字节\n", inode->size);
     printf("数据块数: %u\n", inode->block_count);
     printf("硬链接数: %u\n", inode->link_count);
     printf("父目录: %u\n", inode->parent_inode);
-    printf("创建时间: %s", ctime(&inode->created));
-    printf("修改时间: %s", ctime(&inode->modified));
-    printf("访问时间: %s", ctime(&inode->accessed));
-    printf("数据块: ");
-    for (int i = 0; i < inode->block_count && i < MAX_DIRECT_BLOCKS; i++) {
-        printf("%u ", inode->data_blocks[i]);
-    }
-    printf("\n==================\n\n");
+    time_t created = inode->created;
+    time_t modified = inode->modified;
+    time_t accessed = inode->accessed;
+    printf("创建时间: %s", ctime(&created));
+    printf("修改时间: %s", ctime(&modified));
+    printf("访问时间: %s", ctime(&accessed));
+    block_print_map(inode_id);
+    printf("==================\n\n");
 }
 
 /**
  * 统计inode使用情况
  */
 void inode_print_usage(void) {
-    int used = bitmap_count_used_bits(g_fs.inode_bitmap, MAX_INODES);
-    int free = MAX_INODES - used;
+    int used = bitmap_count_used_bits(g_fs.inode_bitmap, FS_TOTAL_INODES);
+    int free = FS_TOTAL_INODES - used;
     
     printf("\n=== inode使用统计 ===\n");
-    printf("总inode数: %d\n", MAX_INODES);
+    printf("总inode数: %d\n", FS_TOTAL_INODES);
     printf("已使用: %d\n", used);
     printf("空闲: %d\n", free);
-    printf("使用率: %.1f%%\n", (float)used / MAX_INODES * 100);
+    printf("使用率: %.1f%%\n", (float)used / FS_TOTAL_INODES * 100);
     printf("==================\n\n");
 }
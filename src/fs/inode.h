@@ -33,11 +33,20 @@ int inode_load(void);
  */
 int inode_save(void);
 
+/**
+ * 释放inode表内存
+ */
+void inode_cleanup(void);
+
 /**
  * 分配一个空闲inode
+ * 文件优先分配在父目录所在的块组，目录分散到空闲inode较多的组；
+ * 首选组已满时依次尝试后面的组
+ * @param parent_inode 父目录inode编号 (无父目录时传INVALID_INODE)
+ * @param is_directory 是否为目录
  * @return 成功返回inode编号，失败返回负数
  */
-int inode_alloc(void);
+int inode_alloc(int parent_inode, bool is_directory);
 
 /**
  * 释放一个inode
@@ -95,12 +104,21 @@ int inode_update_times(int inode_id, bool access, bool modify);
 int inode_get_stat(int inode_id, struct stat *stbuf);
 
 /**
- * 修改inode权限
+ * 修改inode权限位 (文件类型保持不变)
+ * @param inode_id inode编号
+ * @param mode 新权限位 (只取07777部分)
+ * @return 成功返回0，失败返回负数
+ */
+int inode_set_mode(int inode_id, mode_t mode);
+
+/**
+ * 修改inode所有者
  * @param inode_id inode编号
- * @param permissions 新权限字符串
+ * @param uid 新用户ID，(uid_t)-1表示不变
+ * @param gid 新组ID，(gid_t)-1表示不变
  * @return 成功返回0，失败返回负数
  */
-int inode_set_permissions(int inode_id, const char *permissions);
+int inode_set_owner(int inode_id, uid_t uid, gid_t gid);
 
 /**
  * 重命名inode
@@ -8,33 +8,126 @@
 
 #include "superblock.h"
 #include "../core/disk.h"
+#include "../core/bitmap.h"
+#include "inode.h"
+#include "block.h"
+#include "group.h"
+#include <pthread.h>
 
 // ============================================================================
 // 超级块管理函数实现
 // ============================================================================
 
+/**
+ * 设置文件系统几何参数 (格式化前使用)
+ */
+int superblock_set_geometry(uint32_t blocks, uint32_t inodes, uint32_t block_size) {
+    SuperBlock *sb = &g_fs.superblock;
+
+    if (block_size < MIN_BLOCK_SIZE || block_size > MAX_BLOCK_SIZE ||
+        (block_size & (block_size - 1)) != 0) {
+        printf("错误: 块大小必须是%d到%d之间的2的幂 (当前: %u)\n",
+               MIN_BLOCK_SIZE, MAX_BLOCK_SIZE, block_size);
+        return -1;
+    }
+
+    // 块0保留给用户信息，inode 0为根目录；编号以int传递
+    if (blocks < 2 || blocks > INT32_MAX || inodes < 2 || inodes > INT32_MAX) {
+        printf("错误: 数据块数和inode数必须在2到%d之间 (当前: %u, %u)\n",
+               INT32_MAX, blocks, inodes);
+        return -1;
+    }
+
+    // 每组的数据块位图占一个块 (与ext2相同)；镜像不足一组时只用一个组
+    uint32_t blocks_per_group = block_size * 8;
+    if (blocks < blocks_per_group) {
+        blocks_per_group = (blocks + 7) / 8 * 8;
+    }
+    uint32_t group_count = (blocks + blocks_per_group - 1) / blocks_per_group;
+
+    // inode平均分到各组，每组数量向上取整到8的倍数，使各组位图按字节对齐
+    uint64_t inodes_per_group = ((uint64_t)inodes + group_count - 1) / group_count;
+    inodes_per_group = (inodes_per_group + 7) / 8 * 8;
+    if (inodes_per_group * group_count > INT32_MAX) {
+        printf("错误: inode数过多 (%u)\n", inodes);
+        return -1;
+    }
+
+    sb->total_blocks = blocks;
+    sb->total_inodes = (uint32_t)(inodes_per_group * group_count);
+    sb->block_size = block_size;
+    sb->inode_size = INODE_SIZE;
+    sb->blocks_per_group = blocks_per_group;
+    sb->inodes_per_group = (uint32_t)inodes_per_group;
+    sb->group_count = group_count;
+    sb->reserved_groups = 0;
+
+    superblock_set_current_format();
+    return 0;
+}
+
+/**
+ * 设为当前版本的格式
+ */
+void superblock_set_current_format(void) {
+    SuperBlock *sb = &g_fs.superblock;
+
+    // 块组描述符表按RESIZE_MAX_GROWTH倍的组数预留，在线扩容追加新组时已有各组的位置不变
+    // (组数上限还受块编号和inode编号须能用int表示的限制)
+    uint64_t reserved_groups = (uint64_t)sb->group_count * RESIZE_MAX_GROWTH;
+    if (reserved_groups > INT32_MAX / sb->blocks_per_group) {
+        reserved_groups = INT32_MAX / sb->blocks_per_group;
+    }
+    if (reserved_groups > INT32_MAX / sb->inodes_per_group) {
+        reserved_groups = INT32_MAX / sb->inodes_per_group;
+    }
+    if (reserved_groups < sb->group_count) {
+        reserved_groups = sb->group_count;
+    }
+    if (reserved_groups > sb->reserved_groups) {
+        sb->reserved_groups = (uint32_t)reserved_groups;
+    }
+
+    // 对齐布局: 块组描述符表从超级块之后的第一个对齐边界开始，各组区域的位置由group_layout计算
+    sb->layout = EXT2FS_LAYOUT_ALIGNED;
+    sb->group_desc_offset = group_align(sizeof(SuperBlock));
+
+    sb->format_version = EXT2FS_FORMAT_VERSION;
+    sb->feature_compat = 0;
+    sb->feature_incompat = EXT2FS_FEATURE_INCOMPAT_SUPP;
+    sb->feature_ro_compat = 0;
+}
+
+/**
+ * 计算当前几何参数下的镜像大小
+ */
+off_t superblock_image_size(void) {
+    SuperBlock *sb = &g_fs.superblock;
+    int last = sb->group_count - 1;
+
+    GroupDesc gd;
+    group_layout(last, &gd);
+    return (off_t)gd.data_blocks_offset + (off_t)group_block_count(last) * sb->block_size;
+}
+
 /**
  * 初始化超级块 (格式化时使用)
  */
 int superblock_init(void) {
     SuperBlock *sb = &g_fs.superblock;
     
+    // 未设置几何参数时使用默认值
+    if (sb->total_blocks == 0 &&
+        superblock_set_geometry(DEFAULT_BLOCKS, DEFAULT_INODES, DEFAULT_BLOCK_SIZE) != 0) {
+        return -1;
+    }
+
     // 设置魔数
     sb->magic = EXT2FS_MAGIC;
     
-    // 设置基本参数
-    sb->total_blocks = MAX_BLOCKS;
-    sb->free_blocks = MAX_BLOCKS - 1;       // 减1是因为根目录占用一个块
-    sb->total_inodes = MAX_INODES;
-    sb->free_inodes = MAX_INODES - 1;       // 减1是因为根目录占用一个inode
-    sb->block_size = BLOCK_SIZE;
-    sb->inode_size = INODE_SIZE;
-    
-    // 计算各区域在磁盘中的偏移量
-    sb->inode_bitmap_offset = sizeof(SuperBlock);
-    sb->block_bitmap_offset = sb->inode_bitmap_offset + (MAX_INODES / 8);
-    sb->inode_table_offset = sb->block_bitmap_offset + (MAX_BLOCKS / 8);
-    sb->data_blocks_offset = sb->inode_table_offset + (MAX_INODES * sizeof(Inode));
+    // 设置空闲计数
+    sb->free_blocks = sb->total_blocks - 1;     // 减1是因为根目录占用一个块
+    sb->free_inodes = sb->total_inodes - 1;     // 减1是因为根目录占用一个inode
     
     // 设置时间戳
     time_t now = time(NULL);
@@ -57,18 +150,65 @@ int superblock_load(void) {
     SuperBlock *sb = &g_fs.superblock;
     
     // 从磁盘读取超级块
-    if (disk_read(SUPERBLOCK_OFFSET, sb, sizeof(SuperBlock)) != 0) {
+    if (disk_read(SUPERBLOCK_OFFSET, sb, sizeof(SuperBlock)) < 0) {
         printf("错误: 无法从磁盘读取超级块\n");
         return -1;
     }
     
     // 验证魔数
+    if (sb->magic == EXT2FS_MAGIC_UPGRADING) {
+        printf("错误: 镜像的离线升级没有完成，各区域可能只移动了一部分，请从备份恢复后重新升级\n");
+        return -1;
+    }
     if (sb->magic != EXT2FS_MAGIC) {
         printf("错误: 无效的文件系统魔数 (期望: 0x%X, 实际: 0x%X)\n", 
                EXT2FS_MAGIC, sb->magic);
         return -1;
     }
+
+    // 64字节inode的旧版镜像: 超级块布局不同，后面的字段都不可信
+    if (sb->inode_size != INODE_SIZE) {
+        printf("错误: inode大小为%u字节的旧版镜像 (不分块组的可用ext2fs-upgrade转换，"
+               "分块组的紧密布局镜像需要重新格式化)\n", sb->inode_size);
+        return -1;
+    }
+
+    // 检查格式版本和功能标志
+    if (sb->format_version > EXT2FS_FORMAT_VERSION) {
+        printf("错误: 镜像格式版本 %u 高于本程序支持的版本 %d\n",
+               sb->format_version, EXT2FS_FORMAT_VERSION);
+        return -1;
+    }
+    if (sb->feature_incompat & ~EXT2FS_FEATURE_INCOMPAT_SUPP) {
+        printf("错误: 镜像使用了不支持的不兼容功能 (0x%X)，不能挂载\n",
+               sb->feature_incompat & ~EXT2FS_FEATURE_INCOMPAT_SUPP);
+        return -1;
+    }
+    if (sb->feature_ro_compat & ~EXT2FS_FEATURE_RO_COMPAT_SUPP) {
+        printf("错误: 镜像使用了不支持的只读兼容功能 (0x%X)，不支持只读挂载\n",
+               sb->feature_ro_compat & ~EXT2FS_FEATURE_RO_COMPAT_SUPP);
+        return -1;
+    }
     
+    // 检查几何参数，并确认镜像容纳得下超级块描述的所有区域
+    if (!superblock_is_valid()) {
+        printf("错误: 超级块中的几何参数无效\n");
+        return -1;
+    }
+
+    if (superblock_image_size() > disk_get_size()) {
+        printf("错误: 镜像小于超级块描述的大小 (需要: %ld 字节, 实际: %ld 字节)\n",
+               superblock_image_size(), disk_get_size());
+        return -1;
+    }
+
+    // 版本0镜像的各区域与当前版本相同，就地写入格式版本和功能标志 (加载完成后由fuse_init提交)
+    if (sb->format_version == 0) {
+        sb->format_version = EXT2FS_FORMAT_VERSION;
+        sb->feature_incompat = EXT2FS_FEATURE_INCOMPAT_SUPP;
+        g_fs.is_dirty = true;
+    }
+
     // 更新挂载信息
     sb->last_mount = time(NULL);
     sb->mount_count++;
@@ -77,6 +217,10 @@ int superblock_load(void) {
     printf("- 文件系统版本: %s\n", EXT2FS_VERSION);
     printf("- 创建时间: %s", ctime(&sb->created));
     printf("- 挂载次数: %u\n", sb->mount_count);
+    printf("- 格式版本: %u (功能: 0x%X)\n", sb->format_version, sb->feature_incompat);
+    if (sb->layout == EXT2FS_LAYOUT_PACKED) {
+        printf("- 磁盘布局: 紧密 (数据块未按主机页对齐，重新格式化可获得对齐布局)\n");
+    }
     
     return 0;
 }
@@ -96,6 +240,80 @@ int superblock_save(void) {
     return 0;
 }
 
+/**
+ * 按顺序提交文件系统状态
+ */
+int superblock_commit(void) {
+    // 1. 数据块先于引用它们的元数据落盘，崩溃后inode不会指向未写入的块
+    if (disk_barrier() != 0) {
+        return -1;
+    }
+
+    // 2. 间接块、位图、inode表、块组描述符和超级块 (统计信息由位图推出，彼此之间无需排序)
+    if (block_sync() != 0 || bitmap_save() != 0 || inode_save() != 0 ||
+        group_save() != 0 || superblock_save() != 0) {
+        printf("错误: 无法保存文件系统元数据\n");
+        return -1;
+    }
+
+    // 3. 元数据持久化后才向调用者报告成功
+    return disk_barrier();
+}
+
+/**
+ * 在线扩容
+ */
+int superblock_grow(uint32_t blocks) {
+    static pthread_mutex_t grow_lock = PTHREAD_MUTEX_INITIALIZER;
+    SuperBlock *sb = &g_fs.superblock;
+
+    pthread_mutex_lock(&grow_lock);
+
+    if (blocks <= sb->total_blocks || blocks > INT32_MAX) {
+        printf("错误: 新的块数必须大于当前块数且不超过%d (当前: %u, 请求: %u)\n",
+               INT32_MAX, sb->total_blocks, blocks);
+        pthread_mutex_unlock(&grow_lock);
+        return -1;
+    }
+
+    // 旧版镜像没有预留描述符项，只能补满最后一组
+    uint32_t group_count = (blocks + sb->blocks_per_group - 1) / sb->blocks_per_group;
+    if (group_count > (uint32_t)FS_GROUP_CAPACITY) {
+        printf("错误: 块组描述符表只预留了%d个组，最多扩大到%u块\n",
+               FS_GROUP_CAPACITY, (uint32_t)FS_GROUP_CAPACITY * sb->blocks_per_group);
+        pthread_mutex_unlock(&grow_lock);
+        return -1;
+    }
+
+    // 1. 先扩大镜像: 各组位置由预留的项数决定，不随组数变化，新组紧接在原最后一组之后
+    GroupDesc last;
+    group_layout(group_count - 1, &last);
+    off_t image_size = (off_t)last.data_blocks_offset +
+                       (off_t)(blocks - (group_count - 1) * sb->blocks_per_group) * sb->block_size;
+    if (disk_resize(image_size) != 0) {
+        pthread_mutex_unlock(&grow_lock);
+        return -1;
+    }
+
+    // 2. 在内存中追加新组，分配器随即可以使用新增的块和inode
+    uint32_t old_blocks = sb->total_blocks;
+    uint32_t old_inodes = sb->total_inodes;
+    group_grow(blocks);
+
+    // 3. 提交位图、inode表、块组描述符和超级块 (崩溃时旧的超级块仍描述扩容前的文件系统)
+    int result = superblock_commit();
+    pthread_mutex_unlock(&grow_lock);
+
+    if (result != 0) {
+        printf("错误: 扩容后无法提交文件系统元数据\n");
+        return -1;
+    }
+
+    printf("在线扩容完成: %u -> %u块, %u -> %u个inode\n",
+           old_blocks, blocks, old_inodes, sb->total_inodes);
+    return 0;
+}
+
 /**
  * 验证超级块的有效性
  */
@@ -116,7 +334,32 @@ bool superblock_is_valid(void) {
         return false;
     }
     
-    if (sb->block_size != BLOCK_SIZE || sb->inode_size != INODE_SIZE) {
+    if (sb->block_size < MIN_BLOCK_SIZE || sb->block_size > MAX_BLOCK_SIZE ||
+        (sb->block_size & (sb->block_size - 1)) != 0 || sb->inode_size != INODE_SIZE) {
+        return false;
+    }
+
+    // 块组划分须覆盖全部数据块和inode，且每组位图按字节对齐
+    if (sb->blocks_per_group == 0 || sb->blocks_per_group % 8 != 0 ||
+        sb->inodes_per_group == 0 || sb->inodes_per_group % 8 != 0 ||
+        sb->group_count != (sb->total_blocks + sb->blocks_per_group - 1) / sb->blocks_per_group ||
+        (uint64_t)sb->inodes_per_group * sb->group_count != sb->total_inodes) {
+        return false;
+    }
+
+    if (sb->layout != EXT2FS_LAYOUT_PACKED && sb->layout != EXT2FS_LAYOUT_ALIGNED) {
+        return false;
+    }
+
+    // 为扩容预留了描述符项时，扩满后的块编号和inode编号仍须能用int表示
+    if (sb->reserved_groups > sb->group_count &&
+        ((uint64_t)sb->reserved_groups * sb->blocks_per_group > INT32_MAX ||
+         (uint64_t)sb->reserved_groups * sb->inodes_per_group > INT32_MAX)) {
+        return false;
+    }
+
+    if (sb->group_desc_offset < sizeof(SuperBlock) ||
+        group_align(sb->group_desc_offset) != sb->group_desc_offset) {
         return false;
     }
     
@@ -127,31 +370,8 @@ bool superblock_is_valid(void) {
  * 更新超级块的统计信息
  */
 void superblock_update_stats(void) {
-    SuperBlock *sb = &g_fs.superblock;
-    
-    // 重新计算空闲inode和块的数量
-    uint32_t free_inodes = 0;
-    uint32_t free_blocks = 0;
-    
-    // 统计空闲inode
-    for (int i = 0; i < MAX_INODES; i++) {
-        if (!bitmap_test_bit(g_fs.inode_bitmap, i)) {
-            free_inodes++;
-        }
-    }
-    
-    // 统计空闲块
-    for (int i = 0; i < MAX_BLOCKS; i++) {
-        if (!bitmap_test_bit(g_fs.block_bitmap, i)) {
-            free_blocks++;
-        }
-    }
-    
-    sb->free_inodes = free_inodes;
-    sb->free_blocks = free_blocks;
-    
-    // 标记文件系统为脏
-    g_fs.is_dirty = true;
+    // 按位图重新统计各组的空闲计数，超级块中的总数为各组之和
+    group_update_stats();
 }
 
 /**
@@ -168,6 +388,13 @@ void superblock_print_info(void) {
     printf("空闲inode数: %u\n", sb->free_inodes);
     printf("块大小: %u 字节\n", sb->block_size);
     printf("inode大小: %u 字节\n", sb->inode_size);
+    printf("块组数: %u (每组%u块、%u个inode)\n",
+           sb->group_count, sb->blocks_per_group, sb->inodes_per_group);
+    printf("预留块组: %d (在线扩容上限 %u 块)\n",
+           FS_GROUP_CAPACITY, (uint32_t)FS_GROUP_CAPACITY * sb->blocks_per_group);
+    printf("磁盘布局: %s\n", sb->layout == EXT2FS_LAYOUT_ALIGNED ? "对齐" : "紧密");
+    printf("格式版本: %u (兼容功能 0x%X, 不兼容功能 0x%X, 只读兼容功能 0x%X)\n", sb->format_version,
+           sb->feature_compat, sb->feature_incompat, sb->feature_ro_compat);
     printf("创建时间: %s", ctime(&sb->created));
     printf("最后挂载: %s", ctime(&sb->last_mount));
     printf("挂载次数: %u\n", sb->mount_count);
@@ -15,6 +15,7 @@
 // 超级块相关常量
 // ============================================================================
 #define EXT2FS_MAGIC 0x53EF             // 文件系统魔数
+#define EXT2FS_MAGIC_UPGRADING 0x53EE   // 离线升级进行中的魔数 (升级中断的镜像不能挂载)
 #define SUPERBLOCK_OFFSET 0             // 超级块在磁盘中的偏移量
 
 // ============================================================================
@@ -22,13 +23,36 @@
 // ============================================================================
 
 /**
- * 初始化超级块 (格式化时使用)
+ * 设置文件系统几何参数 (格式化前使用，决定新建镜像的大小)
+ * @param blocks 数据块数量
+ * @param inodes inode数量
+ * @param block_size 数据块大小 (512到65536之间的2的幂)
+ * @return 成功返回0，参数无效返回负数
+ */
+int superblock_set_geometry(uint32_t blocks, uint32_t inodes, uint32_t block_size);
+
+/**
+ * 把格式版本、功能标志、磁盘布局和预留的块组描述符项设为当前版本的默认值
+ * (格式化和离线升级时使用，只修改超级块，不移动磁盘上的任何区域)
+ */
+void superblock_set_current_format(void);
+
+/**
+ * 计算当前几何参数下的镜像大小 (元数据区域 + 数据块区域)
+ * @return 镜像大小 (字节)
+ */
+off_t superblock_image_size(void);
+
+/**
+ * 初始化超级块 (格式化时使用，未设置几何参数时使用默认值)
  * @return 成功返回0，失败返回负数
  */
 int superblock_init(void);
 
 /**
  * 从磁盘加载超级块
+ * 格式版本高于当前版本或使用了不认识的不兼容 (或只读兼容) 功能时拒绝挂载；
+ * 版本0的镜像 (超级块之后的对齐空隙中没有这些字段) 就地写入当前的格式版本和功能标志
  * @return 成功返回0，失败返回负数
  */
 int superblock_load(void);
@@ -39,6 +63,22 @@ int superblock_load(void);
  */
 int superblock_save(void);
 
+/**
+ * 按顺序提交文件系统状态 (fsync和卸载时使用)
+ * 先以写屏障让已写入的数据块持久化，再写入位图、inode表、块组描述符和超级块并再次屏障，
+ * 整个提交最多刷新设备两次，没有新写入时不刷新
+ * @return 成功返回0，失败返回负数
+ */
+int superblock_commit(void);
+
+/**
+ * 在线扩容: 扩大镜像，把总块数增加到blocks并追加新的块组 (每组带来一组inode)，然后提交
+ * 新组数不能超过格式化时预留的块组描述符项数，旧版镜像只能补满最后一组
+ * @param blocks 新的总块数
+ * @return 成功返回0，失败返回负数
+ */
+int superblock_grow(uint32_t blocks);
+
 /**
  * 验证超级块的有效性
  * @return 有效返回true，无效返回false
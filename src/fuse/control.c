@@ -0,0 +1,241 @@
+/*
+ * ============================================================================
+ * 文件名: src/fuse/control.c
+ * 描述: 控制文件模块实现
+ * 功能: 根目录下的虚拟控制文件，读取时生成报告，写入时执行控制命令
+ * ============================================================================
+ */
+
+#include "control.h"
+#include "../core/iostat.h"
+#include "../core/disk.h"
+#include "../fs/superblock.h"
+#include <errno.h>
+#include <fcntl.h>
+
+// ============================================================================
+// 控制文件表
+// ============================================================================
+
+/**
+ * 控制文件描述
+ */
+typedef struct {
+    const char *path;                                   // 控制文件路径
+    size_t (*show)(char *buffer, size_t size);          // 生成读取内容
+    int (*store)(const char *buffer, size_t size);      // 执行写入的命令 (NULL表示只读)
+} control_file_t;
+
+/**
+ * 内容快照 (打开时生成，保存在fi->fh中)
+ */
+typedef struct {
+    size_t length;                      // 内容长度
+    char data[];                        // 内容
+} control_snapshot_t;
+
+/**
+ * /.iostat 写入 "reset" 清零统计
+ */
+static int control_iostat_store(const char *buffer, size_t size) {
+    if (size >= 5 && strncmp(buffer, "reset", 5) == 0) {
+        iostat_reset();
+        return 0;
+    }
+
+    return -EINVAL;
+}
+
+/**
+ * /.resize 读取当前几何参数和在线扩容的上限
+ */
+static size_t control_resize_show(char *buffer, size_t size) {
+    SuperBlock *sb = &g_fs.superblock;
+    int length = snprintf(buffer, size,
+                          "blocks: %u\n"
+                          "free_blocks: %u\n"
+                          "inodes: %u\n"
+                          "free_inodes: %u\n"
+                          "block_size: %u\n"
+                          "groups: %u\n"
+                          "reserved_groups: %d\n"
+                          "max_blocks: %u\n"
+                          "image_size: %ld\n",
+                          sb->total_blocks, sb->free_blocks, sb->total_inodes, sb->free_inodes,
+                          sb->block_size, sb->group_count, FS_GROUP_CAPACITY,
+                          (uint32_t)FS_GROUP_CAPACITY * sb->blocks_per_group, disk_get_size());
+    return length < 0 ? 0 : ((size_t)length < size ? (size_t)length : size - 1);
+}
+
+/**
+ * /.resize 写入新的总块数 ("<块数>") 或增加的块数 ("+<块数>") 在线扩容
+ */
+static int control_resize_store(const char *buffer, size_t size) {
+    char text[32];
+    if (size == 0 || size >= sizeof(text)) {
+        return -EINVAL;
+    }
+    memcpy(text, buffer, size);
+    text[size] = '\0';
+
+    bool relative = text[0] == '+';
+    char *end;
+    errno = 0;
+    unsigned long long value = strtoull(text + relative, &end, 10);
+    while (*end == '\n' || *end == ' ') {
+        end++;
+    }
+    if (errno != 0 || end == text + relative || *end != '\0') {
+        return -EINVAL;
+    }
+
+    if (relative) {
+        value += g_fs.superblock.total_blocks;
+    }
+    if (value > INT32_MAX) {
+        return -EFBIG;
+    }
+
+    return superblock_grow((uint32_t)value) == 0 ? 0 : -EIO;
+}
+
+static const control_file_t control_files[] = {
+    { "/.iostat", iostat_format, control_iostat_store },
+    { "/.resize", control_resize_show, control_resize_store },
+};
+
+// ============================================================================
+// 内部辅助函数
+// ============================================================================
+
+/**
+ * 按路径查找控制文件
+ */
+static const control_file_t *control_find(const char *path) {
+    for (size_t i = 0; i < sizeof(control_files) / sizeof(control_files[0]); i++) {
+        if (strcmp(path, control_files[i].path) == 0) {
+            return &control_files[i];
+        }
+    }
+
+    return NULL;
+}
+
+// ============================================================================
+// 控制文件函数实现
+// ============================================================================
+
+/**
+ * 检查路径是否为控制文件
+ */
+bool control_is_file(const char *path) {
+    return control_find(path) != NULL;
+}
+
+/**
+ * 获取控制文件属性
+ */
+int control_getattr(const char *path, struct stat *stbuf) {
+    const control_file_t *file = control_find(path);
+    if (!file) {
+        return -ENOENT;
+    }
+
+    memset(stbuf, 0, sizeof(struct stat));
+    stbuf->st_mode = S_IFREG | (file->store ? 0644 : 0444);
+    stbuf->st_nlink = 1;
+    stbuf->st_uid = getuid();
+    stbuf->st_gid = getgid();
+    stbuf->st_size = 0;                 // 内容动态生成，读取走direct_io不受大小限制
+    stbuf->st_atime = stbuf->st_mtime = stbuf->st_ctime = time(NULL);
+    return 0;
+}
+
+/**
+ * 打开控制文件
+ */
+int control_open(const char *path, struct fuse_file_info *fi) {
+    const control_file_t *file = control_find(path);
+    if (!file) {
+        return -ENOENT;
+    }
+
+    int mode = fi->flags & O_ACCMODE;
+    if (mode != O_RDONLY && !file->store) {
+        return -EACCES;
+    }
+
+    fi->direct_io = 1;
+    fi->fh = 0;
+    if (mode == O_WRONLY) {
+        return 0;
+    }
+
+    control_snapshot_t *snapshot = malloc(sizeof(control_snapshot_t) + CONTROL_BUFFER_SIZE);
+    if (!snapshot) {
+        return -ENOMEM;
+    }
+
+    snapshot->length = file->show(snapshot->data, CONTROL_BUFFER_SIZE);
+    fi->fh = (uint64_t)(uintptr_t)snapshot;
+    return 0;
+}
+
+/**
+ * 读取控制文件快照
+ */
+int control_read(const char *path, char *buf, size_t size, off_t offset,
+                 struct fuse_file_info *fi) {
+    (void) path;
+
+    control_snapshot_t *snapshot = (control_snapshot_t *)(uintptr_t)fi->fh;
+    if (!snapshot) {
+        return -EBADF;
+    }
+
+    if (offset >= (off_t)snapshot->length) {
+        return 0;
+    }
+    if (size > snapshot->length - offset) {
+        size = snapshot->length - offset;
+    }
+
+    memcpy(buf, snapshot->data + offset, size);
+    return size;
+}
+
+/**
+ * 写入控制文件
+ */
+int control_write(const char *path, const char *buf, size_t size, off_t offset,
+                  struct fuse_file_info *fi) {
+    (void) offset;
+    (void) fi;
+
+    const control_file_t *file = control_find(path);
+    if (!file || !file->store) {
+        return -EACCES;
+    }
+
+    int result = file->store(buf, size);
+    return result < 0 ? result : (int)size;
+}
+
+/**
+ * 截断控制文件
+ */
+int control_truncate(const char *path) {
+    const control_file_t *file = control_find(path);
+    return file && file->store ? 0 : -EACCES;
+}
+
+/**
+ * 关闭控制文件
+ */
+int control_release(const char *path, struct fuse_file_info *fi) {
+    (void) path;
+
+    free((control_snapshot_t *)(uintptr_t)fi->fh);
+    fi->fh = 0;
+    return 0;
+}
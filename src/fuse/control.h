@@ -0,0 +1,72 @@
+/*
+ * ============================================================================
+ * 文件名: src/fuse/control.h
+ * 描述: 控制文件模块头文件
+ * 功能: 根目录下的虚拟控制文件，用于在挂载期间查询和调整文件系统状态
+ * ============================================================================
+ */
+
+#ifndef FUSE_CONTROL_H
+#define FUSE_CONTROL_H
+
+#define FUSE_USE_VERSION 30
+#define _GNU_SOURCE
+
+#include <fuse.h>
+#include "../../include/ext2fs.h"
+
+// ============================================================================
+// 控制文件常量
+// ============================================================================
+#define CONTROL_BUFFER_SIZE (64 * 1024) // 控制文件读取内容的最大长度
+
+// ============================================================================
+// 控制文件函数
+// ============================================================================
+
+/**
+ * 检查路径是否为控制文件
+ * 控制文件不占用inode，不出现在目录列表中
+ * @param path 路径
+ * @return 是控制文件返回true
+ */
+bool control_is_file(const char *path);
+
+/**
+ * 获取控制文件属性
+ * @return 成功返回0，失败返回负的errno
+ */
+int control_getattr(const char *path, struct stat *stbuf);
+
+/**
+ * 打开控制文件，以读方式打开时生成内容快照
+ * @return 成功返回0，失败返回负的errno
+ */
+int control_open(const char *path, struct fuse_file_info *fi);
+
+/**
+ * 读取控制文件快照
+ * @return 读取的字节数，失败返回负的errno
+ */
+int control_read(const char *path, char *buf, size_t size, off_t offset,
+                 struct fuse_file_info *fi);
+
+/**
+ * 写入控制文件 (执行对应的控制命令)
+ * @return 写入的字节数，失败返回负的errno
+ */
+int control_write(const char *path, const char *buf, size_t size, off_t offset,
+                  struct fuse_file_info *fi);
+
+/**
+ * 截断控制文件 (shell重定向写入前会先截断，直接忽略)
+ * @return 成功返回0，只读控制文件返回负的errno
+ */
+int control_truncate(const char *path);
+
+/**
+ * 关闭控制文件，释放内容快照
+ */
+int control_release(const char *path, struct fuse_file_info *fi);
+
+#endif /* FUSE_CONTROL_H */
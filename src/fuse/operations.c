@@ -7,9 +7,12 @@
  */
 
 #include "operations.h"
+#include "control.h"
 #include "../fs/superblock.h"
+#include "../fs/group.h"
 #include "../fs/inode.h"
 #include "../fs/block.h"
+#include "../fs/fragment.h"
 #include "../fs/directory.h"
 #include "../fs/file.h"
 #include "../core/disk.h"
@@ -67,32 +70,15 @@ static int errno_to_fuse_error(ext2fs_error_t error) {
 }
 
 /**
- * 将权限模式转换为权限字符串
+ * 按调用者的身份和请求的权限设置新建inode的所有者和权限位
  */
-static void mode_to_permissions(mode_t mode, char *perms) {
-    strcpy(perms, "");
-    if (mode & S_IRUSR) strcat(perms, "r");
-    if (mode & S_IWUSR) strcat(perms, "w");
-    if (mode & S_IXUSR) strcat(perms, "x");
-}
-
-/**
- * 将权限字符串转换为权限模式
- */
-static mode_t permissions_to_mode(const char *perms, bool is_dir) {
-    mode_t mode = 0;
+static void set_creator(int inode_id, mode_t mode) {
+    struct fuse_context *ctx = fuse_get_context();
     
-    if (is_dir) {
-        mode |= S_IFDIR;
-    } else {
-        mode |= S_IFREG;
+    inode_set_mode(inode_id, mode & ~(ctx ? ctx->umask : 0));
+    if (ctx) {
+        inode_set_owner(inode_id, ctx->uid, ctx->gid);
     }
-    
-    if (strchr(perms, 'r')) mode |= S_IRUSR | S_IRGRP | S_IROTH;
-    if (strchr(perms, 'w')) mode |= S_IWUSR | S_IWGRP | S_IWOTH;
-    if (strchr(perms, 'x')) mode |= S_IXUSR | S_IXGRP | S_IXOTH;
-    
-    return mode;
 }
 
 // ============================================================================
@@ -103,6 +89,10 @@ static mode_t permissions_to_mode(const char *perms, bool is_dir) {
  * 获取文件属性
  */
 static int fuse_getattr(const char *path, struct stat *stbuf) {
+    if (control_is_file(path)) {
+        return control_getattr(path, stbuf);
+    }
+
     int inode_id = dir_resolve_path(path);
     if (inode_id == -1) {
         return -ENOENT;
@@ -124,7 +114,7 @@ static int fuse_readdir(const char *path, void *buf, fuse_fill_dir_t filler,
         return -ENOENT;
     }
 
-    if (!g_fs.inode_table[dir_inode].is_directory) {
+    if (!S_ISDIR(g_fs.inode_table[dir_inode].mode)) {
         return -ENOTDIR;
     }
 
@@ -133,7 +123,7 @@ static int fuse_readdir(const char *path, void *buf, fuse_fill_dir_t filler,
     filler(buf, "..", NULL, 0);
 
     // 添加子文件和子目录 (修复：避免目录自己列出自己)
-    for (int i = 0; i < MAX_INODES; i++) {
+    for (int i = 0; i < FS_TOTAL_INODES; i++) {
         if (inode_is_used(i) && g_fs.inode_table[i].parent_inode == dir_inode && i != dir_inode) {
             filler(buf, g_fs.inode_table[i].name, NULL, 0);
         }
@@ -146,12 +136,16 @@ static int fuse_readdir(const char *path, void *buf, fuse_fill_dir_t filler,
  * 打开文件
  */
 static int fuse_open(const char *path, struct fuse_file_info *fi) {
+    if (control_is_file(path)) {
+        return control_open(path, fi);
+    }
+
     int inode_id = dir_resolve_path(path);
     if (inode_id == -1) {
         return -ENOENT;
     }
     
-    if (g_fs.inode_table[inode_id].is_directory) {
+    if (S_ISDIR(g_fs.inode_table[inode_id].mode)) {
         return -EISDIR;
     }
     
@@ -164,17 +158,21 @@ static int fuse_open(const char *path, struct fuse_file_info *fi) {
  */
 static int fuse_read(const char *path, char *buf, size_t size, off_t offset,
                      struct fuse_file_info *fi) {
+    if (control_is_file(path)) {
+        return control_read(path, buf, size, offset, fi);
+    }
+
     int inode_id = dir_resolve_path(path);
     if (inode_id == -1) {
         return -ENOENT;
     }
     
-    int bytes_read = file_read(inode_id, buf, size, offset);
+    ssize_t bytes_read = file_read(inode_id, buf, size, offset);
     if (bytes_read < 0) {
         return -EIO;
     }
     
-    return bytes_read;
+    return (int)bytes_read;
 }
 
 /**
@@ -182,24 +180,34 @@ static int fuse_read(const char *path, char *buf, size_t size, off_t offset,
  */
 static int fuse_write(const char *path, const char *buf, size_t size,
                       off_t offset, struct fuse_file_info *fi) {
+    if (control_is_file(path)) {
+        return control_write(path, buf, size, offset, fi);
+    }
+
     int inode_id = dir_resolve_path(path);
     if (inode_id == -1) {
         return -ENOENT;
     }
     
-    int bytes_written = file_write(inode_id, buf, size, offset);
+    if (offset < 0 || offset > file_max_size() - (off_t)size) {
+        return -EFBIG;
+    }
+    
+    ssize_t bytes_written = file_write(inode_id, buf, size, offset);
     if (bytes_written < 0) {
         return -EIO;
     }
     
-    return bytes_written;
+    return (int)bytes_written;
 }
 
 /**
  * 创建文件
  */
 static int fuse_create(const char *path, mode_t mode, struct fuse_file_info *fi) {
-    (void) mode;  // 忽略权限模式，使用默认
+    if (control_is_file(path)) {
+        return -EEXIST;
+    }
     
     char filename[MAX_FILENAME];
     int parent_inode = parse_parent_path(path, filename);
@@ -213,6 +221,7 @@ static int fuse_create(const char *path, mode_t mode, struct fuse_file_info *fi)
         return -ENOSPC;
     }
     
+    set_creator(new_inode, mode);
     fi->fh = new_inode;
     return 0;
 }
@@ -221,7 +230,9 @@ static int fuse_create(const char *path, mode_t mode, struct fuse_file_info *fi)
  * 创建目录
  */
 static int fuse_mkdir(const char *path, mode_t mode) {
-    (void) mode;  // 忽略权限模式，使用默认
+    if (control_is_file(path)) {
+        return -EEXIST;
+    }
     
     char dirname[MAX_FILENAME];
     int parent_inode = parse_parent_path(path, dirname);
@@ -235,6 +246,7 @@ static int fuse_mkdir(const char *path, mode_t mode) {
         return -ENOSPC;
     }
     
+    set_creator(new_inode, mode);
     return 0;
 }
 
@@ -242,12 +254,16 @@ static int fuse_mkdir(const char *path, mode_t mode) {
  * 删除文件
  */
 static int fuse_unlink(const char *path) {
+    if (control_is_file(path)) {
+        return -EPERM;
+    }
+
     int inode_id = dir_resolve_path(path);
     if (inode_id == -1) {
         return -ENOENT;
     }
     
-    if (g_fs.inode_table[inode_id].is_directory) {
+    if (S_ISDIR(g_fs.inode_table[inode_id].mode)) {
         return -EISDIR;
     }
     
@@ -268,7 +284,7 @@ static int fuse_rmdir(const char *path) {
         return -ENOENT;
     }
     
-    if (!g_fs.inode_table[inode_id].is_directory) {
+    if (!S_ISDIR(g_fs.inode_table[inode_id].mode)) {
         return -ENOTDIR;
     }
     
@@ -305,7 +321,7 @@ static int fuse_rename(const char *from, const char *to) {
     }
     
     int result;
-    if (g_fs.inode_table[from_inode].is_directory) {
+    if (S_ISDIR(g_fs.inode_table[from_inode].mode)) {
         result = inode_rename(from_inode, new_name);
     } else {
         result = file_rename(from_inode, new_name);
@@ -327,11 +343,23 @@ static int fuse_chmod(const char *path, mode_t mode) {
         return -ENOENT;
     }
     
-    char perms[4];
-    mode_to_permissions(mode, perms);
+    if (inode_set_mode(inode_id, mode) == -1) {
+        return -EPERM;
+    }
     
-    int result = inode_set_permissions(inode_id, perms);
-    if (result == -1) {
+    return 0;
+}
+
+/**
+ * 修改文件所有者
+ */
+static int fuse_chown(const char *path, uid_t uid, gid_t gid) {
+    int inode_id = dir_resolve_path(path);
+    if (inode_id == -1) {
+        return -ENOENT;
+    }
+    
+    if (inode_set_owner(inode_id, uid, gid) == -1) {
         return -EPERM;
     }
     
@@ -342,11 +370,19 @@ static int fuse_chmod(const char *path, mode_t mode) {
  * 截断文件
  */
 static int fuse_truncate(const char *path, off_t size) {
+    if (control_is_file(path)) {
+        return control_truncate(path);
+    }
+
     int inode_id = dir_resolve_path(path);
     if (inode_id == -1) {
         return -ENOENT;
     }
     
+    if (size > file_max_size()) {
+        return -EFBIG;
+    }
+    
     int result = file_truncate(inode_id, size);
     if (result == -1) {
         return -EIO;
@@ -359,6 +395,10 @@ static int fuse_truncate(const char *path, off_t size) {
  * 更新文件时间
  */
 static int fuse_utimens(const char *path, const struct timespec ts[2]) {
+    if (control_is_file(path)) {
+        return 0;
+    }
+
     int inode_id = dir_resolve_path(path);
     if (inode_id == -1) {
         return -ENOENT;
@@ -383,8 +423,8 @@ static int fuse_statfs(const char *path, struct statvfs *stbuf) {
 
     memset(stbuf, 0, sizeof(struct statvfs));
 
-    stbuf->f_bsize = BLOCK_SIZE;
-    stbuf->f_frsize = BLOCK_SIZE;
+    stbuf->f_bsize = FS_BLOCK_SIZE;
+    stbuf->f_frsize = FS_BLOCK_SIZE;
     stbuf->f_blocks = g_fs.superblock.total_blocks;
     stbuf->f_bfree = g_fs.superblock.free_blocks;
     stbuf->f_bavail = g_fs.superblock.free_blocks;
@@ -403,17 +443,48 @@ static void *fuse_init(struct fuse_conn_info *conn) {
 
     printf("正在初始化模块化EXT2文件系统...\n");
 
-    // 检查是否为新文件系统
-    FILE *test_file = fopen(DISK_IMAGE, "rb");
-    bool is_new_fs = (test_file == NULL);
-    if (test_file) fclose(test_file);
+    // 选择磁盘后端 (指定条带成员或镜像副本时默认使用对应后端)
+    const char *backend = g_fs.options.backend;
+    if (!backend && g_fs.options.stripe) {
+        backend = "stripe";
+    } else if (!backend && g_fs.options.mirror) {
+        backend = "mirror";
+    }
+    if (backend && disk_set_backend(backend) != 0) {
+        printf("错误: 磁盘后端选择失败\n");
+        return NULL;
+    }
+
+    disk_set_io_uring(g_fs.options.io_uring);
+    disk_set_direct_io(g_fs.options.odirect);
+    disk_set_elevator(g_fs.options.elevator);
+    disk_set_stripe_size(g_fs.options.stripe_size > 0 ? g_fs.options.stripe_size : 0);
 
-    // 初始化磁盘I/O
-    if (disk_init(DISK_IMAGE) != 0) {
+    // 格式化参数决定新建镜像的大小；打开现有镜像时以超级块为准
+    uint32_t blocks = g_fs.options.blocks ? g_fs.options.blocks : DEFAULT_BLOCKS;
+    uint32_t inodes = g_fs.options.inodes ? g_fs.options.inodes : DEFAULT_INODES;
+    uint32_t block_size = g_fs.options.block_size ? g_fs.options.block_size : DEFAULT_BLOCK_SIZE;
+    if (superblock_set_geometry(blocks, inodes, block_size) != 0) {
+        printf("错误: 格式化参数无效\n");
+        return NULL;
+    }
+    disk_set_image_size(superblock_image_size());
+
+    // 初始化磁盘I/O (条带和镜像后端的镜像路径为成员列表)
+    const char *image = DISK_IMAGE;
+    if (g_fs.options.stripe) {
+        image = g_fs.options.stripe;
+    } else if (g_fs.options.mirror) {
+        image = g_fs.options.mirror;
+    }
+    if (disk_init(image) != 0) {
         printf("错误: 磁盘初始化失败\n");
         return NULL;
     }
 
+    // 检查是否为新文件系统 (新建的镜像或内存盘需要格式化)
+    bool is_new_fs = disk_is_new();
+
     if (is_new_fs) {
         printf("创建新的文件系统...\n");
 
@@ -441,11 +512,14 @@ static void *fuse_init(struct fuse_conn_info *conn) {
             return NULL;
         }
 
+        // 创建块组描述符表 (空闲计数按已初始化的位图统计)
+        if (group_init() != 0) {
+            printf("错误: 块组初始化失败\n");
+            return NULL;
+        }
+
         // 保存初始状态
-        superblock_save();
-        bitmap_save();
-        inode_save();
-        disk_sync();
+        superblock_commit();
 
         printf("文件系统格式化完成！\n");
     } else {
@@ -457,6 +531,18 @@ static void *fuse_init(struct fuse_conn_info *conn) {
             return NULL;
         }
 
+        if (g_fs.options.blocks || g_fs.options.inodes || g_fs.options.block_size) {
+            printf("提示: 镜像已存在，格式化参数被忽略 (块数: %u, inode数: %u, 块大小: %u)\n",
+                   g_fs.superblock.total_blocks, g_fs.superblock.total_inodes,
+                   g_fs.superblock.block_size);
+        }
+
+        // 加载块组描述符表
+        if (group_load() != 0) {
+            printf("错误: 块组描述符表加载失败\n");
+            return NULL;
+        }
+
         // 加载位图
         if (bitmap_load() != 0) {
             printf("错误: 位图加载失败\n");
@@ -469,6 +555,18 @@ static void *fuse_init(struct fuse_conn_info *conn) {
             return NULL;
         }
 
+        // 按inode表重建碎片块的槽位占用
+        if (fragment_load() != 0) {
+            printf("错误: 碎片块加载失败\n");
+            return NULL;
+        }
+
+        // 加载时就地更新过的元数据 (如版本0镜像写入的格式版本) 立即提交
+        if (g_fs.is_dirty && superblock_commit() != 0) {
+            printf("错误: 无法保存加载时更新的元数据\n");
+            return NULL;
+        }
+
         printf("文件系统加载完成！\n");
     }
 
@@ -491,27 +589,19 @@ static void fuse_cleanup(void *userdata) {
 
     if (g_fs.is_dirty) {
         printf("保存文件系统状态...\n");
-        superblock_save();
-        bitmap_save();
-        inode_save();
-        disk_sync();
+        superblock_commit();
     }
 
-    // 清理资源
-    if (g_fs.inode_table) {
-        free(g_fs.inode_table);
-        g_fs.inode_table = NULL;
-    }
+    // 输出本次挂载的I/O统计
+    disk_print_stats();
 
-    if (g_fs.inode_bitmap) {
-        free(g_fs.inode_bitmap);
-        g_fs.inode_bitmap = NULL;
-    }
+    // 清理资源 (预留的大小由超级块中的几何参数算出)
+    inode_cleanup();
+    bitmap_cleanup();
 
-    if (g_fs.block_bitmap) {
-        free(g_fs.block_bitmap);
-        g_fs.block_bitmap = NULL;
-    }
+    fragment_cleanup();
+    block_cleanup();
+    group_cleanup();
 
     disk_cleanup();
 
@@ -528,7 +618,7 @@ static int fuse_opendir(const char *path, struct fuse_file_info *fi) {
         return -ENOENT;
     }
 
-    if (!g_fs.inode_table[inode_id].is_directory) {
+    if (!S_ISDIR(g_fs.inode_table[inode_id].mode)) {
         return -ENOTDIR;
     }
 
@@ -537,6 +627,10 @@ static int fuse_opendir(const char *path, struct fuse_file_info *fi) {
 }
 
 static int fuse_release(const char *path, struct fuse_file_info *fi) {
+    if (control_is_file(path)) {
+        return control_release(path, fi);
+    }
+
     (void) path; (void) fi;
     return 0;
 }
@@ -550,10 +644,9 @@ static int fuse_fsync(const char *path, int isdatasync, struct fuse_file_info *f
     (void) path; (void) isdatasync; (void) fi;
 
     if (g_fs.is_dirty) {
-        superblock_save();
-        bitmap_save();
-        inode_save();
-        disk_sync();
+        if (superblock_commit() != 0) {
+            return -EIO;
+        }
         g_fs.is_dirty = false;
     }
 
@@ -576,6 +669,7 @@ struct fuse_operations fuse_operations = {
     .rmdir      = fuse_rmdir,
     .rename     = fuse_rename,
     .chmod      = fuse_chmod,
+    .chown      = fuse_chown,
     .truncate   = fuse_truncate,
     .utimens    = fuse_utimens,
     .statfs     = fuse_statfs,
@@ -86,6 +86,11 @@ static int fuse_rename(const char *from, const char *to);
  */
 static int fuse_chmod(const char *path, mode_t mode);
 
+/**
+ * 修改文件所有者
+ */
+static int fuse_chown(const char *path, uid_t uid, gid_t gid);
+
 /**
  * 截断文件
  */
@@ -146,14 +151,9 @@ static int parse_parent_path(const char *path, char *filename);
 static int errno_to_fuse_error(ext2fs_error_t error);
 
 /**
- * 将权限模式转换为权限字符串
- */
-static void mode_to_permissions(mode_t mode, char *perms);
-
-/**
- * 将权限字符串转换为权限模式
+ * 按调用者的身份和请求的权限设置新建inode的所有者和权限位
  */
-static mode_t permissions_to_mode(const char *perms, bool is_dir);
+static void set_creator(int inode_id, mode_t mode);
 
 // ============================================================================
 // 全局FUSE操作结构体
@@ -11,6 +11,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <time.h>
 #include <sys/time.h>
@@ -23,6 +24,25 @@
 // ============================================================================
 #define PROGRAM_NAME "ext2fs"
 
+// ============================================================================
+// 文件系统专用挂载选项
+// ============================================================================
+#define EXT2FS_OPT(templ, field) { templ, offsetof(MountOptions, field), 1 }
+
+static const struct fuse_opt ext2fs_opts[] = {
+    EXT2FS_OPT("backend=%s", backend),
+    EXT2FS_OPT("io_uring", io_uring),
+    EXT2FS_OPT("odirect", odirect),
+    EXT2FS_OPT("stripe=%s", stripe),
+    EXT2FS_OPT("stripe_size=%d", stripe_size),
+    EXT2FS_OPT("mirror=%s", mirror),
+    EXT2FS_OPT("elevator", elevator),
+    EXT2FS_OPT("blocks=%u", blocks),
+    EXT2FS_OPT("inodes=%u", inodes),
+    EXT2FS_OPT("block_size=%u", block_size),
+    FUSE_OPT_END
+};
+
 // ============================================================================
 // 帮助和版本信息
 // ============================================================================
@@ -45,6 +65,16 @@ static void show_usage(const char *progname) {
     printf("  ro                只读挂载\n");
     printf("  allow_other       允许其他用户访问\n");
     printf("  default_permissions 启用权限检查\n");
+    printf("  backend=NAME      磁盘后端: file (默认)、mmap、ram、stripe 或 mirror\n");
+    printf("  io_uring          启用io_uring批量异步I/O (不可用时回退到同步I/O)\n");
+    printf("  odirect           以O_DIRECT打开磁盘镜像，绕过主机页缓存\n");
+    printf("  stripe=A:B[:...]  把文件系统条带化到多个镜像文件 (RAID-0)\n");
+    printf("  stripe_size=N     条带大小 (字节，默认65536，512的整数倍)\n");
+    printf("  mirror=A:B[:...]  把文件系统镜像到多个镜像文件 (RAID-1)\n");
+    printf("  elevator          写入排队，同步时按偏移排序合并后提交\n");
+    printf("  blocks=N          格式化: 数据块数量 (默认1024，仅新建镜像时生效)\n");
+    printf("  inodes=N          格式化: inode数量 (默认128，仅新建镜像时生效)\n");
+    printf("  block_size=N      格式化: 块大小 (512到65536之间的2的幂，默认512)\n");
     printf("\n");
     printf("示例:\n");
     printf("  %s /tmp/myfs                    # 基本挂载\n", progname);
@@ -135,8 +165,16 @@ int main(int argc, char *argv[]) {
     printf("- 按 Ctrl+C 停止 (如果使用 -f 选项)\n");
     printf("\n");
     
+    // 解析文件系统专用选项，其余参数原样交给FUSE
+    struct fuse_args args = FUSE_ARGS_INIT(argc, argv);
+    if (fuse_opt_parse(&args, &g_fs.options, ext2fs_opts, NULL) != 0) {
+        printf("错误: 挂载选项解析失败\n");
+        return 1;
+    }
+    
     // 启动FUSE
-    int result = fuse_main(argc, argv, &fuse_operations, NULL);
+    int result = fuse_main(args.argc, args.argv, &fuse_operations, NULL);
+    fuse_opt_free_args(&args);
     
     if (result != 0) {
         printf("FUSE启动失败，错误码: %d\n", result);
@@ -0,0 +1,712 @@
+/*
+ * ============================================================================
+ * 文件名: src/tools/upgrade.c
+ * 描述: 离线升级工具
+ * 功能: 把旧版镜像就地升级为当前格式: 把不分块组的最早版本镜像划分为块组，转换旧版inode表，
+ *       预留块组描述符项，写入格式版本和功能标志 (镜像须未挂载)
+ * ============================================================================
+ */
+
+#include "../../include/ext2fs.h"
+#include "../fs/superblock.h"
+#include "../fs/group.h"
+#include "../core/disk.h"
+#include "../core/bitmap.h"
+#include "../core/bufpool.h"
+#include <stddef.h>
+
+// ============================================================================
+// 程序信息
+// ============================================================================
+#define PROGRAM_NAME "ext2fs-upgrade"
+#define UPGRADE_CHUNK_SIZE (1024 * 1024)    // 移动区域和转换inode表时每次读写的大小 (inode大小的倍数)
+
+FileSystem g_fs = {0};                      // 文件系统实例 (只使用超级块)
+
+// ============================================================================
+// 旧版inode格式 (与当前格式同为128字节，inode表的位置不变)
+// ============================================================================
+
+/**
+ * 版本1: 8个直接块指针，32位文件大小
+ */
+typedef struct {
+    char name[MAX_FILENAME];
+    uint16_t mode;
+    uint8_t version;
+    uint8_t flags;
+    uint32_t uid;
+    uint32_t gid;
+    uint32_t size;
+    uint32_t block_count;
+    uint32_t data_blocks[MAX_DIRECT_BLOCKS];
+    uint32_t parent_inode;
+    uint32_t link_count;
+    int64_t created;
+    int64_t modified;
+    int64_t accessed;
+    uint32_t reserved[4];
+} InodeV1;
+
+/**
+ * 版本2: 直接块加一级、二级、三级间接块 (或extent树)，32位文件大小
+ */
+typedef struct {
+    char name[MAX_FILENAME];
+    uint16_t mode;
+    uint8_t version;
+    uint8_t flags;
+    uint32_t uid;
+    uint32_t gid;
+    uint32_t size;
+    uint32_t block_count;
+    uint32_t data_blocks[INODE_BLOCK_POINTERS];
+    uint32_t parent_inode;
+    uint32_t link_count;
+    uint32_t reserved;
+    int64_t created;
+    int64_t modified;
+    int64_t accessed;
+} InodeV2;
+
+typedef char inode_v1_size_check[sizeof(InodeV1) == INODE_SIZE ? 1 : -1];
+typedef char inode_v2_size_check[sizeof(InodeV2) == INODE_SIZE ? 1 : -1];
+
+// ============================================================================
+// 不分块组的最早版本格式 (版本0)
+// 超级块记录各区域的偏移，其后依次为inode位图、数据块位图、inode表和数据块；
+// 结构按x86-64上的time_t和自然对齐写出，这里用定宽字段和显式填充还原
+// ============================================================================
+
+/**
+ * 版本0超级块 (72字节，inode_size字段记为64，实际inode为128字节)
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t total_blocks;
+    uint32_t free_blocks;
+    uint32_t total_inodes;
+    uint32_t free_inodes;
+    uint32_t block_size;
+    uint32_t inode_size;
+    uint32_t inode_bitmap_offset;
+    uint32_t block_bitmap_offset;
+    uint32_t inode_table_offset;
+    uint32_t data_blocks_offset;
+    uint32_t pad0;
+    int64_t created;
+    int64_t last_mount;
+    uint32_t mount_count;
+    uint32_t pad1;
+} SuperBlockV0;
+
+/**
+ * 版本0 inode: 权限字符串 ("rwx"的子集) 和目录标志，8个直接块指针
+ */
+typedef struct {
+    char name[MAX_FILENAME];
+    uint32_t owner_id;
+    char permissions[4];
+    uint32_t size;
+    uint32_t data_blocks[MAX_DIRECT_BLOCKS];
+    uint32_t block_count;
+    uint32_t pad0;
+    int64_t created;
+    int64_t modified;
+    int64_t accessed;
+    uint8_t is_directory;
+    uint8_t pad1[3];
+    uint32_t parent_inode;
+    uint32_t link_count;
+    uint32_t reserved[2];
+    uint32_t pad2;
+} InodeV0;
+
+#define SUPERBLOCK_V0_INODE_SIZE 64         // 版本0超级块中记录的inode大小
+
+typedef char superblock_v0_size_check[sizeof(SuperBlockV0) == 72 ? 1 : -1];
+typedef char inode_v0_size_check[sizeof(InodeV0) == INODE_SIZE ? 1 : -1];
+
+// ============================================================================
+// 内部辅助函数
+// ============================================================================
+
+/**
+ * 把磁盘上的一段区域移到新的偏移 (移向高处时由尾部向前复制，移向低处时由头部向后复制，
+ * 重叠部分的源数据在被覆盖前已读出)
+ */
+static int upgrade_move(off_t from, off_t to, off_t length, char *buffer) {
+    if (from == to || length == 0) {
+        return 0;
+    }
+
+    for (off_t done = 0; done < length; ) {
+        size_t n = length - done < UPGRADE_CHUNK_SIZE ? (size_t)(length - done) : UPGRADE_CHUNK_SIZE;
+        off_t pos = to > from ? length - done - (off_t)n : done;
+        if (disk_read(from + pos, buffer, n) < 0 || disk_write(to + pos, buffer, n) != 0) {
+            printf("错误: 无法移动区域 (偏移 %ld -> %ld)\n", from + pos, to + pos);
+            return -1;
+        }
+        done += n;
+    }
+    return 0;
+}
+
+/**
+ * 把磁盘上的一段区域写为0 (新布局中的对齐空隙原来可能存放着其他区域)
+ */
+static int upgrade_zero(off_t offset, off_t length, char *buffer) {
+    memset(buffer, 0, UPGRADE_CHUNK_SIZE);
+    for (off_t done = 0; done < length; ) {
+        size_t n = length - done < UPGRADE_CHUNK_SIZE ? (size_t)(length - done) : UPGRADE_CHUNK_SIZE;
+        if (disk_write(offset + done, buffer, n) != 0) {
+            return -1;
+        }
+        done += n;
+    }
+    return 0;
+}
+
+/**
+ * 把一个旧版inode就地转换为当前格式
+ * @return 转换了返回1，不需要转换 (空闲或已是当前格式) 返回0
+ */
+static int upgrade_convert_inode(Inode *inode) {
+    Inode result;
+
+    if (inode->version == 1) {
+        InodeV1 old;
+        memcpy(&old, inode, sizeof(old));
+        memset(&result, 0, sizeof(result));
+        memcpy(result.data_blocks, old.data_blocks, sizeof(old.data_blocks));
+        memcpy(result.name, old.name, sizeof(result.name));
+        result.mode = old.mode;
+        result.flags = 0;
+        result.uid = old.uid;
+        result.gid = old.gid;
+        result.size = old.size;
+        result.block_count = old.block_count;
+        result.parent_inode = old.parent_inode;
+        result.link_count = old.link_count;
+        result.created = old.created;
+        result.modified = old.modified;
+        result.accessed = old.accessed;
+    } else if (inode->version == 2) {
+        InodeV2 old;
+        memcpy(&old, inode, sizeof(old));
+        memset(&result, 0, sizeof(result));
+        memcpy(result.data_blocks, old.data_blocks, sizeof(old.data_blocks));
+        memcpy(result.name, old.name, sizeof(result.name));
+        result.mode = old.mode;
+        result.flags = old.flags;
+        result.uid = old.uid;
+        result.gid = old.gid;
+        result.size = old.size;
+        result.block_count = old.block_count;
+        result.parent_inode = old.parent_inode;
+        result.link_count = old.link_count;
+        result.created = old.created;
+        result.modified = old.modified;
+        result.accessed = old.accessed;
+    } else {
+        return 0;
+    }
+
+    result.version = INODE_VERSION;
+    *inode = result;
+    return 1;
+}
+
+/**
+ * 逐段读取一个块组的inode表，转换后写回
+ * @return 转换的inode数，失败返回-1
+ */
+static long upgrade_convert_inode_table(off_t offset, char *buffer) {
+    off_t length = (off_t)FS_INODES_PER_GROUP * sizeof(Inode);
+    long converted = 0;
+
+    for (off_t done = 0; done < length; ) {
+        size_t n = length - done < UPGRADE_CHUNK_SIZE ? (size_t)(length - done) : UPGRADE_CHUNK_SIZE;
+        if (disk_read(offset + done, buffer, n) < 0) {
+            return -1;
+        }
+
+        int changed = 0;
+        for (size_t i = 0; i < n / sizeof(Inode); i++) {
+            changed += upgrade_convert_inode((Inode *)buffer + i);
+        }
+        if (changed > 0 && disk_write(offset + done, buffer, n) != 0) {
+            return -1;
+        }
+
+        converted += changed;
+        done += n;
+    }
+    return converted;
+}
+
+/**
+ * 读取并检查版本0或当前版本的超级块
+ */
+static int upgrade_load_superblock(void) {
+    SuperBlock *sb = &g_fs.superblock;
+
+    if (disk_read(SUPERBLOCK_OFFSET, sb, sizeof(SuperBlock)) < 0) {
+        printf("错误: 无法读取超级块\n");
+        return -1;
+    }
+    if (sb->magic == EXT2FS_MAGIC_UPGRADING) {
+        printf("错误: 上次升级没有完成，请从备份恢复镜像后重新升级\n");
+        return -1;
+    }
+    // 已分块组但仍为紧密布局的旧版镜像 (超级块较短、记录64字节inode) 不在升级范围内
+    if (sb->magic == EXT2FS_MAGIC &&
+        (sb->inode_size != INODE_SIZE || sb->layout != EXT2FS_LAYOUT_ALIGNED)) {
+        printf("错误: 分块组的紧密布局旧版镜像 (inode大小记为%u字节) 无法就地升级，需要重新格式化\n",
+               sb->inode_size);
+        return -1;
+    }
+    if (sb->format_version > EXT2FS_FORMAT_VERSION) {
+        printf("错误: 镜像格式版本 %u 高于本程序支持的版本 %d\n",
+               sb->format_version, EXT2FS_FORMAT_VERSION);
+        return -1;
+    }
+    if (!superblock_is_valid()) {
+        printf("错误: 超级块无效 (不分块组的旧版镜像无法就地升级)\n");
+        return -1;
+    }
+    if (superblock_image_size() > disk_get_size()) {
+        printf("错误: 镜像小于超级块描述的大小\n");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * 读取块组描述符表并检查各组区域的位置 (按旧的几何参数)
+ */
+static GroupDesc *upgrade_load_groups(void) {
+    SuperBlock *sb = &g_fs.superblock;
+    GroupDesc *groups = calloc(FS_GROUP_COUNT, sizeof(GroupDesc));
+    if (!groups) {
+        return NULL;
+    }
+
+    if (disk_read(sb->group_desc_offset, groups, FS_GROUP_COUNT * sizeof(GroupDesc)) < 0) {
+        free(groups);
+        return NULL;
+    }
+
+    for (int g = 0; g < FS_GROUP_COUNT; g++) {
+        GroupDesc expected;
+        group_layout(g, &expected);
+        if (groups[g].block_bitmap_offset != expected.block_bitmap_offset ||
+            groups[g].data_blocks_offset != expected.data_blocks_offset) {
+            printf("错误: 块组%d的描述符无效\n", g);
+            free(groups);
+            return NULL;
+        }
+    }
+    return groups;
+}
+
+/**
+ * 由后向前移动各块组的区域到新布局中的位置
+ * 新布局中每个区域的偏移都不小于原来的偏移，按偏移从高到低处理时目标不会覆盖尚未移动的源数据
+ */
+static int upgrade_move_groups(const GroupDesc *old_groups, const GroupDesc *new_groups,
+                               off_t image_end, char *buffer) {
+    off_t lengths[4] = {
+        BITMAP_BYTES(FS_BLOCKS_PER_GROUP),
+        BITMAP_BYTES(FS_INODES_PER_GROUP),
+        (off_t)FS_INODES_PER_GROUP * sizeof(Inode),
+        0
+    };
+
+    for (int g = FS_GROUP_COUNT - 1; g >= 0; g--) {
+        const GroupDesc *o = &old_groups[g];
+        const GroupDesc *n = &new_groups[g];
+        off_t from[4] = { o->block_bitmap_offset, o->inode_bitmap_offset,
+                          o->inode_table_offset, o->data_blocks_offset };
+        off_t to[4] = { n->block_bitmap_offset, n->inode_bitmap_offset,
+                        n->inode_table_offset, n->data_blocks_offset };
+        off_t next = g + 1 < FS_GROUP_COUNT ? (off_t)new_groups[g + 1].block_bitmap_offset : image_end;
+        lengths[3] = (off_t)group_block_count(g) * FS_BLOCK_SIZE;
+
+        // 依次移动数据块、inode表、inode位图、数据块位图，并清零各区域之后的对齐空隙
+        for (int r = 3; r >= 0; r--) {
+            off_t end = r < 3 ? to[r + 1] : next;
+            if (upgrade_move(from[r], to[r], lengths[r], buffer) != 0 ||
+                upgrade_zero(to[r] + lengths[r], end - to[r] - lengths[r], buffer) != 0) {
+                return -1;
+            }
+        }
+
+        if (g % 64 == 0) {
+            printf("已移动块组 %d-%d\n", g, FS_GROUP_COUNT - 1);
+        }
+    }
+    return 0;
+}
+
+/**
+ * 读取超级块并判断是否为不分块组的版本0镜像 (各区域按版本0的规则紧密排列)
+ */
+static bool upgrade_is_v0(SuperBlockV0 *old) {
+    if (disk_read(SUPERBLOCK_OFFSET, old, sizeof(*old)) < 0) {
+        return false;
+    }
+
+    uint64_t inode_table_end = old->inode_table_offset + (uint64_t)old->total_inodes * sizeof(InodeV0);
+    return old->magic == EXT2FS_MAGIC && old->inode_size == SUPERBLOCK_V0_INODE_SIZE &&
+           old->inode_bitmap_offset == sizeof(SuperBlockV0) &&
+           old->block_bitmap_offset == old->inode_bitmap_offset + BITMAP_BYTES(old->total_inodes) &&
+           old->inode_table_offset == old->block_bitmap_offset + BITMAP_BYTES(old->total_blocks) &&
+           old->data_blocks_offset == inode_table_end;
+}
+
+/**
+ * 把一个版本0 inode转换为当前格式 (权限字符串按原来的规则展开到所有者、组和其他用户)
+ */
+static void upgrade_convert_v0_inode(const InodeV0 *old, Inode *inode) {
+    memset(inode, 0, sizeof(*inode));
+    memcpy(inode->name, old->name, sizeof(inode->name));
+    inode->name[MAX_FILENAME - 1] = '\0';
+
+    uint16_t mode = old->is_directory ? S_IFDIR : S_IFREG;
+    if (memchr(old->permissions, 'r', sizeof(old->permissions))) {
+        mode |= S_IRUSR | S_IRGRP | S_IROTH;
+    }
+    if (memchr(old->permissions, 'w', sizeof(old->permissions))) {
+        mode |= S_IWUSR | S_IWGRP | S_IWOTH;
+    }
+    if (memchr(old->permissions, 'x', sizeof(old->permissions))) {
+        mode |= S_IXUSR | S_IXGRP | S_IXOTH;
+    }
+
+    inode->mode = mode;
+    inode->version = INODE_VERSION;
+    inode->uid = old->owner_id;
+    inode->size = old->size;
+    inode->block_count = old->block_count;
+    memcpy(inode->data_blocks, old->data_blocks, sizeof(old->data_blocks));
+    inode->parent_inode = old->parent_inode;
+    inode->link_count = old->link_count;
+    inode->created = old->created;
+    inode->modified = old->modified;
+    inode->accessed = old->accessed;
+}
+
+/**
+ * 把版本0镜像划分为块组并转换为当前格式
+ * 位图和inode表先读入内存；数据块按组移到新位置 (新位置比原位置高的组由后向前处理，
+ * 低的组由前向后处理，目标都不会覆盖尚未移动的源数据)，最后写入各组的元数据和超级块
+ */
+static int upgrade_v0_image(const SuperBlockV0 *old) {
+    SuperBlock *sb = &g_fs.superblock;
+    off_t old_end = (off_t)old->data_blocks_offset + (off_t)old->total_blocks * old->block_size;
+    if (old_end > disk_get_size()) {
+        printf("错误: 镜像小于超级块描述的大小\n");
+        return -1;
+    }
+
+    // 按原来的块数、inode数和块大小划分块组 (每组inode数向上取整，多出的inode为空闲)
+    memset(sb, 0, sizeof(*sb));
+    if (superblock_set_geometry(old->total_blocks, old->total_inodes, old->block_size) != 0) {
+        return -1;
+    }
+    sb->created = old->created;
+    sb->last_mount = old->last_mount;
+    sb->mount_count = old->mount_count;
+
+    size_t block_bits = (size_t)FS_GROUP_COUNT * FS_BLOCKS_PER_GROUP;
+    char *inode_bitmap = calloc(BITMAP_BYTES(FS_TOTAL_INODES), 1);
+    char *block_bitmap = calloc(BITMAP_BYTES(block_bits), 1);
+    InodeV0 *old_table = malloc((size_t)old->total_inodes * sizeof(InodeV0));
+    Inode *table = calloc(FS_TOTAL_INODES, sizeof(Inode));
+    GroupDesc *groups = calloc(FS_GROUP_COUNT, sizeof(GroupDesc));
+    char *buffer = bufpool_get(UPGRADE_CHUNK_SIZE);
+    int status = -1;
+    if (!inode_bitmap || !block_bitmap || !old_table || !table || !groups || !buffer) {
+        printf("错误: 内存不足\n");
+        goto out;
+    }
+
+    if (disk_read(old->inode_bitmap_offset, inode_bitmap, BITMAP_BYTES(old->total_inodes)) < 0 ||
+        disk_read(old->block_bitmap_offset, block_bitmap, BITMAP_BYTES(old->total_blocks)) < 0 ||
+        disk_read(old->inode_table_offset, old_table, (size_t)old->total_inodes * sizeof(InodeV0)) < 0) {
+        printf("错误: 无法读取版本0镜像的位图和inode表\n");
+        goto out;
+    }
+
+    // 在内存中转换inode表，并把最后一组中超出总块数的位标记为已使用
+    long converted = 0;
+    for (uint32_t i = 0; i < old->total_inodes; i++) {
+        if (bitmap_test_bit(inode_bitmap, i)) {
+            upgrade_convert_v0_inode(&old_table[i], &table[i]);
+            converted++;
+        }
+    }
+    for (size_t b = FS_TOTAL_BLOCKS; b < block_bits; b++) {
+        bitmap_set_bit(block_bitmap, (int)b);
+    }
+
+    sb->free_blocks = 0;
+    sb->free_inodes = 0;
+    for (int g = 0; g < FS_GROUP_COUNT; g++) {
+        group_layout(g, &groups[g]);
+        groups[g].free_blocks = bitmap_count_free_bits(block_bitmap + (size_t)g * FS_BLOCKS_PER_GROUP / 8,
+                                                       FS_BLOCKS_PER_GROUP);
+        groups[g].free_inodes = bitmap_count_free_bits(inode_bitmap + (size_t)g * FS_INODES_PER_GROUP / 8,
+                                                       FS_INODES_PER_GROUP);
+        sb->free_blocks += groups[g].free_blocks;
+        sb->free_inodes += groups[g].free_inodes;
+    }
+    off_t image_size = superblock_image_size();
+
+    printf("升级计划: 不分块组的版本0镜像 -> 格式版本 %d, %d个块组 (每组%d块、%d个inode), 镜像大小 %ld 字节\n",
+           EXT2FS_FORMAT_VERSION, FS_GROUP_COUNT, FS_BLOCKS_PER_GROUP, FS_INODES_PER_GROUP, image_size);
+
+    // 1. 先把魔数改为升级中并落盘，中途失败或中断的镜像不会被当作有效的文件系统挂载
+    uint32_t magic = EXT2FS_MAGIC_UPGRADING;
+    if (disk_write(SUPERBLOCK_OFFSET + offsetof(SuperBlockV0, magic), &magic, sizeof(magic)) != 0 ||
+        disk_sync() != 0) {
+        goto out;
+    }
+    if (image_size > disk_get_size() && disk_resize(image_size) != 0) {
+        goto out;
+    }
+
+    // 2. 移动数据块: 新位置减原位置随组号递增，先由后向前处理上移的组，再由前向后处理下移的组
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < FS_GROUP_COUNT; i++) {
+            int g = pass == 0 ? FS_GROUP_COUNT - 1 - i : i;
+            off_t from = old->data_blocks_offset + (off_t)g * FS_BLOCKS_PER_GROUP * FS_BLOCK_SIZE;
+            off_t to = groups[g].data_blocks_offset;
+            if ((pass == 0) != (to > from)) {
+                continue;
+            }
+            if (upgrade_move(from, to, (off_t)group_block_count(g) * FS_BLOCK_SIZE, buffer) != 0) {
+                goto out;
+            }
+        }
+    }
+
+    // 3. 清零元数据区域和对齐空隙 (原来可能存放着旧的元数据或数据)，写入各组的位图和inode表
+    if (upgrade_zero(sizeof(SuperBlock), groups[0].block_bitmap_offset - sizeof(SuperBlock), buffer) != 0) {
+        goto out;
+    }
+    for (int g = 0; g < FS_GROUP_COUNT; g++) {
+        const GroupDesc *gd = &groups[g];
+        off_t data_end = gd->data_blocks_offset + (off_t)group_block_count(g) * FS_BLOCK_SIZE;
+        off_t next = g + 1 < FS_GROUP_COUNT ? (off_t)groups[g + 1].block_bitmap_offset : image_size;
+        if (upgrade_zero(gd->block_bitmap_offset, gd->data_blocks_offset - gd->block_bitmap_offset,
+                         buffer) != 0 ||
+            upgrade_zero(data_end, next - data_end, buffer) != 0 ||
+            disk_write(gd->block_bitmap_offset, block_bitmap + (size_t)g * FS_BLOCKS_PER_GROUP / 8,
+                       BITMAP_BYTES(FS_BLOCKS_PER_GROUP)) != 0 ||
+            disk_write(gd->inode_bitmap_offset, inode_bitmap + (size_t)g * FS_INODES_PER_GROUP / 8,
+                       BITMAP_BYTES(FS_INODES_PER_GROUP)) != 0 ||
+            disk_write(gd->inode_table_offset, &table[(size_t)g * FS_INODES_PER_GROUP],
+                       (size_t)FS_INODES_PER_GROUP * sizeof(Inode)) != 0) {
+            printf("错误: 无法写入块组%d的元数据\n", g);
+            goto out;
+        }
+    }
+    if (disk_write(sb->group_desc_offset, groups, FS_GROUP_COUNT * sizeof(GroupDesc)) != 0 ||
+        disk_sync() != 0) {
+        goto out;
+    }
+
+    // 4. 所有区域落盘后才写入当前版本的超级块，恢复魔数
+    sb->magic = EXT2FS_MAGIC;
+    if (superblock_save() != 0 || disk_sync() != 0) {
+        goto out;
+    }
+
+    printf("升级完成: 转换了%ld个inode，镜像大小 %ld 字节\n", converted, disk_get_size());
+    status = 0;
+
+out:
+    if (status != 0 && sb->magic != EXT2FS_MAGIC) {
+        printf("错误: 升级失败，镜像可能已标记为升级未完成，请从备份恢复\n");
+    }
+    bufpool_put(buffer, UPGRADE_CHUNK_SIZE);
+    free(groups);
+    free(table);
+    free(old_table);
+    free(block_bitmap);
+    free(inode_bitmap);
+    return status;
+}
+
+/**
+ * 把镜像升级为当前格式
+ */
+static int upgrade_image(void) {
+    SuperBlock *sb = &g_fs.superblock;
+
+    // 不分块组的版本0镜像整体转换
+    SuperBlockV0 old_v0;
+    if (upgrade_is_v0(&old_v0)) {
+        return upgrade_v0_image(&old_v0);
+    }
+
+    if (upgrade_load_superblock() != 0) {
+        return -1;
+    }
+    SuperBlock old_sb = *sb;
+
+    // 根目录inode记录了inode表的格式版本
+    GroupDesc first;
+    group_layout(0, &first);
+    Inode root;
+    if (disk_read(first.inode_table_offset, &root, sizeof(root)) < 0) {
+        printf("错误: 无法读取根目录inode\n");
+        return -1;
+    }
+    if (root.version == 0 || root.version > INODE_VERSION) {
+        printf("错误: 不支持的inode格式版本 %u\n", root.version);
+        return -1;
+    }
+
+    GroupDesc *old_groups = upgrade_load_groups();
+    if (!old_groups) {
+        printf("错误: 无法读取块组描述符表\n");
+        return -1;
+    }
+    int old_capacity = FS_GROUP_CAPACITY;
+
+    // 按当前格式计算新的布局
+    superblock_set_current_format();
+    bool move = sb->group_desc_offset != old_sb.group_desc_offset || FS_GROUP_CAPACITY != old_capacity;
+    bool convert = root.version < INODE_VERSION;
+    if (!move && !convert && old_sb.format_version == EXT2FS_FORMAT_VERSION) {
+        printf("镜像已是当前格式 (版本 %d)，无需升级\n", EXT2FS_FORMAT_VERSION);
+        free(old_groups);
+        return 0;
+    }
+
+    GroupDesc *new_groups = calloc(FS_GROUP_CAPACITY, sizeof(GroupDesc));
+    char *buffer = bufpool_get(UPGRADE_CHUNK_SIZE);
+    if (!new_groups || !buffer) {
+        printf("错误: 内存不足\n");
+        free(old_groups);
+        free(new_groups);
+        bufpool_put(buffer, UPGRADE_CHUNK_SIZE);
+        return -1;
+    }
+    for (int g = 0; g < FS_GROUP_COUNT; g++) {
+        group_layout(g, &new_groups[g]);
+        new_groups[g].free_blocks = old_groups[g].free_blocks;
+        new_groups[g].free_inodes = old_groups[g].free_inodes;
+    }
+    off_t image_size = superblock_image_size();
+
+    printf("升级计划: 格式版本 %u -> %d, inode格式 %u -> %d, 预留块组 %d -> %d\n",
+           old_sb.format_version, EXT2FS_FORMAT_VERSION, root.version, INODE_VERSION,
+           old_capacity, FS_GROUP_CAPACITY);
+
+    // 1. 先把魔数改为升级中并落盘，中途失败或中断的镜像不会被当作有效的文件系统挂载
+    uint32_t magic = EXT2FS_MAGIC_UPGRADING;
+    int status = -1;
+    if (disk_write(SUPERBLOCK_OFFSET + offsetof(SuperBlock, magic), &magic, sizeof(magic)) != 0 ||
+        disk_sync() != 0) {
+        goto out;
+    }
+
+    // 2. 扩大镜像，由后向前把各组移到新位置
+    if (move && (disk_resize(image_size) != 0 ||
+                 upgrade_move_groups(old_groups, new_groups, image_size, buffer) != 0)) {
+        goto out;
+    }
+
+    // 3. 转换inode表
+    long converted = 0;
+    for (int g = 0; g < FS_GROUP_COUNT && convert; g++) {
+        long n = upgrade_convert_inode_table(new_groups[g].inode_table_offset, buffer);
+        if (n < 0) {
+            printf("错误: 无法转换块组%d的inode表\n", g);
+            goto out;
+        }
+        converted += n;
+    }
+
+    // 4. 清零超级块与第一组之间的区域 (原来的描述符表和组0可能在这里)，写入新的描述符表
+    if (move && upgrade_zero(sizeof(SuperBlock), new_groups[0].block_bitmap_offset - sizeof(SuperBlock),
+                             buffer) != 0) {
+        goto out;
+    }
+    if (disk_write(sb->group_desc_offset, new_groups, FS_GROUP_COUNT * sizeof(GroupDesc)) != 0 ||
+        disk_sync() != 0) {
+        goto out;
+    }
+
+    // 5. 所有区域落盘后才写入当前版本的超级块，恢复魔数
+    sb->magic = EXT2FS_MAGIC;
+    if (superblock_save() != 0 || disk_sync() != 0) {
+        goto out;
+    }
+
+    printf("升级完成: 转换了%ld个inode，镜像大小 %ld 字节\n", converted, disk_get_size());
+    status = 0;
+
+out:
+    if (status != 0) {
+        printf("错误: 升级失败，镜像已标记为升级未完成，请从备份恢复\n");
+    }
+    bufpool_put(buffer, UPGRADE_CHUNK_SIZE);
+    free(new_groups);
+    free(old_groups);
+    return status;
+}
+
+// ============================================================================
+// 主函数
+// ============================================================================
+
+static void show_usage(const char *progname) {
+    printf("用法: %s [-b 后端] <镜像>\n", progname);
+    printf("\n");
+    printf("把旧版镜像就地升级为当前格式 (版本 %d):\n", EXT2FS_FORMAT_VERSION);
+    printf("  - 把不分块组的最早版本镜像按原有的块数、inode数和块大小划分块组并整体转换\n");
+    printf("  - 把版本1、2的inode表转换为版本%d\n", INODE_VERSION);
+    printf("  - 为在线扩容预留块组描述符项 (需要移动各组的数据)\n");
+    printf("  - 写入格式版本和功能标志\n");
+    printf("\n");
+    printf("选项:\n");
+    printf("  -b 后端     磁盘后端 (file/mmap/stripe/mirror，默认file)；\n");
+    printf("              stripe和mirror的镜像为以':'分隔的成员列表\n");
+    printf("  -h          显示此帮助信息\n");
+    printf("\n");
+    printf("镜像须未挂载。升级中断后镜像不能挂载，请先备份。\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *backend = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "b:h")) != -1) {
+        if (opt == 'b') {
+            backend = optarg;
+        } else {
+            show_usage(PROGRAM_NAME);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind != argc - 1) {
+        show_usage(PROGRAM_NAME);
+        return 1;
+    }
+
+    if (backend && disk_set_backend(backend) != 0) {
+        return 1;
+    }
+    if (disk_open(argv[optind]) != 0) {
+        printf("错误: 无法打开镜像 %s\n", argv[optind]);
+        return 1;
+    }
+
+    int status = upgrade_image();
+    disk_cleanup();
+    return status == 0 ? 0 : 1;
+}